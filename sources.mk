@@ -7,13 +7,31 @@ CPP_SOURCES := \
     src/system/fs.cpp \
     src/system/logger.cpp \
     src/system/config.cpp \
+    src/system/watcher.cpp \
     src/utils/hash.cpp \
+    src/utils/sha256.cpp \
     src/utils/path.cpp \
     src/utils/git.cpp \
     src/utils/zip.cpp \
+    src/utils/http.cpp \
+    src/utils/json_records.cpp \
     src/utils/liner.cpp \
+    src/utils/parallel.cpp \
+    src/utils/mapped_file.cpp \
+    src/utils/file_stream.cpp \
+    src/utils/chunker.cpp \
     src/core/types.cpp \
     src/core/repo.cpp \
+    src/core/index_snapshot.cpp \
+    src/core/index_json.cpp \
+    src/core/index_journal.cpp \
+    src/core/item_index.cpp \
+    src/core/hash_cache.cpp \
+    src/core/object_store.cpp \
+    src/core/merkle.cpp \
+    src/core/chunk_manifest.cpp \
+    src/core/asset_catalog.cpp \
+    src/core/pull.cpp \
     src/cli/cli.cpp \
 
 
@@ -26,11 +44,29 @@ HEADER_FILES := \
     src/system/fs.h \
     src/system/logger.h \
     src/system/config.h \
+    src/system/watcher.h \
     src/utils/hash.h \
+    src/utils/sha256.h \
     src/utils/path.h \
     src/utils/git.h \
+    src/utils/http.h \
+    src/utils/json_records.h \
+    src/utils/mapped_file.h \
+    src/utils/file_stream.h \
+    src/utils/chunker.h \
+    src/utils/parallel.h \
     src/core/types.h \
     src/core/repo.h \
+    src/core/index_snapshot.h \
+    src/core/index_json.h \
+    src/core/index_journal.h \
+    src/core/item_index.h \
+    src/core/hash_cache.h \
+    src/core/object_store.h \
+    src/core/merkle.h \
+    src/core/chunk_manifest.h \
+    src/core/asset_catalog.h \
+    src/core/pull.h \
     src/cli/cli.h \
 
 
@@ -2,18 +2,29 @@
 #include "../system/logger.h"
 #include "../system/fs.h"
 #include "../core/repo.h"
+#include "../core/pull.h"
 #include "../system/config.h"
 #include "../utils/path.h"
 #include "../utils/hash.h"
+#include "../utils/sha256.h"
 #include <argparse/argparse.hpp>
 #include "../utils/liner.h"
 #include "../utils/zip.h"
+#include "../utils/http.h"
+#include "../utils/parallel.h"
+#include "../utils/json_records.h"
+#include "../system/watcher.h"
 #include <nlohmann/json.hpp>
 #include <iostream>
 #include <sstream>
 #include <filesystem>
 #include <fstream>
 #include <cstdlib>
+#include <csignal>
+#include <chrono>
+#include <set>
+#include <mutex>
+#include <map>
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -48,6 +59,22 @@ static std::vector<std::string> parseArgs(const std::string& line) {
     return out;
 }
 
+// Logs archive extraction in 10% steps
+static ziputil::ProgressFn extractionProgress() {
+    auto lastStep = std::make_shared<std::size_t>(0);
+    return [lastStep](std::size_t done, std::size_t total, uint64_t bytes) {
+        std::size_t step = total ? done * 10 / total : 10;
+        if (step == *lastStep) return;
+        *lastStep = step;
+        logger::info("Extracted " + std::to_string(done) + "/" + std::to_string(total) + " files (" +
+                     std::to_string(bytes / (1024 * 1024)) + " MiB)");
+    };
+}
+
+// Set by SIGINT/SIGTERM while `watch` runs
+static volatile std::sig_atomic_t watchStopRequested = 0;
+static void onWatchSignal(int) { watchStopRequested = 1; }
+
 
 int runCommand(int argc, char** argv) {
     // Pre-scan for --verbose anywhere and strip it so subcommands don't see it as unknown
@@ -102,12 +129,44 @@ int runCommand(int argc, char** argv) {
     program.add_subparser(list_parser);
 
     argparse::ArgumentParser index_parser("index");
+    index_parser.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
     program.add_subparser(index_parser);
 
     // Verify repo
     argparse::ArgumentParser verify_parser("verify");
+    verify_parser.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
+    verify_parser.add_argument("--quick").help("trust cached digests of unchanged files (default)").default_value(false).implicit_value(true);
+    verify_parser.add_argument("--deep").help("rehash every file, ignoring the hash cache").default_value(false).implicit_value(true);
     program.add_subparser(verify_parser);
 
+    argparse::ArgumentParser compact_parser("compact");
+    program.add_subparser(compact_parser);
+
+    // Keep the index in sync with file changes until interrupted
+    argparse::ArgumentParser watch_parser("watch");
+    watch_parser.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
+    watch_parser.add_argument("--debounce").help("milliseconds without events before changes are applied").default_value(500).scan<'i', int>();
+    program.add_subparser(watch_parser);
+
+    // Content-addressable object store
+    argparse::ArgumentParser dedup_parser("dedup");
+    dedup_parser.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
+    program.add_subparser(dedup_parser);
+
+    argparse::ArgumentParser gc_parser("gc");
+    program.add_subparser(gc_parser);
+
+    // Search files inside pk3 items
+    argparse::ArgumentParser find_asset_parser("find-asset");
+    find_asset_parser.add_argument("path").help("asset path or part of it, e.g. maps/q3dm17.bsp (case-insensitive)");
+    find_asset_parser.add_argument("--jobs").help("threads for cataloging new packs (0 = one per CPU core)").default_value(0).scan<'i', int>();
+    program.add_subparser(find_asset_parser);
+
+    // SHA-256 backend throughput
+    argparse::ArgumentParser hash_bench_parser("hash-bench");
+    hash_bench_parser.add_argument("--size").help("MiB of data to hash per backend").default_value(256).scan<'i', int>();
+    program.add_subparser(hash_bench_parser);
+
     argparse::ArgumentParser remove_parser("remove");
     remove_parser.add_argument("id").help("item ID to remove");
     program.add_subparser(remove_parser);
@@ -138,6 +197,7 @@ int runCommand(int argc, char** argv) {
     program.add_subparser(gh_login_parser);
 
     argparse::ArgumentParser gh_list_parser("gh-list");
+    gh_list_parser.add_argument("--jobs").help("concurrent page fetches and compatibility probes (0 = 16)").default_value(0).scan<'i', int>();
     program.add_subparser(gh_list_parser);
 
     // Token check
@@ -148,6 +208,9 @@ int runCommand(int argc, char** argv) {
     argparse::ArgumentParser gh_pull_parser("gh-pull");
     gh_pull_parser.add_argument("--remote").help("owner/repo to pull (default: current repo)").default_value(std::string(""));
     gh_pull_parser.add_argument("--branch").help("branch to pull").default_value(std::string("main"));
+    gh_pull_parser.add_argument("--force").help("download even if the remote index matches the local one").default_value(false).implicit_value(true);
+    gh_pull_parser.add_argument("--full").help("download the whole branch instead of only files whose digest changed").default_value(false).implicit_value(true);
+    gh_pull_parser.add_argument("--jobs").help("concurrent file downloads (0 = 8)").default_value(0).scan<'i', int>();
     program.add_subparser(gh_pull_parser);
 
     argparse::ArgumentParser gh_clone_parser("gh-clone");
@@ -193,6 +256,11 @@ int runCommand(int argc, char** argv) {
     auto getConfigPath = [&]() { return exeDir + "/config.json"; };
     // Load config once per command invocation
     config::loadConfig(getConfigPath());
+    core::RepoManager::setChunkThreshold(config::getSettings().chunkThresholdMB * 1024 * 1024);
+    core::RepoManager::setCompactIndexJson(config::getSettings().compactIndex);
+    core::ObjectStore::setHardlinks(config::getSettings().objectHardlinks);
+    utils::http::setGitHubUrls(config::getSettings().githubApiUrl, config::getSettings().githubRawUrl);
+    utils::http::gitHub().setCacheDir(exeDir + "/http_cache");
     auto getSelectedRepoName = [&](const std::string& fromFlag) -> std::string {
         if (!fromFlag.empty()) return fromFlag;
         // config already loaded
@@ -273,32 +341,179 @@ int runCommand(int argc, char** argv) {
         }
         return 0;
     } else if (program.is_subcommand_used("index")) {
+        std::string repoFlag = program.get<std::string>("--repo");
+        std::string selectedRepoName = getSelectedRepoName(repoFlag);
+        if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>' or add --repo <name>."); return 1; }
+        int jobs = index_parser.get<int>("--jobs");
+        if (jobs < 0) { logger::error("--jobs must be >= 0"); return 1; }
+        std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
+        core::RepoManager repo(repoRoot);
+        if (!repo.loadIndex()) { logger::error("Failed to load repository index"); return 1; }
+        // Drop entries whose files are gone, then pick up files not yet indexed
+        std::size_t removed = repo.pruneMissingFiles();
+        std::size_t added = repo.discoverNewFiles(static_cast<unsigned>(jobs));
+        std::size_t chunked = repo.updateChunkManifests(static_cast<unsigned>(jobs));
+        std::cout << "Index summary: removed=" << removed << ", added=" << added << ", total=" << repo.index().items.size() << "\n";
+        if (chunked > 0) logger::info("Recorded chunks for " + std::to_string(chunked) + " large file(s)");
+        return 0;
     } else if (program.is_subcommand_used("verify")) {
         std::string repoFlag = program.get<std::string>("--repo");
         std::string selectedRepoName = getSelectedRepoName(repoFlag);
         if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>' or add --repo <name>."); return 1; }
+        int jobs = verify_parser.get<int>("--jobs");
+        if (jobs < 0) { logger::error("--jobs must be >= 0"); return 1; }
+        bool deep = verify_parser.get<bool>("--deep");
+        if (deep && verify_parser.get<bool>("--quick")) { logger::error("--quick and --deep are mutually exclusive"); return 1; }
         std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
         core::RepoManager repo(repoRoot);
         if (!repo.loadIndex()) { logger::error("Failed to load repository index"); return 1; }
         const auto& items = repo.index().items;
-        // Check existence and size/hash mismatches; report duplicates by relativePath or id
-        std::unordered_map<std::string, int> pathCount;
-        std::unordered_map<std::string, int> idCount;
-        size_t missing = 0, hashMismatch = 0, dupPaths = 0, dupIds = 0;
-        for (const auto& it : items) {
-            pathCount[it.relativePath]++;
-            idCount[it.id]++;
-            std::string full = repoRoot + "/" + it.relativePath;
-            if (!std::filesystem::exists(full)) { ++missing; std::cout << "MISSING: " << it.relativePath << " (" << it.name << ")\n"; continue; }
-            if (!it.sha256.empty()) {
-                std::string got = utils::computeFileSha256(full);
-                if (!got.empty() && got != it.sha256) { ++hashMismatch; std::cout << "HASH MISMATCH: " << it.relativePath << " expected=" << it.sha256 << " got=" << got << "\n"; }
+        // Check existence and hash mismatches; report duplicates by relativePath or id
+        core::VerifyReport report = repo.verify(static_cast<unsigned>(jobs), deep);
+        logger::debug("Verify hashed " + std::to_string(report.hashed) + " file(s)");
+        for (const auto& p : report.problems) {
+            const auto& it = items[p.item];
+            if (p.problem == core::VerifyReport::Problem::Missing) {
+                std::cout << "MISSING: " << it.relativePath << " (" << it.name << ")\n";
+            } else {
+                std::cout << "HASH MISMATCH: " << it.relativePath << " expected=" << it.sha256 << " got=" << p.actualSha256 << "\n";
+                for (const auto& [offset, length] : p.corruptRanges) {
+                    std::cout << "  corrupt bytes " << offset << "-" << (offset + length) << " (" << length << " bytes)\n";
+                }
             }
         }
-        for (const auto& [p,c] : pathCount) if (c > 1) { dupPaths += c - 1; std::cout << "DUP PATH: " << p << " x" << c << "\n"; }
-        for (const auto& [p,c] : idCount) if (c > 1) { dupIds += c - 1; std::cout << "DUP ID: " << p << " x" << c << "\n"; }
-        std::cout << "Verify summary: missing=" << missing << ", hashMismatch=" << hashMismatch << ", dupPaths=" << dupPaths << ", dupIds=" << dupIds << "\n";
+        for (const auto& [p,c] : report.duplicatePaths) std::cout << "DUP PATH: " << p << " x" << c << "\n";
+        for (const auto& [p,c] : report.duplicateIds) std::cout << "DUP ID: " << p << " x" << c << "\n";
+        std::cout << "Verify summary: missing=" << report.missing << ", hashMismatch=" << report.hashMismatch << ", dupPaths=" << report.dupPaths << ", dupIds=" << report.dupIds << "\n";
+        std::cout << "Tree root: " << repo.merkleTree().rootHash() << "\n";
         return 0;
+    } else if (program.is_subcommand_used("compact")) {
+        std::string repoFlag = program.get<std::string>("--repo");
+        std::string selectedRepoName = getSelectedRepoName(repoFlag);
+        if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>' or add --repo <name>."); return 1; }
+        std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
+        core::RepoManager repo(repoRoot);
+        if (!repo.loadIndex()) { logger::error("Failed to load repository index"); return 1; }
+        if (!repo.compactIndex()) { logger::error("Failed to compact index journal"); return 1; }
+        logger::info("Index journal compacted into index.json");
+        return 0;
+    } else if (program.is_subcommand_used("watch")) {
+        std::string repoFlag = program.get<std::string>("--repo");
+        std::string selectedRepoName = getSelectedRepoName(repoFlag);
+        if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>' or add --repo <name>."); return 1; }
+        int jobs = watch_parser.get<int>("--jobs");
+        int debounceMs = watch_parser.get<int>("--debounce");
+        if (jobs < 0 || debounceMs < 0) { logger::error("--jobs and --debounce must be >= 0"); return 1; }
+        if (!watcher::DirectoryWatcher::supported()) { logger::error("watch is not supported on this platform; use 'index' instead"); return 1; }
+        std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
+        core::RepoManager repo(repoRoot);
+        if (!repo.loadIndex()) { logger::error("Failed to load repository index"); return 1; }
+
+        watcher::DirectoryWatcher watch;
+        if (!watch.start(repoRoot, [](const std::string& rel) { return core::RepoManager::isInternalPath(rel); })) {
+            logger::error("Failed to watch " + repoRoot);
+            return 1;
+        }
+        // Catch up with whatever changed while nothing was watching
+        std::size_t removed = repo.pruneMissingFiles();
+        core::ChangeReport initial = repo.applyChanges({""}, static_cast<unsigned>(jobs));
+        std::cout << "Index summary: removed=" << removed << ", added=" << initial.added << ", updated=" << initial.updated << ", total=" << repo.index().items.size() << "\n";
+        logger::info("Watching " + repoRoot + " (Ctrl+C to stop)");
+
+        watchStopRequested = 0;
+        auto prevInt = std::signal(SIGINT, onWatchSignal);
+        auto prevTerm = std::signal(SIGTERM, onWatchSignal);
+        std::set<std::string> pending;
+        bool rescan = false;
+        auto lastEvent = std::chrono::steady_clock::now();
+        while (!watchStopRequested && watch.running()) {
+            for (const auto& ev : watch.poll(200)) {
+                if (ev.kind == watcher::Event::Kind::Overflow) rescan = true;
+                else pending.insert(ev.relativePath);
+                lastEvent = std::chrono::steady_clock::now();
+            }
+            // Let bursts (copies, checkouts) settle before touching the index
+            if (pending.empty() && !rescan) continue;
+            if (std::chrono::steady_clock::now() - lastEvent < std::chrono::milliseconds(debounceMs)) continue;
+
+            core::ChangeReport report;
+            if (rescan) {
+                logger::warning("Change events were lost; rescanning");
+                report.removed = repo.pruneMissingFiles();
+                core::ChangeReport full = repo.applyChanges({""}, static_cast<unsigned>(jobs));
+                report.added = full.added;
+                report.updated = full.updated;
+            } else {
+                report = repo.applyChanges(std::vector<std::string>(pending.begin(), pending.end()), static_cast<unsigned>(jobs));
+            }
+            pending.clear();
+            rescan = false;
+            if (report.added || report.updated || report.removed) {
+                std::cout << "Changes: added=" << report.added << ", updated=" << report.updated << ", removed=" << report.removed << ", total=" << repo.index().items.size() << "\n" << std::flush;
+            }
+        }
+        std::signal(SIGINT, prevInt);
+        std::signal(SIGTERM, prevTerm);
+        logger::info("Watch stopped");
+        return 0;
+    } else if (program.is_subcommand_used("dedup")) {
+        std::string repoFlag = program.get<std::string>("--repo");
+        std::string selectedRepoName = getSelectedRepoName(repoFlag);
+        if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>' or add --repo <name>."); return 1; }
+        int jobs = dedup_parser.get<int>("--jobs");
+        if (jobs < 0) { logger::error("--jobs must be >= 0"); return 1; }
+        std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
+        core::RepoManager repo(repoRoot);
+        if (!repo.loadIndex()) { logger::error("Failed to load repository index"); return 1; }
+        core::DedupReport report = repo.dedupFiles(static_cast<unsigned>(jobs));
+        std::cout << "Dedup summary: files=" << report.files << ", duplicates=" << report.duplicates << ", saved=" << report.savedBytes << " bytes, failed=" << report.failed << "\n";
+        return report.failed == 0 ? 0 : 1;
+    } else if (program.is_subcommand_used("find-asset")) {
+        std::string repoFlag = program.get<std::string>("--repo");
+        std::string selectedRepoName = getSelectedRepoName(repoFlag);
+        if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>' or add --repo <name>."); return 1; }
+        std::string query = find_asset_parser.get<std::string>("path");
+        int jobs = find_asset_parser.get<int>("--jobs");
+        if (query.empty()) { logger::error("Asset path must not be empty"); return 1; }
+        if (jobs < 0) { logger::error("--jobs must be >= 0"); return 1; }
+        std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
+        core::RepoManager repo(repoRoot);
+        if (!repo.loadIndex()) { logger::error("Failed to load repository index"); return 1; }
+        std::vector<core::AssetMatch> matches = repo.findAsset(query, static_cast<unsigned>(jobs));
+        std::set<std::size_t> packs;
+        for (const auto& m : matches) {
+            const auto& it = repo.index().items[m.item];
+            std::cout << m.asset.path << "  " << m.asset.size << "  " << it.relativePath << " (" << it.name << ")\n";
+            packs.insert(m.item);
+        }
+        std::cout << "Found " << matches.size() << " asset(s) in " << packs.size() << " pack(s)\n";
+        return matches.empty() ? 1 : 0;
+    } else if (program.is_subcommand_used("gc")) {
+        std::string repoFlag = program.get<std::string>("--repo");
+        std::string selectedRepoName = getSelectedRepoName(repoFlag);
+        if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>' or add --repo <name>."); return 1; }
+        std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
+        core::RepoManager repo(repoRoot);
+        if (!repo.loadIndex()) { logger::error("Failed to load repository index"); return 1; }
+        if (!repo.objectStoreEnabled()) { logger::info("Object store not in use for this repo (see 'dedup')"); return 0; }
+        core::GcReport report = repo.gcObjects();
+        std::cout << "GC summary: removed=" << report.removed << ", freed=" << report.freedBytes << " bytes\n";
+        return 0;
+    } else if (program.is_subcommand_used("hash-bench")) {
+        int size = hash_bench_parser.get<int>("--size");
+        if (size <= 0) { logger::error("--size must be > 0"); return 1; }
+        auto results = utils::sha256::benchmark(static_cast<std::size_t>(size) << 20);
+        bool identical = true;
+        for (const auto& r : results) {
+            std::ostringstream line;
+            line.setf(std::ios::fixed);
+            line.precision(1);
+            line << utils::sha256::backendName(r.backend) << ": " << r.megabytesPerSecond << " MiB/s";
+            if (!r.matchesScalar) { line << " (DIGEST MISMATCH)"; identical = false; }
+            std::cout << line.str() << "\n";
+        }
+        std::cout << "Active backend: " << utils::sha256::backendName(utils::sha256::activeBackend()) << "\n";
+        return identical ? 0 : 1;
     } else if (program.is_subcommand_used("remove")) {
         std::string repoFlag = program.get<std::string>("--repo");
         std::string selectedRepoName = getSelectedRepoName(repoFlag);
@@ -472,17 +687,17 @@ int runCommand(int argc, char** argv) {
         }
 #endif
         if (token.empty()) { logger::error("Empty token"); return 1; }
-        // Validate token by calling GitHub API (basic): GET user
-        // We use curl via system to avoid adding heavy deps here
-        std::string tmpFile = exeDir + "/gh_user.json";
-        std::string cmd = std::string("curl -s -H \"Authorization: token ") + token + "\" https://api.github.com/user -o \"" + tmpFile + "\"";
-        int rc = std::system(cmd.c_str());
-        if (rc != 0) { logger::error("curl failed"); return 1; }
+        // Validate token by calling GitHub API (basic): GET user. Never from the
+        // response cache, which would answer offline with the last owner seen
+        utils::http::Request userReq;
+        userReq.url = "user";
+        userReq.headers = utils::http::gitHubHeaders(token);
+        userReq.useCache = false;
+        auto resp = utils::http::gitHub().send(userReq);
+        if (!resp.error.empty()) { logger::error("GitHub request failed: " + resp.error); return 1; }
         // Parse login
-        std::ifstream fin(tmpFile);
-        nlohmann::json j; fin >> j; fin.close();
-        std::filesystem::remove(tmpFile);
-        if (!j.contains("login")) { logger::error("Invalid token"); return 1; }
+        nlohmann::json j = nlohmann::json::parse(resp.body, nullptr, false);
+        if (!j.is_object() || !j.contains("login")) { logger::error("Invalid token"); return 1; }
         std::string login = j["login"].get<std::string>();
         // Encrypt token (simple XOR with exe path hash as key). For Windows we could use DPAPI later.
         auto keyStr = exeDir;
@@ -502,37 +717,57 @@ int runCommand(int argc, char** argv) {
         if (enc.empty()) { logger::error("No token saved. Run gh-login first."); return 1; }
         auto keyStr = exeDir; uint8_t key = 0x5A; for (char c : keyStr) key ^= static_cast<uint8_t>(c);
         std::string token = enc; for (auto& ch : token) ch = static_cast<char>(static_cast<uint8_t>(ch) ^ key);
-        std::string tmpFile = exeDir + "/gh_repos.json";
-        std::string cmd = std::string("curl -s -H \"Authorization: token ") + token + "\" https://api.github.com/user/repos?per_page=100 -o \"" + tmpFile + "\"";
-        int rc = std::system(cmd.c_str());
-        if (rc != 0) { logger::error("curl failed"); return 1; }
-        std::ifstream fin(tmpFile);
-        nlohmann::json arr; fin >> arr; fin.close(); std::filesystem::remove(tmpFile);
-        if (!arr.is_array()) { logger::error("Unexpected GitHub response"); return 1; }
-        for (const auto& r : arr) {
-            std::string full = r.contains("full_name") && r["full_name"].is_string() ? r["full_name"].get<std::string>() : "?";
-            std::string priv = r.contains("private") && r["private"].is_boolean() && r["private"].get<bool>() ? "private" : "public";
-            std::string desc = r.contains("description") && r["description"].is_string() ? r["description"].get<std::string>() : "";
-            std::string branch = r.contains("default_branch") && r["default_branch"].is_string() ? r["default_branch"].get<std::string>() : std::string("main");
-
-            // Check compatibility by trying to fetch index.json from default branch
-            std::string tmpIdx = exeDir + "/gh_idx.json";
-            std::string rawUrl = std::string("https://raw.githubusercontent.com/") + full + "/" + branch + "/index.json";
-            std::string getIdx = std::string("curl -sL -H \"Authorization: token ") + token + "\" -H \"Accept: application/vnd.github.v3.raw\" \"" + rawUrl + "\" -o \"" + tmpIdx + "\"";
-            int rc2 = std::system(getIdx.c_str()); (void)rc2;
-            bool compatible = false;
-            try {
-                std::ifstream fi(tmpIdx);
-                if (fi.good()) {
-                    nlohmann::json jidx; fi >> jidx; fi.close();
-                    compatible = jidx.is_object() && jidx.contains("version") && jidx.contains("items") && jidx["items"].is_array();
-                }
-            } catch (...) { /* ignore */ }
-            std::filesystem::remove(tmpIdx);
+        int jobs = gh_list_parser.get<int>("--jobs");
+        unsigned inFlight = jobs > 0 ? static_cast<unsigned>(jobs) : 16u;
+        struct Listed { std::string full = "?", priv = "public", desc, branch = "main"; bool compatible = false; };
+        // Takes the fields gh-list prints straight from the parser, no DOM
+        class ListedVisitor : public utils::RecordVisitor {
+        public:
+            explicit ListedVisitor(std::vector<Listed>& rows) : rows(rows) {}
+            void beginRecord() override { rows.emplace_back(); }
+            void stringField(const std::string& key, std::string& value) override {
+                if (key == "full_name") rows.back().full = std::move(value);
+                else if (key == "description") rows.back().desc = std::move(value);
+                else if (key == "default_branch") rows.back().branch = std::move(value);
+            }
+            void boolField(const std::string& key, bool value) override {
+                if (key == "private") rows.back().priv = value ? "private" : "public";
+            }
+        private:
+            std::vector<Listed>& rows;
+        };
+        // Pages after the first are fetched concurrently and may arrive in any order
+        std::map<int, std::vector<Listed>> pages;
+        std::mutex pagesMutex;
+        bool stale = false, malformed = false;
+        std::string listErr;
+        bool listedOk = utils::http::gitHub().getPages("user/repos?per_page=100", utils::http::gitHubHeaders(token), inFlight,
+            [&](int page, const utils::http::Response& resp) {
+                std::vector<Listed> rows;
+                ListedVisitor visitor(rows);
+                bool parsed = utils::parseRecordArray(resp.body, visitor);
+                std::lock_guard<std::mutex> lock(pagesMutex);
+                if (!parsed) malformed = true;
+                if (resp.stale) stale = true;
+                pages[page] = std::move(rows);
+            }, listErr);
+        if (!listedOk) { logger::error("GitHub request failed: " + listErr); return 1; }
+        if (malformed) { logger::error("Unexpected GitHub response"); return 1; }
+        if (stale) logger::warning("GitHub unreachable, showing the last cached list");
+        std::vector<Listed> listed;
+        for (auto& [page, rows] : pages) {
+            for (auto& l : rows) listed.push_back(std::move(l));
+        }
+
+        // Check compatibility by fetching index.json from each default branch, several at a time
+        utils::parallelFor(listed.size(), inFlight, [&](std::size_t i) {
+            listed[i].compatible = core::probeRemoteIndex(utils::http::gitHubRawUrl() + "/" + listed[i].full + "/" + listed[i].branch, token);
+        });
 
-            std::cout << full << "  [" << priv << "]";
-            if (compatible) std::cout << "  [compatible]";
-            if (!desc.empty()) std::cout << "  " << desc;
+        for (const auto& l : listed) {
+            std::cout << l.full << "  [" << l.priv << "]";
+            if (l.compatible) std::cout << "  [compatible]";
+            if (!l.desc.empty()) std::cout << "  " << l.desc;
             std::cout << "\n";
         }
         return 0;
@@ -544,33 +779,19 @@ int runCommand(int argc, char** argv) {
         auto keyStr2 = exeDir; uint8_t key2 = 0x5A; for (char c : keyStr2) key2 ^= static_cast<uint8_t>(c);
         std::string token2 = encTok; for (auto& ch : token2) ch = static_cast<char>(static_cast<uint8_t>(ch) ^ key2);
 
-        // Fetch headers to read X-OAuth-Scopes (only for classic tokens)
-        std::string headCmd = std::string("curl -s -I -H \"Authorization: token ") + token2 + "\" https://api.github.com/user";
-        int rc_hdr = std::system((headCmd + " -o /dev/null").c_str()); (void)rc_hdr;
-        std::string hdrs = exeDir + "/gh_scopes.h";
-        std::string headCmd2 = headCmd + " -D \"" + hdrs + "\" -o /dev/null";
-        int rc_hdr2 = std::system(headCmd2.c_str()); (void)rc_hdr2;
-        std::ifstream hf(hdrs);
-        std::string line; std::string scopes;
-        while (std::getline(hf, line)) {
-            auto pos = line.find("X-OAuth-Scopes:");
-            if (pos != std::string::npos) { scopes = line.substr(pos + 15); break; }
-        }
-        hf.close(); std::filesystem::remove(hdrs);
-
-        // Fetch user to show token owner
-        std::string userFile = exeDir + "/gh_user_check.json";
-        std::string getUser = std::string("curl -s -H \"Authorization: token ") + token2 + "\" https://api.github.com/user -o \"" + userFile + "\"";
-        int rc_user = std::system(getUser.c_str()); (void)rc_user;
+        // One GET gives both the token owner and X-OAuth-Scopes (only sent for classic tokens);
+        // it bypasses the response cache so the answer is current
+        utils::http::Request userReq;
+        userReq.url = "user";
+        userReq.headers = utils::http::gitHubHeaders(token2);
+        userReq.useCache = false;
+        auto userResp = utils::http::gitHub().send(userReq);
+        if (!userResp.error.empty()) { logger::error("GitHub request failed: " + userResp.error); return 1; }
+        std::string scopes;
+        if (const std::string* h = userResp.header("X-OAuth-Scopes")) scopes = *h;
         std::string owner;
-        try {
-            std::ifstream fin(userFile);
-            if (fin.good()) {
-                nlohmann::json uj; fin >> uj; fin.close();
-                if (uj.contains("login") && uj["login"].is_string()) owner = uj["login"].get<std::string>();
-            }
-        } catch (...) {}
-        std::filesystem::remove(userFile);
+        nlohmann::json uj = nlohmann::json::parse(userResp.body, nullptr, false);
+        if (uj.is_object() && uj.contains("login") && uj["login"].is_string()) owner = uj["login"].get<std::string>();
         if (!owner.empty()) std::cout << "Token owner: " << owner << "\n";
 
         std::string trimmed = scopes;
@@ -615,70 +836,81 @@ int runCommand(int argc, char** argv) {
         if (!std::filesystem::exists(repoRoot)) { logger::error("Local repo not found"); return 1; }
 
         // Compatibility check: fetch index.json from remote branch
-        std::string tmpIdx = exeDir + "/gh_idx_pull.json";
-        std::string rawUrl = std::string("https://raw.githubusercontent.com/") + remote + "/" + branch + "/index.json";
-        std::string getIdx = std::string("curl -sL -H \"Authorization: token ") + token + "\" -H \"Accept: application/vnd.github.v3.raw\" \"" + rawUrl + "\" -o \"" + tmpIdx + "\"";
-        int rcIdx = std::system(getIdx.c_str()); (void)rcIdx;
-        bool compatible = false;
-        try {
-            std::ifstream fi(tmpIdx);
-            if (fi.good()) {
-                nlohmann::json jidx; fi >> jidx; fi.close();
-                compatible = jidx.is_object() && jidx.contains("version") && jidx.contains("items") && jidx["items"].is_array();
-            }
-        } catch (...) {}
-        std::filesystem::remove(tmpIdx);
+        std::string rawBase = utils::http::gitHubRawUrl() + "/" + remote + "/" + branch;
+        core::RepoIndex remoteIndex;
+        std::string remoteJson;
+        bool compatible = core::fetchRemoteIndex(rawBase, token, remoteIndex, remoteJson);
         if (!compatible) { logger::error("Remote repo is not compatible (missing index.json or invalid format)"); return 1; }
 
-        // Download zipball of branch
-        std::string zip = exeDir + "/pull_tmp.zip";
-        std::string url = "https://api.github.com/repos/" + remote + "/zipball/" + branch;
-        std::string cmd = std::string("curl -L -H \"Authorization: token ") + token + "\" -o \"" + zip + "\" \"" + url + "\"";
-        int rc = std::system(cmd.c_str()); if (rc != 0) { logger::error("download failed"); return 1; }
-
-        // Unzip into temp and overlay contents onto current repo
-        std::string unzipDir = exeDir + "/pull_unzip_tmp";
-        fs::createDirectoryIfNotExists(unzipDir);
-        {
-            std::string unzipErr;
-            if (!ziputil::extractArchive(zip, unzipDir, unzipErr)) {
-                logger::error("unzip failed: " + unzipErr);
-                return 1;
+        // Compare Merkle trees: equal roots mean every indexed file is the same,
+        // so the download can be skipped if metadata and local files match too
+        if (!gh_pull_parser.get<bool>("--force")) {
+            core::RepoManager local(repoRoot);
+            if (local.loadIndex()) {
+                std::size_t visited = 0;
+                auto changes = core::MerkleTree::diff(local.merkleTree(), core::MerkleTree::build(remoteIndex.items), &visited);
+                logger::debug("Tree compare visited " + std::to_string(visited) + " director(ies)");
+                if (changes.empty()) {
+                    bool sameMetadata = nlohmann::json(local.index()) == nlohmann::json(remoteIndex);
+                    core::VerifyReport report = local.verify();
+                    if (sameMetadata && report.missing == 0 && report.hashMismatch == 0) {
+                        logger::info("Already up to date with github.com/" + remote + " (branch " + branch + ")");
+                        return 0;
+                    }
+                } else {
+                    logger::info("Remote differs in " + std::to_string(changes.size()) + " file(s)");
+                }
             }
         }
 
-        // Find top-level folder and copy its contents into repoRoot (overwrite)
-        std::string top;
-        for (auto& e : std::filesystem::directory_iterator(unzipDir)) { if (e.is_directory()) { top = e.path().string(); break; } }
-        if (top.empty()) { logger::error("unexpected zip layout"); return 1; }
+        core::PullReport pulled;
+        std::string pullErr;
+        std::size_t lastStep = 0;
+        auto pullProgress = [&lastStep](const core::PullReport& r) {
+            std::size_t files = r.written + r.unchanged;
+            if (files / 500 == lastStep) return;
+            lastStep = files / 500;
+            logger::info("Applied " + std::to_string(files) + " files (" + std::to_string(r.written) + " written)");
+        };
+        int jobs = gh_pull_parser.get<int>("--jobs");
+        if (jobs < 0) { logger::error("--jobs must be >= 0"); return 1; }
+
+        // Fetch only the items whose digest differs; the zipball is the fallback
+        bool done = false;
+        if (!gh_pull_parser.get<bool>("--full")) {
+            done = core::pullDelta(repoRoot, remoteIndex, remoteJson, rawBase, token, static_cast<unsigned>(jobs),
+                                   pulled, pullErr, pullProgress);
+            if (done) {
+                logger::info(std::to_string(pulled.written) + " file(s) fetched (" + std::to_string(pulled.bytesWritten / (1024 * 1024)) +
+                             " MiB), " + std::to_string(pulled.removed) + " removed, " + std::to_string(pulled.unchanged) + " unchanged, " +
+                             std::to_string(pulled.kept) + " local-only kept");
+            } else {
+                logger::warning("Delta pull failed (" + pullErr + "); downloading the whole branch");
+            }
+        }
 
-        // Copy recursively (overwrite). Be robust on Windows/MinGW where overwrite flags can be flaky.
-        for (auto& p : std::filesystem::recursive_directory_iterator(top)) {
-            if (!p.is_regular_file()) continue;
-            auto rel = std::filesystem::relative(p.path(), top).string();
-            std::filesystem::path dest = std::filesystem::path(repoRoot) / rel;
-            std::filesystem::create_directories(dest.parent_path());
-            try {
-                if (std::filesystem::exists(dest)) {
-                    std::error_code ec_rm;
-                    std::filesystem::remove(dest, ec_rm);
-                }
-                std::error_code ec_cp;
-                std::filesystem::copy_file(p.path(), dest, std::filesystem::copy_options::overwrite_existing, ec_cp);
-                if (ec_cp) {
-                    throw std::runtime_error(std::string("copy_file failed: ") + ec_cp.message());
-                }
-            } catch (const std::exception& e) {
-                logger::error(std::string("copy failed: ") + e.what());
-                std::filesystem::remove(zip);
-                std::filesystem::remove_all(unzipDir);
+        // Stream the zipball of the branch into the repo; unchanged files are not rewritten
+        if (!done) {
+            std::string url = "repos/" + remote + "/zipball/" + branch;
+            if (!core::pullZipball(repoRoot, url, token, exeDir, pulled, pullErr, pullProgress)) {
+                logger::error("pull failed: " + pullErr);
                 return 1;
             }
+            logger::info(std::to_string(pulled.written) + " file(s) written (" + std::to_string(pulled.bytesWritten / (1024 * 1024)) +
+                         " MiB), " + std::to_string(pulled.unchanged) + " unchanged");
         }
 
-        // Cleanup
-        std::filesystem::remove(zip);
-        std::filesystem::remove_all(unzipDir);
+        // Check pulled files against the new index; this also refreshes the hash cache
+        {
+            core::RepoManager repo(repoRoot);
+            if (repo.loadIndex()) {
+                core::VerifyReport report = repo.verify();
+                if (report.missing > 0 || report.hashMismatch > 0) {
+                    logger::warning("Pulled repo has " + std::to_string(report.missing) + " missing and " +
+                                    std::to_string(report.hashMismatch) + " mismatched file(s); run verify for details");
+                }
+            }
+        }
         logger::info("Pulled and updated repo from github.com/" + remote + " (branch " + branch + ")");
         return 0;
     } else if (program.is_subcommand_used("gh-clone")) {
@@ -706,16 +938,15 @@ int runCommand(int argc, char** argv) {
 
         // Download zipball of branch
         std::string zip = exeDir + "/" + name + ".zip";
-        std::string url = "https://api.github.com/repos/" + remote + "/zipball/" + branch;
-        std::string cmd = std::string("curl -L -H \"Authorization: token ") + token + "\" -o \"" + zip + "\" \"" + url + "\"";
-        int rc = std::system(cmd.c_str()); if (rc != 0) { logger::error("download failed"); return 1; }
+        auto dl = utils::http::gitHub().download("repos/" + remote + "/zipball/" + branch, utils::http::gitHubHeaders(token), zip);
+        if (!dl.ok()) { logger::error("download failed: " + (dl.error.empty() ? "HTTP " + std::to_string(dl.status) : dl.error)); return 1; }
 
         // Unzip
         std::string unzipDir = exeDir + "/ziptmp_" + name;
         fs::createDirectoryIfNotExists(unzipDir);
         {
             std::string unzipErr;
-            if (!ziputil::extractArchive(zip, unzipDir, unzipErr)) { logger::error("unzip failed: " + unzipErr); return 1; }
+            if (!ziputil::extractArchive(zip, unzipDir, unzipErr, 0, extractionProgress())) { logger::error("unzip failed: " + unzipErr); return 1; }
         }
 
         // Move extracted single top-level folder to repos/<name>
@@ -769,6 +1000,11 @@ int runCommand(int argc, char** argv) {
         if (selectedRepoName.empty()) { logger::error("No repo selected. Use 'use <name>'."); return 1; }
         std::string repoRoot = exeDir + "/repos/" + selectedRepoName;
         if (!std::filesystem::exists(repoRoot)) { logger::error("Local repo not found"); return 1; }
+        {
+            // Fold pending journal records so the pushed index.json is complete
+            core::RepoManager repo(repoRoot);
+            if (repo.loadIndex() && !repo.compactIndex()) { logger::error("Failed to compact index journal"); return 1; }
+        }
 
         // Derive default remote from current repo name if not provided
         if (remote.empty()) {
@@ -787,7 +1023,6 @@ int runCommand(int argc, char** argv) {
         if (createRepo) {
             logger::debug("Starting repository creation process...");
             auto slash = remote.find('/');
-            std::string tmp = exeDir + "/gh_create.json";
             std::string body;
             std::string url;
             if (slash != std::string::npos) {
@@ -795,32 +1030,26 @@ int runCommand(int argc, char** argv) {
                 std::string owner = remote.substr(0, slash);
                 std::string repoOnly = remote.substr(slash + 1);
                 body = std::string("{\"name\":\"") + repoOnly + "\",\"private\":" + (makePrivate?"true":"false") + "}";
-                url = std::string("https://api.github.com/orgs/") + owner + "/repos";
+                url = "orgs/" + owner + "/repos";
             } else {
                 // Create under user
                 body = std::string("{\"name\":\"") + remote + "\",\"private\":" + (makePrivate?"true":"false") + "}";
-                url = "https://api.github.com/user/repos";
+                url = "user/repos";
             }
-            // Write request body to a temp file to avoid shell quoting issues on Windows
-            std::string bodyFile = exeDir + "/gh_create_body.json";
-            try {
-                std::ofstream bf(bodyFile, std::ios::binary);
-                bf << body;
-                bf.close();
-            } catch (...) {
-                logger::error("Failed to write request body file");
-                return 1;
-            }
-            std::string cmd = std::string("curl -s -X POST -H \"Authorization: token ") + token + "\" -H \"Accept: application/vnd.github+json\" -H \"Content-Type: application/json\" --data @" + bodyFile + " \"" + url + "\" -o \"" + tmp + "\"";
+            utils::http::Request req;
+            req.method = "POST";
+            req.url = url;
+            req.headers = utils::http::gitHubHeaders(token);
+            req.headers.emplace_back("Content-Type", "application/json");
+            req.body = body;
             logger::debug("Creating repository with API call: " + url);
             logger::debug("Request body: " + body);
-            int rcC = std::system(cmd.c_str()); 
-            logger::debug("curl exit code: " + std::to_string(rcC));
+            auto resp = utils::http::gitHub().send(req);
+            logger::debug("HTTP status: " + std::to_string(resp.status) + (resp.error.empty() ? "" : " (" + resp.error + ")"));
             bool createdOk = false; std::string errMsg; std::string createdFullName;
             try {
-                std::ifstream jf(tmp);
-                if (jf.good()) {
-                    nlohmann::json jr; jf >> jr; jf.close();
+                if (resp.error.empty()) {
+                    nlohmann::json jr = nlohmann::json::parse(resp.body);
                     logger::debug("GitHub API response: " + jr.dump());
                     if (jr.contains("full_name") && jr["full_name"].is_string()) {
                         createdOk = true;
@@ -835,13 +1064,11 @@ int runCommand(int argc, char** argv) {
                         logger::debug("GitHub API validation errors: " + errors);
                     }
                 } else {
-                    logger::debug("Failed to read response file: " + tmp);
+                    errMsg = resp.error;
                 }
             } catch (const std::exception& e) {
                 logger::debug("Exception parsing GitHub response: " + std::string(e.what()));
             }
-            std::filesystem::remove(tmp);
-            std::filesystem::remove(bodyFile);
             if (!createdOk) {
                 if (errMsg.empty()) errMsg = "failed to create repo - no response or unknown error";
                 logger::error("GitHub create repo failed: " + errMsg);
@@ -926,36 +1153,24 @@ int runCommand(int argc, char** argv) {
         auto keyStr = exeDir; uint8_t key = 0x5A; for (char c : keyStr) key ^= static_cast<uint8_t>(c);
         std::string token = enc; for (auto& ch : token) ch = static_cast<char>(static_cast<uint8_t>(ch) ^ key);
 
-        std::string tmp = exeDir + "/gh_delete.json";
-        std::string codeFile = exeDir + "/gh_delete.code";
-        std::string cmd = std::string("curl -s -X DELETE -H \"Authorization: token ") + token + "\" \"https://api.github.com/repos/" + remote + "\" -o \"" + tmp + "\" -w \"%{http_code}\" > \"" + codeFile + "\"";
-        int rc = std::system(cmd.c_str());
-        if (rc != 0) { logger::error("delete failed"); return 1; }
-        int httpCode = -1;
-        try {
-            std::ifstream cf(codeFile);
-            if (cf.good()) { cf >> httpCode; }
-        } catch (...) {}
-        std::filesystem::remove(codeFile);
-        if (httpCode != 204) {
+        utils::http::Request req;
+        req.method = "DELETE";
+        req.url = "repos/" + remote;
+        req.headers = utils::http::gitHubHeaders(token);
+        auto resp = utils::http::gitHub().send(req);
+        if (!resp.error.empty()) { logger::error("delete failed: " + resp.error); return 1; }
+        if (resp.status != 204) {
             std::string errMsg;
-            try {
-                std::ifstream jf(tmp);
-                if (jf.good()) {
-                    nlohmann::json jr; jf >> jr; jf.close();
-                    if (jr.contains("message") && jr["message"].is_string()) errMsg = jr["message"].get<std::string>();
-                }
-            } catch (...) {}
-            std::filesystem::remove(tmp);
-            if (httpCode == 404) {
+            nlohmann::json jr = nlohmann::json::parse(resp.body, nullptr, false);
+            if (jr.is_object() && jr.contains("message") && jr["message"].is_string()) errMsg = jr["message"].get<std::string>();
+            if (resp.status == 404) {
                 logger::warning("Repository not found on GitHub: " + remote);
                 return 0;
             }
-            if (errMsg.empty()) errMsg = "unexpected HTTP " + std::to_string(httpCode);
+            if (errMsg.empty()) errMsg = "unexpected HTTP " + std::to_string(resp.status);
             logger::error("GitHub delete failed: " + errMsg);
             return 1;
         }
-        std::filesystem::remove(tmp);
         logger::info("Deleted github.com/" + remote);
         return 0;
     } else if (program.is_subcommand_used("gh-visibility")) {
@@ -969,26 +1184,21 @@ int runCommand(int argc, char** argv) {
         auto keyStr = exeDir; uint8_t key = 0x5A; for (char c : keyStr) key ^= static_cast<uint8_t>(c);
         std::string token = enc; for (auto& ch : token) ch = static_cast<char>(static_cast<uint8_t>(ch) ^ key);
 
-        std::string tmp = exeDir + "/gh_update.json";
         std::string body = std::string("{\"private\":") + (makePrivate?"true":"false") + "}";
-        // Write body to file to avoid Windows quoting issues
-        std::string bodyFile = exeDir + "/gh_update_body.json";
-        try {
-            std::ofstream bf(bodyFile, std::ios::binary);
-            bf << body;
-            bf.close();
-        } catch (...) {
-            logger::error("Failed to write request body file");
-            return 1;
-        }
-        std::string cmd = std::string("curl -s -X PATCH -H \"Authorization: token ") + token + "\" -H \"Accept: application/vnd.github+json\" -H \"Content-Type: application/json\" --data @" + bodyFile + " https://api.github.com/repos/" + remote + " -o \"" + tmp + "\"";
         logger::debug("Updating repo visibility via API: github.com/" + remote + " -> " + vis);
-        int rc = std::system(cmd.c_str()); (void)rc;
+        utils::http::Request req;
+        req.method = "PATCH";
+        req.url = "repos/" + remote;
+        req.headers = utils::http::gitHubHeaders(token);
+        req.headers.emplace_back("Content-Type", "application/json");
+        req.body = body;
+        auto resp = utils::http::gitHub().send(req);
         bool ok = false; bool finalPrivate = makePrivate; std::string errMsg;
         try {
-            std::ifstream jf(tmp);
-            if (jf.good()) {
-                nlohmann::json jr; jf >> jr; jf.close();
+            if (!resp.error.empty()) {
+                errMsg = resp.error;
+            } else {
+                nlohmann::json jr = nlohmann::json::parse(resp.body);
                 logger::debug("GitHub API response: " + jr.dump());
                 if (jr.contains("private") && jr["private"].is_boolean()) {
                     ok = true; finalPrivate = jr["private"].get<bool>();
@@ -1000,8 +1210,6 @@ int runCommand(int argc, char** argv) {
         } catch (const std::exception& e) {
             logger::debug(std::string("Exception parsing GitHub response: ") + e.what());
         }
-        std::filesystem::remove(tmp);
-        std::filesystem::remove(bodyFile);
         if (!ok) {
             if (errMsg.empty()) errMsg = "failed to update visibility";
             logger::error("GitHub visibility update failed: " + errMsg);
@@ -1037,7 +1245,7 @@ void repl() {
         size_t start = cursor; while (start > 0 && !isspace(static_cast<unsigned char>(buffer[start-1]))) --start;
         std::string token = buffer.substr(start, cursor - start);
         std::vector<std::string> cmds = {
-            "help","exit","quit","init","use","add","list","index","remove","rename",
+            "help","exit","quit","init","use","add","list","index","watch","compact","dedup","gc","find-asset","hash-bench","remove","rename",
             "list-repos","delete-repo","rename-repo","gh-login","gh-list","gh-clone","gh-pull",
             "gh-push","gh-delete","gh-visibility","verify","gh-token-check"
         };
@@ -1074,6 +1282,12 @@ void repl() {
             argparse::ArgumentParser add_parser("add");
             argparse::ArgumentParser list_parser("list");
             argparse::ArgumentParser index_parser("index");
+            argparse::ArgumentParser compact_parser("compact");
+            argparse::ArgumentParser watch_parser("watch");
+            argparse::ArgumentParser dedup_parser("dedup");
+            argparse::ArgumentParser gc_parser("gc");
+            argparse::ArgumentParser find_asset_parser("find-asset");
+            argparse::ArgumentParser hash_bench_parser("hash-bench");
             argparse::ArgumentParser remove_parser("remove");
             argparse::ArgumentParser rename_parser("rename");
             argparse::ArgumentParser repl_parser("repl");
@@ -1087,6 +1301,12 @@ void repl() {
             program.add_subparser(add_parser);
             program.add_subparser(list_parser);
             program.add_subparser(index_parser);
+            program.add_subparser(compact_parser);
+            program.add_subparser(watch_parser);
+            program.add_subparser(dedup_parser);
+            program.add_subparser(gc_parser);
+            program.add_subparser(find_asset_parser);
+            program.add_subparser(hash_bench_parser);
             program.add_subparser(remove_parser);
             program.add_subparser(rename_parser);
             program.add_subparser(repl_parser);
@@ -1151,10 +1371,58 @@ void repl() {
                 continue;
             } else if (sub == "index") {
                 argparse::ArgumentParser p("index");
+                p.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
+                p.add_epilog(
+                    "ASCII-only paths required. Юникод в путях не поддерживается.");
+                std::cerr << p;
+                continue;
+            } else if (sub == "verify") {
+                argparse::ArgumentParser p("verify");
+                p.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
+                p.add_argument("--quick").help("trust cached digests of unchanged files (default)").default_value(false).implicit_value(true);
+                p.add_argument("--deep").help("rehash every file, ignoring the hash cache").default_value(false).implicit_value(true);
+                p.add_epilog(
+                    "ASCII-only paths required. Юникод в путях не поддерживается.");
+                std::cerr << p;
+                continue;
+            } else if (sub == "compact") {
+                argparse::ArgumentParser p("compact");
+                p.add_epilog(
+                    "ASCII-only paths required. Юникод в путях не поддерживается.");
+                std::cerr << p;
+                continue;
+            } else if (sub == "watch") {
+                argparse::ArgumentParser p("watch");
+                p.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
+                p.add_argument("--debounce").help("milliseconds without events before changes are applied").default_value(500).scan<'i', int>();
+                p.add_epilog(
+                    "ASCII-only paths required. Юникод в путях не поддерживается.");
+                std::cerr << p;
+                continue;
+            } else if (sub == "dedup") {
+                argparse::ArgumentParser p("dedup");
+                p.add_argument("--jobs").help("hashing threads (0 = one per CPU core)").default_value(0).scan<'i', int>();
                 p.add_epilog(
                     "ASCII-only paths required. Юникод в путях не поддерживается.");
                 std::cerr << p;
                 continue;
+            } else if (sub == "gc") {
+                argparse::ArgumentParser p("gc");
+                std::cerr << p;
+                continue;
+            } else if (sub == "find-asset") {
+                argparse::ArgumentParser p("find-asset");
+                p.add_argument("path").help("asset path or part of it, e.g. maps/q3dm17.bsp (case-insensitive)");
+                p.add_argument("--jobs").help("threads for cataloging new packs (0 = one per CPU core)").default_value(0).scan<'i', int>();
+                p.add_epilog(
+                    "ASCII-only paths required. Юникод в путях не поддерживается.");
+                std::cerr << p;
+                continue;
+            } else if (sub == "hash-bench") {
+                argparse::ArgumentParser p("hash-bench");
+                p.add_argument("--size").help("MiB of data to hash per backend").default_value(256).scan<'i', int>();
+                std::cerr << p;
+                continue;
             } else if (sub == "remove") {
                 argparse::ArgumentParser p("remove");
                 p.add_argument("id").help("item ID to remove");
@@ -1200,6 +1468,7 @@ void repl() {
                 continue;
             } else if (sub == "gh-list") {
                 argparse::ArgumentParser p("gh-list");
+                p.add_argument("--jobs").help("concurrent page fetches and compatibility probes (0 = 16)").default_value(0).scan<'i', int>();
                 p.add_epilog(
                     "ASCII-only paths required. Юникод в путях не поддерживается.");
                 std::cerr << p;
@@ -1229,6 +1498,9 @@ void repl() {
                 argparse::ArgumentParser p("gh-pull");
                 p.add_argument("--remote").help("owner/repo to pull (default: current repo)").default_value(std::string(""));
                 p.add_argument("--branch").help("branch to pull").default_value(std::string("main"));
+                p.add_argument("--force").help("download even if the remote index matches the local one").default_value(false).implicit_value(true);
+                p.add_argument("--full").help("download the whole branch instead of only files whose digest changed").default_value(false).implicit_value(true);
+                p.add_argument("--jobs").help("concurrent file downloads (0 = 8)").default_value(0).scan<'i', int>();
                 p.add_epilog(
                     "ASCII-only paths required. Юникод в путях не поддерживается.");
                 std::cerr << p;
@@ -0,0 +1,105 @@
+#include "asset_catalog.h"
+#include "../system/logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace core {
+
+static const char* kHeader = "repoman-catalog";
+static constexpr int kFormatVersion = 1;
+
+void AssetCatalog::load() {
+    if (loaded) return;
+    loaded = true;
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in.is_open()) return;
+
+    std::string line;
+    if (!std::getline(in, line)) return;
+    {
+        std::istringstream hs(line);
+        std::string magic; int version = 0;
+        hs >> magic >> version;
+        if (magic != kHeader || version != kFormatVersion || hs.fail()) {
+            logger::debug("Ignoring asset catalog with unknown format: " + filePath);
+            return;
+        }
+    }
+    std::vector<AssetEntry>* current = nullptr;
+    while (std::getline(in, line)) {
+        if (line.size() > 2 && line[0] == '@' && line[1] == ' ') {
+            std::istringstream as(line.substr(2));
+            std::string sha; std::size_t count = 0;
+            as >> sha >> count;
+            if (as.fail() || sha.size() != 64) { current = nullptr; continue; }
+            current = &archives[sha];
+            current->clear();
+            current->reserve(count);
+            continue;
+        }
+        if (!current) continue;
+        // Hand-rolled: catalogs of large repos have millions of lines
+        char* rest = nullptr;
+        AssetEntry e;
+        e.crc32 = static_cast<uint32_t>(std::strtoul(line.c_str(), &rest, 16));
+        if (!rest || *rest != ' ') continue;
+        e.size = std::strtoull(rest + 1, &rest, 10);
+        if (!rest || *rest != ' ') continue;
+        e.path.assign(rest + 1);
+        if (!e.path.empty()) current->push_back(std::move(e));
+    }
+}
+
+bool AssetCatalog::save() {
+    if (!modified) return true;
+    std::string tmp = filePath + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out << kHeader << ' ' << kFormatVersion << '\n';
+        char crc[9];
+        for (const auto& [sha, entries] : archives) {
+            out << "@ " << sha << ' ' << entries.size() << '\n';
+            for (const auto& e : entries) {
+                std::snprintf(crc, sizeof(crc), "%08x", e.crc32);
+                out << crc << ' ' << e.size << ' ' << e.path << '\n';
+            }
+        }
+        if (!out.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, filePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    modified = false;
+    return true;
+}
+
+const std::vector<AssetEntry>* AssetCatalog::find(const std::string& sha256) const {
+    auto it = archives.find(sha256);
+    return it == archives.end() ? nullptr : &it->second;
+}
+
+void AssetCatalog::store(const std::string& sha256, std::vector<AssetEntry> entries) {
+    archives[sha256] = std::move(entries);
+    modified = true;
+}
+
+void AssetCatalog::retain(const std::function<bool(const std::string&)>& keep) {
+    for (auto it = archives.begin(); it != archives.end();) {
+        if (keep(it->first)) {
+            ++it;
+        } else {
+            it = archives.erase(it);
+            modified = true;
+        }
+    }
+}
+
+}
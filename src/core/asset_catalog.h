@@ -0,0 +1,47 @@
+#ifndef CORE_ASSET_CATALOG_H
+#define CORE_ASSET_CATALOG_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace core {
+
+// One file inside a pk3
+struct AssetEntry {
+    std::string path;   // as stored in the archive, '/' separated
+    uint64_t size = 0;  // uncompressed
+    uint32_t crc32 = 0;
+};
+
+// Contents of pk3 archives keyed by the archive's sha256 (.repoman/catalog),
+// so a listing stays valid across renames and is shared by identical packs.
+// Text file: "repoman-catalog <version>", then per archive a line
+// "@ <sha256> <count>" followed by <count> lines "<crc32> <size> <path>".
+class AssetCatalog {
+public:
+    explicit AssetCatalog(std::string path) : filePath(std::move(path)) {}
+
+    // Missing or unreadable catalogs load as empty
+    void load();
+    // Writes atomically (temp file + rename); no-op if nothing changed
+    bool save();
+
+    // Listing of an archive; nullptr if it has not been cataloged
+    const std::vector<AssetEntry>* find(const std::string& sha256) const;
+    void store(const std::string& sha256, std::vector<AssetEntry> entries);
+    // Drops archives for which keep(sha256) is false
+    void retain(const std::function<bool(const std::string&)>& keep);
+
+private:
+    std::string filePath;
+    std::unordered_map<std::string, std::vector<AssetEntry>> archives;
+    bool loaded = false;
+    bool modified = false;
+};
+
+}
+
+#endif // CORE_ASSET_CATALOG_H
@@ -0,0 +1,68 @@
+#include "chunk_manifest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace core {
+
+static const char* kHeader = "repoman-chunks";
+static constexpr int kFormatVersion = 1;
+
+bool saveChunkManifest(const std::string& path, const ChunkManifest& manifest) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out << kHeader << ' ' << kFormatVersion << '\n';
+        out << manifest.fileSize << ' ' << manifest.params.minSize << ' '
+            << manifest.params.avgSize << ' ' << manifest.params.maxSize << '\n';
+        for (const auto& c : manifest.chunks) {
+            out << c.offset << ' ' << c.length << ' ' << c.sha256 << '\n';
+        }
+        if (!out.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool loadChunkManifest(const std::string& path, ChunkManifest& manifest) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    if (!std::getline(in, line)) return false;
+    {
+        std::istringstream hs(line);
+        std::string magic; int version = 0;
+        hs >> magic >> version;
+        if (magic != kHeader || version != kFormatVersion || hs.fail()) return false;
+    }
+    ChunkManifest m;
+    if (!std::getline(in, line)) return false;
+    {
+        std::istringstream ps(line);
+        ps >> m.fileSize >> m.params.minSize >> m.params.avgSize >> m.params.maxSize;
+        if (ps.fail()) return false;
+    }
+    uint64_t next = 0;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        std::istringstream ls(line);
+        utils::Chunk c;
+        ls >> c.offset >> c.length >> c.sha256;
+        if (ls.fail() || c.offset != next || c.sha256.size() != 64) return false;
+        next += c.length;
+        m.chunks.push_back(std::move(c));
+    }
+    if (next != m.fileSize) return false;
+    manifest = std::move(m);
+    return true;
+}
+
+}
@@ -0,0 +1,28 @@
+#ifndef CORE_CHUNK_MANIFEST_H
+#define CORE_CHUNK_MANIFEST_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../utils/chunker.h"
+
+namespace core {
+
+// Content-defined chunks of one file version, stored per digest in
+// .repoman/chunks/<sha256>. Used to locate corrupt byte ranges and to find
+// the parts that two versions of a large file share.
+struct ChunkManifest {
+    uint64_t fileSize = 0;
+    utils::ChunkParams params;
+    std::vector<utils::Chunk> chunks; // in file order, covering the whole file
+};
+
+// Text file: "repoman-chunks <version>", "<file_size> <min> <avg> <max>",
+// then one "<offset> <length> <sha256>" line per chunk. Written atomically.
+bool saveChunkManifest(const std::string& path, const ChunkManifest& manifest);
+// False if the file is missing, malformed or its chunks do not tile the file
+bool loadChunkManifest(const std::string& path, ChunkManifest& manifest);
+
+}
+
+#endif // CORE_CHUNK_MANIFEST_H
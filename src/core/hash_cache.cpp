@@ -0,0 +1,143 @@
+#include "hash_cache.h"
+#include "../system/logger.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace core {
+
+namespace {
+
+const char* kHeader = "repoman-hashcache";
+constexpr int kFormatVersion = 1;
+// Files modified this close to the last cache write may have changed again
+// within the same timestamp tick (coarse filesystems), so they are rehashed.
+constexpr int64_t kRacyWindowNs = 2000000000LL;
+
+int64_t nowNs() {
+#ifdef _WIN32
+    auto t = std::filesystem::file_time_type::clock::now().time_since_epoch();
+#else
+    auto t = std::chrono::system_clock::now().time_since_epoch();
+#endif
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count());
+}
+
+} // namespace
+
+bool statFileIdentity(const std::string& path, FileIdentity& out) {
+#ifdef _WIN32
+    std::error_code ec;
+    std::filesystem::path p = std::filesystem::u8path(path);
+    auto size = std::filesystem::file_size(p, ec);
+    if (ec) return false;
+    auto mtime = std::filesystem::last_write_time(p, ec);
+    if (ec) return false;
+    out.size = static_cast<uint64_t>(size);
+    out.mtimeNs = static_cast<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count());
+    out.inode = 0;
+    out.device = 0;
+    return true;
+#else
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    out.size = static_cast<uint64_t>(st.st_size);
+    out.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    out.inode = static_cast<uint64_t>(st.st_ino);
+    out.device = static_cast<uint64_t>(st.st_dev);
+    return true;
+#endif
+}
+
+void HashCache::load() {
+    if (loaded) return;
+    loaded = true;
+    std::ifstream in(filePath, std::ios::binary);
+    if (!in.is_open()) return;
+
+    std::string line;
+    if (!std::getline(in, line)) return;
+    {
+        std::istringstream hs(line);
+        std::string magic; int version = 0;
+        hs >> magic >> version >> writtenNs;
+        if (magic != kHeader || version != kFormatVersion || hs.fail()) {
+            logger::debug("Ignoring hash cache with unknown format: " + filePath);
+            writtenNs = 0;
+            return;
+        }
+    }
+    while (std::getline(in, line)) {
+        std::istringstream ls(line);
+        Entry e;
+        ls >> e.sha256 >> e.id.size >> e.id.mtimeNs >> e.id.inode >> e.id.device;
+        if (ls.fail() || ls.get() != ' ') continue;
+        std::string rel;
+        std::getline(ls, rel);
+        if (rel.empty() || e.sha256.size() != 64) continue;
+        entries[rel] = std::move(e);
+    }
+}
+
+bool HashCache::save() {
+    if (!modified) return true;
+    std::string tmp = filePath + ".tmp";
+    int64_t now = nowNs();
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out << kHeader << ' ' << kFormatVersion << ' ' << now << '\n';
+        for (const auto& [rel, e] : entries) {
+            out << e.sha256 << ' ' << e.id.size << ' ' << e.id.mtimeNs << ' '
+                << e.id.inode << ' ' << e.id.device << ' ' << rel << '\n';
+        }
+        if (!out.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, filePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    writtenNs = now;
+    modified = false;
+    return true;
+}
+
+std::optional<std::string> HashCache::lookup(const std::string& relativePath, const FileIdentity& id) const {
+    auto it = entries.find(relativePath);
+    if (it == entries.end() || !(it->second.id == id)) return std::nullopt;
+    if (id.mtimeNs + kRacyWindowNs >= writtenNs) return std::nullopt;
+    return it->second.sha256;
+}
+
+void HashCache::store(const std::string& relativePath, const FileIdentity& id, const std::string& sha256) {
+    if (sha256.empty()) return;
+    auto it = entries.find(relativePath);
+    // An unchanged entry still needs a save while it is racy, so the new
+    // write time eventually clears it
+    if (it != entries.end() && it->second.id == id && it->second.sha256 == sha256 &&
+        id.mtimeNs + kRacyWindowNs < writtenNs) return;
+    entries[relativePath] = Entry{id, sha256};
+    modified = true;
+}
+
+void HashCache::retain(const std::function<bool(const std::string&)>& keep) {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!keep(it->first)) {
+            it = entries.erase(it);
+            modified = true;
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace core
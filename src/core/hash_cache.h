@@ -0,0 +1,60 @@
+#ifndef CORE_HASH_CACHE_H
+#define CORE_HASH_CACHE_H
+
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+
+namespace core {
+
+// What identifies one version of a file on disk. A cached digest is reused
+// only while all fields still match.
+struct FileIdentity {
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    uint64_t inode = 0;   // 0 where the platform has no stable file id
+    uint64_t device = 0;
+
+    bool operator==(const FileIdentity& o) const {
+        return size == o.size && mtimeNs == o.mtimeNs && inode == o.inode && device == o.device;
+    }
+};
+
+// Fills out from the file's metadata; false if it cannot be stat'ed.
+bool statFileIdentity(const std::string& path, FileIdentity& out);
+
+// Persistent map of relative path + FileIdentity -> sha256 (.repoman/hashcache).
+// Text file, one entry per line: "<sha256> <size> <mtime_ns> <inode> <device> <path>".
+class HashCache {
+public:
+    explicit HashCache(std::string path) : filePath(std::move(path)) {}
+
+    // Missing or unreadable cache files load as empty
+    void load();
+    // Writes atomically (temp file + rename); no-op if nothing changed
+    bool save();
+
+    // Cached digest if the entry matches id and is not racy
+    std::optional<std::string> lookup(const std::string& relativePath, const FileIdentity& id) const;
+    void store(const std::string& relativePath, const FileIdentity& id, const std::string& sha256);
+    // Drops entries for which keep(relativePath) is false
+    void retain(const std::function<bool(const std::string&)>& keep);
+
+private:
+    struct Entry {
+        FileIdentity id;
+        std::string sha256;
+    };
+
+    std::string filePath;
+    std::unordered_map<std::string, Entry> entries;
+    int64_t writtenNs = 0; // when the loaded cache was saved
+    bool loaded = false;
+    bool modified = false;
+};
+
+}
+
+#endif // CORE_HASH_CACHE_H
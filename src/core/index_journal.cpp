@@ -0,0 +1,180 @@
+#include "index_journal.h"
+#include "../system/logger.h"
+#include "../system/fs.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace core {
+
+namespace {
+
+// Index being replayed into. Items are found through a map built once, and
+// removed items are only flagged, then dropped in one pass by finish(), so a
+// replay costs O(items + records) rather than a scan and an erase per record.
+class Replay {
+public:
+    explicit Replay(RepoIndex& index) : index(index), removed(index.items.size(), false) {
+        positions.reserve(index.items.size());
+        // The first item with an id wins, as a linear search would find it
+        for (std::size_t i = 0; i < index.items.size(); ++i) positions.emplace(index.items[i].id, i);
+    }
+
+    // Applies one mutation record; unknown ops and missing ids are ignored.
+    void apply(const nlohmann::json& rec);
+
+    void finish() {
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < index.items.size(); ++i) {
+            if (removed[i]) continue;
+            if (kept != i) index.items[kept] = std::move(index.items[i]);
+            ++kept;
+        }
+        index.items.resize(kept);
+    }
+
+private:
+    RepoIndex& index;
+    std::unordered_map<std::string, std::size_t> positions;
+    std::vector<bool> removed;
+
+    ContentItem* find(const std::string& id) {
+        auto it = positions.find(id);
+        return it == positions.end() ? nullptr : &index.items[it->second];
+    }
+};
+
+void Replay::apply(const nlohmann::json& rec) {
+    std::string op = rec.value("op", "");
+    if (op == "add") {
+        ContentItem item = rec.at("item").get<ContentItem>();
+        if (ContentItem* existing = find(item.id)) {
+            *existing = std::move(item);
+        } else {
+            // A re-added id goes to the end, where push_back after erase put it
+            positions[item.id] = index.items.size();
+            index.items.push_back(std::move(item));
+            removed.push_back(false);
+        }
+        return;
+    }
+    std::string id = rec.value("id", "");
+    ContentItem* it = find(id);
+    if (!it) return;
+    if (op == "remove") {
+        removed[positions[id]] = true;
+        positions.erase(id);
+    } else if (op == "rename") {
+        rec.at("name").get_to(it->name);
+    } else if (op == "move") {
+        rec.at("path").get_to(it->relativePath);
+        rec.at("updated_at").get_to(it->updatedAt);
+    } else if (op == "update") {
+        rec.at("name").get_to(it->name);
+        rec.at("description").get_to(it->description);
+        rec.at("author").get_to(it->author);
+        rec.at("tags").get_to(it->tags);
+        rec.at("updated_at").get_to(it->updatedAt);
+    } else if (op == "content") {
+        rec.at("sha256").get_to(it->sha256);
+        rec.at("size").get_to(it->fileSizeBytes);
+        rec.at("updated_at").get_to(it->updatedAt);
+    }
+}
+
+// Offset just past the last '\n' of a journal of this size (0 if none)
+uint64_t endOfLastLine(const std::string& path, uint64_t size) {
+    std::ifstream in(path, std::ios::binary);
+    char buf[4096];
+    while (in && size > 0) {
+        uint64_t n = std::min<uint64_t>(size, sizeof(buf));
+        in.seekg(static_cast<std::streamoff>(size - n));
+        if (!in.read(buf, static_cast<std::streamsize>(n))) break;
+        for (uint64_t i = n; i > 0; --i) {
+            if (buf[i - 1] == '\n') return size - n + i;
+        }
+        size -= n;
+    }
+    return 0;
+}
+
+} // namespace
+
+bool appendJournalRecord(const std::string& path, const SnapshotSource& base, const nlohmann::json& record) {
+    uint64_t size = journalSize(path);
+    if (size > 0) {
+        // A crash mid-append leaves a line without its '\n'; cut it off so
+        // this record starts a line of its own instead of joining it
+        uint64_t keep = endOfLastLine(path, size);
+        if (keep != size) {
+            std::error_code ec;
+            std::filesystem::resize_file(path, keep, ec);
+            if (ec) return false;
+            logger::warning("Index journal: dropped incomplete record");
+            size = keep;
+        }
+    }
+    std::string text;
+    if (size == 0) {
+        nlohmann::json header = {{"base", {{"size", base.size}, {"mtime", base.mtime}}}};
+        text = header.dump() + '\n';
+    }
+    text += record.dump() + '\n';
+
+    std::FILE* out = std::fopen(path.c_str(), "ab");
+    if (!out) return false;
+    // The journal is the only durable copy of the mutation until compaction
+    bool ok = std::fwrite(text.data(), 1, text.size(), out) == text.size() && fs::syncFile(out);
+    return std::fclose(out) == 0 && ok;
+}
+
+bool replayJournal(const std::string& path, const SnapshotSource& base, RepoIndex& index, std::size_t& applied) {
+    applied = 0;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return true; // nothing to replay
+
+    std::string line;
+    if (!std::getline(in, line)) return true;
+    nlohmann::json header = nlohmann::json::parse(line, nullptr, false);
+    if (header.is_discarded() || !header.contains("base") ||
+        header["base"].value("size", uint64_t(0)) != base.size ||
+        header["base"].value("mtime", int64_t(0)) != base.mtime) {
+        logger::warning("Index journal does not match index.json, ignoring: " + path);
+        return false;
+    }
+
+    Replay replay(index);
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        nlohmann::json rec = nlohmann::json::parse(line, nullptr, false);
+        if (rec.is_discarded()) {
+            // Interrupted append; the records around it are intact
+            logger::warning("Index journal: skipped incomplete record");
+            continue;
+        }
+        try {
+            replay.apply(rec);
+            ++applied;
+        } catch (const std::exception& e) {
+            logger::warning(std::string("Index journal: bad record: ") + e.what());
+        }
+    }
+    replay.finish();
+    return true;
+}
+
+uint64_t journalSize(const std::string& path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+void clearJournal(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+} // namespace core
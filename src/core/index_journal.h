@@ -0,0 +1,40 @@
+#ifndef CORE_INDEX_JOURNAL_H
+#define CORE_INDEX_JOURNAL_H
+
+#include <string>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "types.h"
+#include "index_snapshot.h"
+
+namespace core {
+
+// Write-ahead log of index mutations (.repoman/index.journal).
+// One JSON object per line. The first line names the index.json it applies to
+// ({"base":{"size":..,"mtime":..}}); each following line is a mutation:
+//   {"op":"add","item":{...}}
+//   {"op":"remove","id":".."}
+//   {"op":"rename","id":"..","name":".."}
+//   {"op":"move","id":"..","path":"..","updated_at":..}
+//   {"op":"update","id":"..","name":"..","description":"..","author":"..","tags":[..],"updated_at":..}
+//   {"op":"content","id":"..","sha256":"..","size":..,"updated_at":..}
+// Records are idempotent so replaying a journal twice is harmless.
+
+// Appends one record and syncs it to disk, writing the base line first if
+// the journal is empty. A torn last line left by a crash is cut off first.
+bool appendJournalRecord(const std::string& path, const SnapshotSource& base, const nlohmann::json& record);
+
+// Applies the journal on top of index. A journal written against a different
+// index.json is stale and is ignored (returns false). A torn line from an
+// interrupted write is skipped. applied receives the record count.
+bool replayJournal(const std::string& path, const SnapshotSource& base, RepoIndex& index, std::size_t& applied);
+
+// Size of the journal in bytes, 0 if missing.
+uint64_t journalSize(const std::string& path);
+
+// Deletes the journal; called once its records are folded into index.json.
+void clearJournal(const std::string& path);
+
+} // namespace core
+
+#endif // CORE_INDEX_JOURNAL_H
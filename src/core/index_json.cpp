@@ -0,0 +1,481 @@
+#include "index_json.h"
+#include "../utils/mapped_file.h"
+#include "../system/fs.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+namespace {
+
+using json = nlohmann::json;
+
+// Lower bound on the bytes one item takes in index.json (every writer emits
+// all keys plus id and sha256). Bounds the reserve: item_count comes from
+// the file and may be wrong, or hostile in an index pulled from elsewhere.
+constexpr std::size_t kMinItemBytes = 192;
+
+enum ItemField : unsigned {
+    kId = 1u << 0,
+    kName = 1u << 1,
+    kType = 1u << 2,
+    kPath = 1u << 3,
+    kSha = 1u << 4,
+    kUpdated = 1u << 5,
+    kSize = 1u << 6,
+    kRequired = kId | kName | kType | kPath | kSha | kUpdated | kSize,
+};
+
+class IndexSax : public nlohmann::json_sax<json> {
+public:
+    IndexSax(RepoIndex& out, std::size_t textSize) : out(out), textSize(textSize) {}
+
+    const std::string& error() const { return errorMessage; }
+
+    bool null() override { return scalar("null"); }
+    bool boolean(bool) override { return scalar("boolean"); }
+    bool number_integer(number_integer_t value) override { return number(static_cast<uint64_t>(value), "number"); }
+    bool number_unsigned(number_unsigned_t value) override { return number(value, "number"); }
+    bool number_float(number_float_t value, const string_t&) override { return number(static_cast<uint64_t>(value), "number"); }
+    bool binary(binary_t&) override { return scalar("binary"); }
+
+    bool string(string_t& value) override {
+        if (skip > 0) return true;
+        switch (where) {
+        case Where::Top:
+            if (field == "version") out.version = std::move(value);
+            else if (field == "name") out.repositoryName = std::move(value);
+            else if (field == "description") out.repositoryDescription = std::move(value);
+            else if (field == "items" || field == "item_count") return wrongType("string");
+            return true;
+        case Where::Item:
+            return itemString(value);
+        case Where::Tags:
+            item.tags.push_back(std::move(value));
+            return true;
+        default:
+            return wrongType("string");
+        }
+    }
+
+    bool start_object(std::size_t) override {
+        if (skip > 0) { ++skip; return true; }
+        switch (where) {
+        case Where::Start:
+            where = Where::Top;
+            return true;
+        case Where::Items:
+            where = Where::Item;
+            item = ContentItem{};
+            seen = 0;
+            haveTags = false;
+            client.clear();
+            mod.clear();
+            return true;
+        case Where::Top:
+        case Where::Item:
+            if (known()) return wrongType("object");
+            skip = 1;
+            return true;
+        default:
+            return wrongType("object");
+        }
+    }
+
+    bool key(string_t& name) override {
+        if (skip == 0) field = std::move(name);
+        return true;
+    }
+
+    bool end_object() override {
+        if (skip > 0) { --skip; return true; }
+        if (where == Where::Item) return finishItem();
+        where = Where::Done;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (skip > 0) { ++skip; return true; }
+        if (where == Where::Top && field == "items") {
+            where = Where::Items;
+            out.items.clear();
+            std::size_t fits = textSize / kMinItemBytes;
+            out.items.reserve(itemCount ? std::min(itemCount, fits) : fits);
+            return true;
+        }
+        if (where == Where::Item && field == "tags") {
+            where = Where::Tags;
+            item.tags.clear();
+            haveTags = true;
+            return true;
+        }
+        if ((where == Where::Top || where == Where::Item) && !known()) {
+            skip = 1;
+            return true;
+        }
+        return wrongType("array");
+    }
+
+    bool end_array() override {
+        if (skip > 0) { --skip; return true; }
+        where = where == Where::Tags ? Where::Item : Where::Top;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override {
+        errorMessage = ex.what();
+        return false;
+    }
+
+private:
+    enum class Where { Start, Top, Items, Item, Tags, Done };
+
+    RepoIndex& out;
+    std::size_t textSize;
+    std::size_t itemCount = 0;
+    std::string errorMessage;
+    Where where = Where::Start;
+    int skip = 0;          // depth inside a value of an unknown key
+    std::string field;     // last key at the current level
+    ContentItem item;
+    unsigned seen = 0;     // ItemField bits
+    bool haveTags = false;
+    std::string client, mod;
+
+    // Keys whose values this reader converts (and so type-checks)
+    bool known() const {
+        static const char* const top[] = {"version", "name", "description", "items", "item_count"};
+        static const char* const fields[] = {"id", "name", "description", "author", "type", "relative_path", "sha256",
+                                             "tags", "download_url", "updated_at", "file_size", "client", "mod"};
+        if (where == Where::Top) {
+            for (const char* k : top) if (field == k) return true;
+        } else if (where == Where::Item) {
+            for (const char* k : fields) if (field == k) return true;
+        }
+        return false;
+    }
+
+    bool wrongType(const char* what) {
+        if (where == Where::Start) errorMessage = "index.json is not an object";
+        else if (where == Where::Items) errorMessage = std::string("unexpected ") + what + " in items";
+        else if (where == Where::Tags) errorMessage = std::string("unexpected ") + what + " in tags";
+        else errorMessage = std::string("unexpected ") + what + " for '" + field + "'";
+        return false;
+    }
+
+    bool scalar(const char* what) {
+        if (skip > 0) return true;
+        if ((where == Where::Top || where == Where::Item) && !known()) return true;
+        return wrongType(what);
+    }
+
+    bool number(uint64_t value, const char* what) {
+        if (skip > 0) return true;
+        if (where == Where::Top && field == "item_count") {
+            itemCount = static_cast<std::size_t>(value);
+            return true;
+        }
+        if (where == Where::Item && field == "updated_at") {
+            item.updatedAt = value;
+            seen |= kUpdated;
+            return true;
+        }
+        if (where == Where::Item && field == "file_size") {
+            item.fileSizeBytes = value;
+            seen |= kSize;
+            return true;
+        }
+        return scalar(what);
+    }
+
+    bool itemString(std::string& value) {
+        if (field == "id") { item.id = std::move(value); seen |= kId; }
+        else if (field == "name") { item.name = std::move(value); seen |= kName; }
+        else if (field == "description") item.description = std::move(value);
+        else if (field == "author") item.author = std::move(value);
+        else if (field == "type") { item.type = contentTypeFromString(value); seen |= kType; }
+        else if (field == "relative_path") { item.relativePath = std::move(value); seen |= kPath; }
+        else if (field == "sha256") { item.sha256 = std::move(value); seen |= kSha; }
+        else if (field == "download_url") item.downloadUrl = std::move(value);
+        else if (field == "client") client = std::move(value);
+        else if (field == "mod") mod = std::move(value);
+        else if (known()) return wrongType("string");
+        return true;
+    }
+
+    bool finishItem() {
+        if ((seen & kRequired) != kRequired) {
+            static const std::pair<unsigned, const char*> names[] = {
+                {kId, "id"}, {kName, "name"}, {kType, "type"}, {kPath, "relative_path"},
+                {kSha, "sha256"}, {kUpdated, "updated_at"}, {kSize, "file_size"}};
+            for (const auto& [bit, name] : names) {
+                if (!(seen & bit)) {
+                    errorMessage = "item " + std::to_string(out.items.size()) + " has no '" + name + "'";
+                    break;
+                }
+            }
+            return false;
+        }
+        // client/mod moved into tags; an explicit tags list wins, as in from_json
+        if (!haveTags) {
+            if (!client.empty()) item.tags.push_back("client:" + client);
+            if (!mod.empty()) item.tags.push_back("mod:" + mod);
+        }
+        out.items.push_back(std::move(item));
+        where = Where::Items;
+        return true;
+    }
+};
+
+constexpr std::size_t kWriteBuffer = 1 << 20;
+
+// Length of the UTF-8 sequence at s[i] if it is well formed (no overlong
+// forms, surrogates or code points past U+10FFFF), else 0
+std::size_t utf8Length(const std::string& s, std::size_t i) {
+    auto byte = [&](std::size_t k) { return static_cast<unsigned char>(s[k]); };
+    unsigned char c = byte(i);
+    std::size_t n = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+    if (n == 0 || i + n > s.size()) return 0;
+    for (std::size_t k = 1; k < n; ++k) {
+        if ((byte(i + k) & 0xC0) != 0x80) return 0;
+    }
+    if (n == 2 && c < 0xC2) return 0;
+    if (n == 3) {
+        unsigned char d = byte(i + 1);
+        if ((c == 0xE0 && d < 0xA0) || (c == 0xED && d >= 0xA0)) return 0;
+    }
+    if (n == 4) {
+        unsigned char d = byte(i + 1);
+        if ((c == 0xF0 && d < 0x90) || (c == 0xF4 && d >= 0x90) || c > 0xF4) return 0;
+    }
+    return n;
+}
+
+// Buffered index.json writer; layout follows nlohmann's dump(), keys in
+// the sorted order a json object would give them
+class IndexWriter {
+public:
+    IndexWriter(std::FILE* file, bool compact) : file(file), compact(compact) { buffer.reserve(kWriteBuffer); }
+
+    bool write(const RepoIndex& index, const std::string& treeRoot) {
+        put('{');
+        key("description", 1, true); str(index.repositoryDescription);
+        key("item_count", 1); num(index.items.size());
+        key("items", 1);
+        if (index.items.empty()) {
+            put("[]");
+        } else {
+            put('[');
+            for (std::size_t i = 0; i < index.items.size(); ++i) {
+                if (i > 0) put(',');
+                newline(2);
+                item(index.items[i]);
+            }
+            newline(1);
+            put(']');
+        }
+        key("name", 1); str(index.repositoryName);
+        key("tree_root", 1); str(treeRoot);
+        key("version", 1); str(index.version);
+        newline(0);
+        put('}');
+        return flush() && ok;
+    }
+
+    const std::string& error() const { return errorMessage; }
+
+private:
+    std::FILE* file;
+    bool compact;
+    std::string buffer;
+    bool ok = true;
+    std::string errorMessage;
+
+    void item(const ContentItem& v) {
+        put('{');
+        key("author", 3, true); str(v.author);
+        key("description", 3); str(v.description);
+        key("download_url", 3); str(v.downloadUrl);
+        key("file_size", 3); num(v.fileSizeBytes);
+        key("id", 3); str(v.id);
+        key("name", 3); str(v.name);
+        key("relative_path", 3); str(v.relativePath);
+        key("sha256", 3); str(v.sha256);
+        key("tags", 3);
+        if (v.tags.empty()) {
+            put("[]");
+        } else {
+            put('[');
+            for (std::size_t i = 0; i < v.tags.size(); ++i) {
+                if (i > 0) put(',');
+                newline(4);
+                str(v.tags[i]);
+            }
+            newline(3);
+            put(']');
+        }
+        key("type", 3);
+        put('"'); put(v.type == ContentType::PK3 ? "pk3" : v.type == ContentType::CFG ? "cfg" : "exe"); put('"');
+        key("updated_at", 3); num(v.updatedAt);
+        newline(2);
+        put('}');
+    }
+
+    void put(char c) {
+        buffer.push_back(c);
+        if (buffer.size() >= kWriteBuffer) flush();
+    }
+    void put(const char* s) {
+        buffer.append(s);
+        if (buffer.size() >= kWriteBuffer) flush();
+    }
+    void newline(int level) {
+        if (compact) return;
+        put('\n');
+        buffer.append(static_cast<std::size_t>(level) * 2, ' ');
+    }
+    void key(const char* name, int level, bool first = false) {
+        if (!first) put(',');
+        newline(level);
+        put('"'); put(name); put(compact ? "\":" : "\": ");
+    }
+    void num(uint64_t value) { put(std::to_string(value).c_str()); }
+
+    void str(const std::string& s) {
+        static const char* hex = "0123456789abcdef";
+        put('"');
+        for (std::size_t i = 0; i < s.size();) {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            switch (c) {
+            case '"': put("\\\""); break;
+            case '\\': put("\\\\"); break;
+            case '\b': put("\\b"); break;
+            case '\f': put("\\f"); break;
+            case '\n': put("\\n"); break;
+            case '\r': put("\\r"); break;
+            case '\t': put("\\t"); break;
+            default:
+                if (c < 0x20) {
+                    char esc[7] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15], 0};
+                    put(esc);
+                } else {
+                    std::size_t n = utf8Length(s, i);
+                    if (n == 0) {
+                        if (ok) errorMessage = "invalid UTF-8 in string: " + s;
+                        ok = false;
+                        n = 1;
+                    }
+                    buffer.append(s, i, n);
+                    i += n;
+                    continue;
+                }
+            }
+            ++i;
+        }
+        put('"');
+    }
+
+    bool flush() {
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+            if (ok) errorMessage = "write failed";
+            ok = false;
+        }
+        buffer.clear();
+        return ok;
+    }
+};
+
+// Pushes the directory entry of a rename to the disk (POSIX only)
+void syncDirectory(const std::filesystem::path& dir) {
+#ifndef _WIN32
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fsync(fd);
+    ::close(fd);
+#else
+    (void)dir;
+#endif
+}
+
+} // namespace
+
+bool parseIndexJson(const char* data, std::size_t size, RepoIndex& out, std::string& errorMessage) {
+    RepoIndex parsed;
+    IndexSax sax(parsed, size);
+    if (!json::sax_parse(data, data + size, &sax)) {
+        errorMessage = sax.error().empty() ? "malformed index.json" : sax.error();
+        return false;
+    }
+    out = std::move(parsed);
+    return true;
+}
+
+bool readIndexJson(const std::string& path, RepoIndex& out, std::string& errorMessage) {
+    utils::MappedFile file;
+    if (!file.open(path)) {
+        errorMessage = "cannot read " + path;
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(file.data());
+    RepoIndex parsed;
+    bool ok = parseIndexJson(data ? data : "", file.size(), parsed, errorMessage);
+    if (file.truncated()) {
+        errorMessage = path + " shrank while being read";
+        return false;
+    }
+    if (ok) out = std::move(parsed);
+    return ok;
+}
+
+bool writeIndexJson(const std::string& path, const RepoIndex& index, const std::string& treeRoot,
+                    bool compact, std::string& errorMessage) {
+    std::filesystem::path target = std::filesystem::u8path(path);
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+#ifdef _WIN32
+    std::FILE* file = _wfopen(temp.c_str(), L"wb");
+#else
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+#endif
+    std::error_code ec;
+    if (!file) {
+        errorMessage = "cannot create " + temp.u8string();
+        return false;
+    }
+    IndexWriter writer(file, compact);
+    bool ok = writer.write(index, treeRoot);
+    if (!ok) errorMessage = writer.error();
+    if (ok && !fs::syncFile(file)) {
+        errorMessage = "cannot flush " + temp.u8string();
+        ok = false;
+    }
+    if (std::fclose(file) != 0 && ok) {
+        errorMessage = "cannot close " + temp.u8string();
+        ok = false;
+    }
+    if (ok) {
+        std::filesystem::rename(temp, target, ec);
+        if (ec) {
+            errorMessage = "cannot replace " + path + ": " + ec.message();
+            ok = false;
+        }
+    }
+    if (!ok) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    syncDirectory(target.parent_path());
+    return true;
+}
+
+} // namespace core
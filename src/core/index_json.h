@@ -0,0 +1,32 @@
+#ifndef CORE_INDEX_JSON_H
+#define CORE_INDEX_JSON_H
+
+#include <string>
+#include <cstddef>
+#include "types.h"
+
+namespace core {
+
+// Builds a RepoIndex from index.json text with nlohmann's SAX parser:
+// ContentItems are filled in as their fields arrive and no json DOM is
+// built. Follows from_json(RepoIndex): unknown keys are ignored, a missing
+// required item field or a value of the wrong type fails. The items vector
+// is reserved up front from "item_count" when it precedes "items" (as
+// saveIndex writes it), otherwise from the text size.
+bool parseIndexJson(const char* data, std::size_t size, RepoIndex& out, std::string& errorMessage);
+
+// Maps the file at path and parses it as above
+bool readIndexJson(const std::string& path, RepoIndex& out, std::string& errorMessage);
+
+// Serializes index, plus "tree_root" and "item_count", straight from the
+// items into a 1 MiB buffer (no json DOM, no second copy of the index).
+// Pretty output matches nlohmann's dump(2) byte for byte; compact output
+// has no whitespace. The text goes to <path>.tmp, is flushed to disk and
+// renamed over path, so readers and crashes see the old or the new index,
+// never a partial one. Fails on strings that are not valid UTF-8.
+bool writeIndexJson(const std::string& path, const RepoIndex& index, const std::string& treeRoot,
+                    bool compact, std::string& errorMessage);
+
+} // namespace core
+
+#endif // CORE_INDEX_JSON_H
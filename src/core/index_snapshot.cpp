@@ -0,0 +1,212 @@
+#include "index_snapshot.h"
+#include "../utils/mapped_file.h"
+
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <vector>
+#include <cstdint>
+
+namespace core {
+
+namespace {
+
+constexpr char kMagic[8] = {'R','M','I','D','X','B','I','N'};
+constexpr uint32_t kFormatVersion = 1;
+
+struct StrRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Header {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t recordSize;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint32_t itemCount;
+    uint32_t tagCount;
+    uint64_t recordsOffset;
+    uint64_t tagsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    StrRef version;
+    StrRef repositoryName;
+    StrRef repositoryDescription;
+    uint32_t reserved;
+};
+
+struct Record {
+    StrRef id;
+    StrRef name;
+    StrRef description;
+    StrRef author;
+    StrRef relativePath;
+    StrRef sha256;
+    StrRef downloadUrl;
+    uint32_t type;
+    uint32_t tagFirst;
+    uint32_t tagCount;
+    uint32_t reserved;
+    uint64_t updatedAt;
+    uint64_t fileSizeBytes;
+};
+
+class StringTable {
+public:
+    StrRef add(const std::string& s) {
+        StrRef r{static_cast<uint32_t>(bytes.size()), static_cast<uint32_t>(s.size())};
+        bytes.insert(bytes.end(), s.begin(), s.end());
+        return r;
+    }
+    const std::vector<char>& data() const { return bytes; }
+private:
+    std::vector<char> bytes;
+};
+
+bool refInRange(const StrRef& r, uint64_t stringsSize) {
+    return static_cast<uint64_t>(r.offset) + r.length <= stringsSize;
+}
+
+} // namespace
+
+bool statSnapshotSource(const std::string& path, SnapshotSource& out) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    out.size = static_cast<uint64_t>(size);
+    out.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    return true;
+}
+
+bool writeIndexSnapshot(const std::string& path, const RepoIndex& index, const SnapshotSource& source) {
+    StringTable strings;
+    std::vector<Record> records;
+    std::vector<StrRef> tags;
+    records.reserve(index.items.size());
+
+    for (const auto& it : index.items) {
+        Record r{};
+        r.id = strings.add(it.id);
+        r.name = strings.add(it.name);
+        r.description = strings.add(it.description);
+        r.author = strings.add(it.author);
+        r.relativePath = strings.add(it.relativePath);
+        r.sha256 = strings.add(it.sha256);
+        r.downloadUrl = strings.add(it.downloadUrl);
+        r.type = static_cast<uint32_t>(it.type);
+        r.tagFirst = static_cast<uint32_t>(tags.size());
+        r.tagCount = static_cast<uint32_t>(it.tags.size());
+        for (const auto& t : it.tags) tags.push_back(strings.add(t));
+        r.updatedAt = it.updatedAt;
+        r.fileSizeBytes = it.fileSizeBytes;
+        records.push_back(r);
+    }
+
+    Header h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.formatVersion = kFormatVersion;
+    h.recordSize = sizeof(Record);
+    h.sourceSize = source.size;
+    h.sourceMtime = source.mtime;
+    h.itemCount = static_cast<uint32_t>(records.size());
+    h.tagCount = static_cast<uint32_t>(tags.size());
+    h.version = strings.add(index.version);
+    h.repositoryName = strings.add(index.repositoryName);
+    h.repositoryDescription = strings.add(index.repositoryDescription);
+    h.recordsOffset = sizeof(Header);
+    h.tagsOffset = h.recordsOffset + records.size() * sizeof(Record);
+    h.stringsOffset = h.tagsOffset + tags.size() * sizeof(StrRef);
+    h.stringsSize = strings.data().size();
+    if (h.stringsSize > UINT32_MAX) return false; // string refs are 32-bit
+
+    // Write next to the target and rename so readers never map a partial file
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        if (!records.empty()) out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+        if (!tags.empty()) out.write(reinterpret_cast<const char*>(tags.data()), tags.size() * sizeof(StrRef));
+        if (!strings.data().empty()) out.write(strings.data().data(), strings.data().size());
+        if (!out.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool readIndexSnapshot(const std::string& path, const SnapshotSource& expected, RepoIndex& out) {
+    utils::MappedFile file;
+    if (!file.open(path)) return false;
+    if (file.size() < sizeof(Header)) return false;
+
+    Header h;
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) return false;
+    if (h.formatVersion != kFormatVersion || h.recordSize != sizeof(Record)) return false;
+    if (h.sourceSize != expected.size || h.sourceMtime != expected.mtime) return false;
+
+    const uint64_t total = file.size();
+    if (h.recordsOffset != sizeof(Header)) return false;
+    if (h.tagsOffset != h.recordsOffset + static_cast<uint64_t>(h.itemCount) * sizeof(Record)) return false;
+    if (h.stringsOffset != h.tagsOffset + static_cast<uint64_t>(h.tagCount) * sizeof(StrRef)) return false;
+    if (h.stringsOffset + h.stringsSize != total) return false;
+
+    const unsigned char* base = file.data();
+    const char* strings = reinterpret_cast<const char*>(base + h.stringsOffset);
+    auto str = [&](const StrRef& r) { return std::string(strings + r.offset, r.length); };
+
+    if (!refInRange(h.version, h.stringsSize) ||
+        !refInRange(h.repositoryName, h.stringsSize) ||
+        !refInRange(h.repositoryDescription, h.stringsSize)) return false;
+
+    RepoIndex idx;
+    idx.version = str(h.version);
+    idx.repositoryName = str(h.repositoryName);
+    idx.repositoryDescription = str(h.repositoryDescription);
+    idx.items.resize(h.itemCount);
+
+    for (uint32_t i = 0; i < h.itemCount; ++i) {
+        Record r;
+        std::memcpy(&r, base + h.recordsOffset + static_cast<uint64_t>(i) * sizeof(Record), sizeof(Record));
+        const StrRef* refs[] = {&r.id, &r.name, &r.description, &r.author, &r.relativePath, &r.sha256, &r.downloadUrl};
+        for (const StrRef* ref : refs) {
+            if (!refInRange(*ref, h.stringsSize)) return false;
+        }
+        if (static_cast<uint64_t>(r.tagFirst) + r.tagCount > h.tagCount) return false;
+        if (r.type > static_cast<uint32_t>(ContentType::EXECUTABLE)) return false;
+
+        ContentItem& item = idx.items[i];
+        item.id = str(r.id);
+        item.name = str(r.name);
+        item.description = str(r.description);
+        item.author = str(r.author);
+        item.type = static_cast<ContentType>(r.type);
+        item.relativePath = str(r.relativePath);
+        item.sha256 = str(r.sha256);
+        item.downloadUrl = str(r.downloadUrl);
+        item.updatedAt = r.updatedAt;
+        item.fileSizeBytes = r.fileSizeBytes;
+        item.tags.reserve(r.tagCount);
+        for (uint32_t t = 0; t < r.tagCount; ++t) {
+            StrRef tr;
+            std::memcpy(&tr, base + h.tagsOffset + static_cast<uint64_t>(r.tagFirst + t) * sizeof(StrRef), sizeof(StrRef));
+            if (!refInRange(tr, h.stringsSize)) return false;
+            item.tags.push_back(str(tr));
+        }
+    }
+    if (file.truncated()) return false;
+
+    out = std::move(idx);
+    return true;
+}
+
+} // namespace core
@@ -0,0 +1,31 @@
+#ifndef CORE_INDEX_SNAPSHOT_H
+#define CORE_INDEX_SNAPSHOT_H
+
+#include <string>
+#include <cstdint>
+#include "types.h"
+
+namespace core {
+
+// Identity of the index.json a snapshot was built from. A snapshot is only
+// used when both values still match the file on disk.
+struct SnapshotSource {
+    uint64_t size = 0;
+    int64_t mtime = 0; // filesystem clock ticks
+};
+
+// Reads size and modification time of a file; false if it does not exist.
+bool statSnapshotSource(const std::string& path, SnapshotSource& out);
+
+// Binary mirror of index.json (.repoman/index.bin): a fixed header, one
+// fixed-width record per item and a shared string table. The file is a local
+// cache in host byte order; index.json remains the interchange format.
+bool writeIndexSnapshot(const std::string& path, const RepoIndex& index, const SnapshotSource& source);
+
+// Maps the snapshot and decodes it into out. Returns false when the file is
+// missing, malformed or was built from a different index.json.
+bool readIndexSnapshot(const std::string& path, const SnapshotSource& expected, RepoIndex& out);
+
+} // namespace core
+
+#endif // CORE_INDEX_SNAPSHOT_H
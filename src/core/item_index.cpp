@@ -0,0 +1,104 @@
+#include "item_index.h"
+
+#include <algorithm>
+
+namespace core {
+
+uint64_t ItemHashIndex::hashKey(const std::string& key) {
+    // FNV-1a, 64-bit
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+void ItemHashIndex::clear() {
+    slots.clear();
+    used = 0;
+    tombstones = 0;
+}
+
+void ItemHashIndex::rebuild(const std::vector<ContentItem>& items) {
+    clear();
+    grow(items, items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) insert(items, i);
+}
+
+void ItemHashIndex::grow(const std::vector<ContentItem>& items, std::size_t minEntries) {
+    // Keep the load factor (live + tombstones) at or below one half
+    std::size_t capacity = 16;
+    while (capacity < minEntries * 2) capacity *= 2;
+
+    std::vector<uint32_t> old;
+    old.swap(slots);
+    slots.assign(capacity, kEmpty);
+    used = 0;
+    tombstones = 0;
+
+    const std::size_t mask = capacity - 1;
+    for (uint32_t s : old) {
+        if (s == kEmpty || s == kTombstone) continue;
+        std::size_t i = static_cast<std::size_t>(hashKey(items[s - 1].*field)) & mask;
+        while (slots[i] != kEmpty) i = (i + 1) & mask;
+        slots[i] = s;
+        ++used;
+    }
+}
+
+void ItemHashIndex::insert(const std::vector<ContentItem>& items, std::size_t pos) {
+    if (slots.empty() || (used + tombstones + 1) * 2 > slots.size()) grow(items, used + 1);
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = static_cast<std::size_t>(hashKey(items[pos].*field)) & mask;
+    while (slots[i] != kEmpty && slots[i] != kTombstone) i = (i + 1) & mask;
+    if (slots[i] == kTombstone) --tombstones;
+    slots[i] = static_cast<uint32_t>(pos + 1);
+    ++used;
+}
+
+void ItemHashIndex::erase(const std::vector<ContentItem>& items, std::size_t pos) {
+    if (slots.empty()) return;
+    const std::size_t mask = slots.size() - 1;
+    const uint32_t target = static_cast<uint32_t>(pos + 1);
+    std::size_t i = static_cast<std::size_t>(hashKey(items[pos].*field)) & mask;
+    while (slots[i] != kEmpty) {
+        if (slots[i] == target) {
+            slots[i] = kTombstone;
+            --used;
+            ++tombstones;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+std::size_t ItemHashIndex::find(const std::vector<ContentItem>& items, const std::string& key) const {
+    if (slots.empty()) return npos;
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = static_cast<std::size_t>(hashKey(key)) & mask;
+    std::size_t best = npos;
+    // Walk the whole probe run so duplicates resolve to the earliest item
+    while (slots[i] != kEmpty) {
+        uint32_t s = slots[i];
+        if (s != kTombstone && s - 1 < best && items[s - 1].*field == key) best = s - 1;
+        i = (i + 1) & mask;
+    }
+    return best;
+}
+
+std::vector<std::size_t> ItemHashIndex::findAll(const std::vector<ContentItem>& items, const std::string& key) const {
+    std::vector<std::size_t> out;
+    if (slots.empty()) return out;
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = static_cast<std::size_t>(hashKey(key)) & mask;
+    while (slots[i] != kEmpty) {
+        uint32_t s = slots[i];
+        if (s != kTombstone && items[s - 1].*field == key) out.push_back(s - 1);
+        i = (i + 1) & mask;
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+} // namespace core
@@ -0,0 +1,50 @@
+#ifndef CORE_ITEM_INDEX_H
+#define CORE_ITEM_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "types.h"
+
+namespace core {
+
+// Open-addressing hash index over one string field of ContentItem.
+// Slots hold item positions in RepoIndex::items, not copies of the keys; keys
+// are compared by reading the field from the item. Linear probing with
+// tombstones; several items may share a key (duplicate paths or digests).
+class ItemHashIndex {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    explicit ItemHashIndex(std::string ContentItem::*field) : field(field) {}
+
+    // Drops all entries and indexes every item
+    void rebuild(const std::vector<ContentItem>& items);
+    void clear();
+
+    // items[pos] must already hold the key being inserted/erased
+    void insert(const std::vector<ContentItem>& items, std::size_t pos);
+    void erase(const std::vector<ContentItem>& items, std::size_t pos);
+
+    // Earliest item position with this key, or npos
+    std::size_t find(const std::vector<ContentItem>& items, const std::string& key) const;
+    // All item positions with this key, in item order
+    std::vector<std::size_t> findAll(const std::vector<ContentItem>& items, const std::string& key) const;
+
+private:
+    static constexpr uint32_t kEmpty = 0;
+    static constexpr uint32_t kTombstone = UINT32_MAX;
+
+    std::string ContentItem::*field;
+    std::vector<uint32_t> slots; // position + 1, kEmpty or kTombstone
+    std::size_t used = 0;        // live entries
+    std::size_t tombstones = 0;
+
+    static uint64_t hashKey(const std::string& key);
+    void grow(const std::vector<ContentItem>& items, std::size_t minEntries);
+};
+
+}
+
+#endif // CORE_ITEM_INDEX_H
@@ -0,0 +1,161 @@
+#include "merkle.h"
+#include "../utils/sha256.h"
+
+#include <algorithm>
+
+namespace core {
+
+namespace {
+
+std::string joinPath(const std::string& dir, const std::string& name) {
+    return dir.empty() ? name : dir + "/" + name;
+}
+
+std::size_t depth(const std::string& relativeDir) {
+    if (relativeDir.empty()) return 0;
+    return 1 + static_cast<std::size_t>(std::count(relativeDir.begin(), relativeDir.end(), '/'));
+}
+
+} // namespace
+
+MerkleTree MerkleTree::build(const std::vector<ContentItem>& items) {
+    MerkleTree tree;
+    tree.dirs[""];
+    for (const auto& it : items) {
+        // Register every ancestor directory, then the file in its parent
+        std::string dir;
+        std::size_t start = 0;
+        for (;;) {
+            std::size_t slash = it.relativePath.find('/', start);
+            if (slash == std::string::npos) break;
+            std::string name = it.relativePath.substr(start, slash - start);
+            if (!name.empty()) {
+                tree.dirs[dir][name].directory = true;
+                dir = joinPath(dir, name);
+                tree.dirs[dir];
+            }
+            start = slash + 1;
+        }
+        std::string name = it.relativePath.substr(start);
+        if (name.empty()) continue;
+        Entry& e = tree.dirs[dir][name];
+        e.directory = false;
+        e.hash = it.sha256;
+    }
+
+    // Deepest directories first so every subtree hash is known before its parent
+    std::vector<const std::string*> order;
+    order.reserve(tree.dirs.size());
+    for (const auto& kv : tree.dirs) order.push_back(&kv.first);
+    std::stable_sort(order.begin(), order.end(), [](const std::string* a, const std::string* b) {
+        return depth(*a) > depth(*b);
+    });
+    for (const std::string* dir : order) {
+        utils::sha256::Hasher h;
+        for (const auto& [name, e] : tree.dirs[*dir]) {
+            std::string line = (e.directory ? "tree " : "blob ") + name;
+            line.push_back('\0');
+            line += e.hash;
+            line.push_back('\n');
+            h.update(line.data(), line.size());
+        }
+        std::string hash = utils::sha256::toHex(h.finish());
+        if (dir->empty()) {
+            tree.root = hash;
+        } else {
+            std::size_t slash = dir->rfind('/');
+            std::string parent = slash == std::string::npos ? std::string() : dir->substr(0, slash);
+            std::string name = slash == std::string::npos ? *dir : dir->substr(slash + 1);
+            tree.dirs[parent][name].hash = hash;
+        }
+    }
+    return tree;
+}
+
+const MerkleTree::Children* MerkleTree::children(const std::string& relativeDir) const {
+    auto it = dirs.find(relativeDir);
+    return it == dirs.end() ? nullptr : &it->second;
+}
+
+std::string MerkleTree::directoryHash(const std::string& relativeDir) const {
+    if (relativeDir.empty()) return root;
+    std::size_t slash = relativeDir.rfind('/');
+    const Children* parent = children(slash == std::string::npos ? std::string() : relativeDir.substr(0, slash));
+    if (!parent) return "";
+    auto it = parent->find(slash == std::string::npos ? relativeDir : relativeDir.substr(slash + 1));
+    return it != parent->end() && it->second.directory ? it->second.hash : std::string();
+}
+
+void MerkleTree::collectFiles(const std::string& relativeDir, TreeChange::Kind kind, std::vector<TreeChange>& out) const {
+    const Children* list = children(relativeDir);
+    if (!list) return;
+    for (const auto& [name, e] : *list) {
+        std::string path = joinPath(relativeDir, name);
+        if (e.directory) collectFiles(path, kind, out);
+        else out.push_back({kind, path});
+    }
+}
+
+std::vector<TreeChange> MerkleTree::diff(const MerkleTree& from, const MerkleTree& to, std::size_t* visited) {
+    std::vector<TreeChange> out;
+    std::size_t compared = 1;
+    if (from.root != to.root) {
+        // Explicit stack of directories whose hashes differ
+        std::vector<std::string> pending{""};
+        while (!pending.empty()) {
+            std::string dir = pending.back();
+            pending.pop_back();
+            static const Children kNone;
+            const Children* a = from.children(dir);
+            const Children* b = to.children(dir);
+            if (!a) a = &kNone;
+            if (!b) b = &kNone;
+
+            std::vector<std::string> subdirs;
+            auto ia = a->begin();
+            auto ib = b->begin();
+            while (ia != a->end() || ib != b->end()) {
+                int order = ia == a->end() ? 1 : ib == b->end() ? -1 : ia->first.compare(ib->first);
+                if (order < 0) {
+                    std::string path = joinPath(dir, ia->first);
+                    if (ia->second.directory) from.collectFiles(path, TreeChange::Kind::Removed, out);
+                    else out.push_back({TreeChange::Kind::Removed, path});
+                    ++ia;
+                } else if (order > 0) {
+                    std::string path = joinPath(dir, ib->first);
+                    if (ib->second.directory) to.collectFiles(path, TreeChange::Kind::Added, out);
+                    else out.push_back({TreeChange::Kind::Added, path});
+                    ++ib;
+                } else {
+                    std::string path = joinPath(dir, ia->first);
+                    const Entry& ea = ia->second;
+                    const Entry& eb = ib->second;
+                    if (ea.hash != eb.hash || ea.directory != eb.directory) {
+                        if (ea.directory && eb.directory) {
+                            subdirs.push_back(path);
+                        } else if (!ea.directory && !eb.directory) {
+                            out.push_back({TreeChange::Kind::Modified, path});
+                        } else {
+                            // File replaced by a directory or the other way round
+                            if (ea.directory) from.collectFiles(path, TreeChange::Kind::Removed, out);
+                            else out.push_back({TreeChange::Kind::Removed, path});
+                            if (eb.directory) to.collectFiles(path, TreeChange::Kind::Added, out);
+                            else out.push_back({TreeChange::Kind::Added, path});
+                        }
+                    }
+                    ++ia;
+                    ++ib;
+                }
+            }
+            compared += subdirs.size();
+            for (auto it = subdirs.rbegin(); it != subdirs.rend(); ++it) pending.push_back(*it);
+        }
+        std::stable_sort(out.begin(), out.end(), [](const TreeChange& x, const TreeChange& y) {
+            return x.relativePath < y.relativePath;
+        });
+    }
+    if (visited) *visited = compared;
+    return out;
+}
+
+} // namespace core
@@ -0,0 +1,58 @@
+#ifndef CORE_MERKLE_H
+#define CORE_MERKLE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+#include "types.h"
+
+namespace core {
+
+// One path that differs between two trees
+struct TreeChange {
+    enum class Kind {
+        Added,    // only in the second tree
+        Removed,  // only in the first tree
+        Modified  // in both, different sha256
+    };
+    Kind kind;
+    std::string relativePath;
+};
+
+// Merkle summary of an index. Each directory hashes its children sorted by
+// name (kind, name and sha256 of files, subtree hash of directories), so two
+// indexes with equal root hashes list the same paths with the same content,
+// and a differing subtree can be located without looking at the rest.
+class MerkleTree {
+public:
+    static MerkleTree build(const std::vector<ContentItem>& items);
+
+    // Hex sha256 of the root directory
+    const std::string& rootHash() const { return root; }
+    // Hash of a directory relative to the repo root ("" = root); empty if absent
+    std::string directoryHash(const std::string& relativeDir) const;
+
+    // Paths that differ from `from` to `to`, in path order. Subtrees with
+    // equal hashes are skipped, so identical trees cost one comparison.
+    // visited (optional) receives the number of directories compared.
+    static std::vector<TreeChange> diff(const MerkleTree& from, const MerkleTree& to,
+                                        std::size_t* visited = nullptr);
+
+private:
+    struct Entry {
+        bool directory = false;
+        std::string hash;
+    };
+    using Children = std::map<std::string, Entry>; // name -> entry
+
+    std::map<std::string, Children> dirs; // relative dir -> children
+    std::string root;
+
+    const Children* children(const std::string& relativeDir) const;
+    void collectFiles(const std::string& relativeDir, TreeChange::Kind kind, std::vector<TreeChange>& out) const;
+};
+
+} // namespace core
+
+#endif // CORE_MERKLE_H
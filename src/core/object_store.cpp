@@ -0,0 +1,208 @@
+#include "object_store.h"
+#include "../system/logger.h"
+#include "../utils/hash.h"
+#include "../utils/file_stream.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <random>
+
+namespace core {
+
+namespace {
+
+const char* kTempPrefix = "tmp-";
+// Next to the file install() replaces, so the final rename stays on one filesystem
+const char* kInstallSuffix = ".objtmp";
+
+// See ObjectStore::setHardlinks
+bool hardlinksEnabled = false;
+
+bool isDigest(const std::string& name) {
+    if (name.size() != 64) return false;
+    for (char c : name) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
+
+// Hard links to a blob must not be written through; clear every write bit
+void makeReadOnly(const std::string& path) {
+    using std::filesystem::perms;
+    std::error_code ec;
+    std::filesystem::permissions(path, perms::owner_write | perms::group_write | perms::others_write,
+                                 std::filesystem::perm_options::remove, ec);
+}
+
+} // namespace
+
+void ObjectStore::setHardlinks(bool enabled) {
+    hardlinksEnabled = enabled;
+}
+
+bool ObjectStore::hardlinks() {
+    return hardlinksEnabled;
+}
+
+bool ObjectStore::enabled() const {
+    std::error_code ec;
+    return std::filesystem::is_directory(dir, ec);
+}
+
+bool ObjectStore::create() const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return !ec;
+}
+
+std::string ObjectStore::blobPath(const std::string& sha256) const {
+    return dir + "/" + sha256;
+}
+
+bool ObjectStore::contains(const std::string& sha256) const {
+    std::error_code ec;
+    return isDigest(sha256) && std::filesystem::is_regular_file(blobPath(sha256), ec);
+}
+
+std::string ObjectStore::tempPath() const {
+    static std::atomic<unsigned> counter{0};
+    std::random_device rd;
+    return dir + "/" + kTempPrefix + std::to_string(rd()) + "-" + std::to_string(counter++);
+}
+
+std::string ObjectStore::importFile(const std::string& sourcePath, uint64_t* size,
+                                    const std::function<void(const unsigned char*, std::size_t)>& observe) const {
+    // Copy and hash in one read of the source; a duplicate costs a temp write
+    std::string tmp = tempPath();
+    std::string copied = utils::copyFileSha256(sourcePath, tmp, size, observe);
+    if (copied.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+        return "";
+    }
+    std::error_code ec;
+    if (contains(copied)) {
+        std::filesystem::remove(tmp, ec);
+        return copied;
+    }
+    std::filesystem::rename(tmp, blobPath(copied), ec);
+    if (ec) {
+        logger::error("Object store: cannot add blob " + copied + ": " + ec.message());
+        std::filesystem::remove(tmp, ec);
+        return "";
+    }
+    return copied;
+}
+
+bool ObjectStore::adoptFile(const std::string& path, const std::string& sha256, bool& duplicate,
+                            LinkKind* kind) const {
+    duplicate = false;
+    if (!isDigest(sha256)) return false;
+    std::error_code ec;
+    std::string blob = blobPath(sha256);
+    if (contains(sha256)) {
+        if (std::filesystem::equivalent(path, blob, ec)) { // already linked
+            if (kind) *kind = LinkKind::Hardlink;
+            return true;
+        }
+        duplicate = true;
+        return install(sha256, path, kind);
+    }
+
+    // New content: the blob is cloned from the file, or is the file itself
+    if (utils::reflinkFile(path, blob)) {
+        if (kind) *kind = LinkKind::Reflink;
+        return true;
+    }
+    if (hardlinksEnabled) {
+        std::filesystem::create_hard_link(path, blob, ec);
+        if (!ec) {
+            makeReadOnly(blob);
+            if (kind) *kind = LinkKind::Hardlink;
+            return true;
+        }
+        ec.clear();
+    }
+    if (kind) *kind = LinkKind::Copy;
+    std::string tmp = tempPath();
+    std::filesystem::copy_file(path, tmp, ec);
+    if (!ec) std::filesystem::rename(tmp, blob, ec);
+    if (ec) {
+        logger::error("Object store: cannot add blob for " + path + ": " + ec.message());
+        std::error_code ec_rm;
+        std::filesystem::remove(tmp, ec_rm);
+        return false;
+    }
+    return true;
+}
+
+bool ObjectStore::install(const std::string& sha256, const std::string& destPath, LinkKind* kind) const {
+    // Built beside destPath and renamed over it, so a failure leaves the file as it was
+    std::string blob = blobPath(sha256);
+    std::string tmp = destPath + kInstallSuffix;
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    LinkKind made = LinkKind::Copy;
+    if (utils::reflinkFile(blob, tmp)) {
+        made = LinkKind::Reflink;
+    } else {
+        bool linked = false;
+        if (hardlinksEnabled) {
+            std::filesystem::create_hard_link(blob, tmp, ec);
+            linked = !ec;
+            ec.clear();
+        }
+        if (linked) {
+            makeReadOnly(blob);
+            made = LinkKind::Hardlink;
+        } else {
+            std::filesystem::copy_file(blob, tmp, std::filesystem::copy_options::overwrite_existing, ec);
+        }
+    }
+    if (!ec) std::filesystem::rename(tmp, destPath, ec);
+    if (ec) {
+        logger::error("Object store: cannot install " + destPath + ": " + ec.message());
+        std::error_code ec_rm;
+        std::filesystem::remove(tmp, ec_rm);
+        return false;
+    }
+    if (kind) *kind = made;
+    return true;
+}
+
+std::vector<std::string> ObjectStore::list() const {
+    std::vector<std::string> out;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (isDigest(name)) out.push_back(name);
+    }
+    return out;
+}
+
+bool ObjectStore::remove(const std::string& sha256, uint64_t& freed) const {
+    freed = 0;
+    std::string blob = blobPath(sha256);
+    std::error_code ec;
+    uintmax_t links = std::filesystem::hard_link_count(blob, ec);
+    uintmax_t size = std::filesystem::file_size(blob, ec);
+    if (!ec && links == 1) freed = static_cast<uint64_t>(size);
+    return std::filesystem::remove(blob, ec) && !ec;
+}
+
+void ObjectStore::removeTemporaries() const {
+    // Leave recent ones alone; another process may still be importing
+    const auto cutoff = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+    std::error_code ec;
+    std::vector<std::filesystem::path> stale;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().filename().string().rfind(kTempPrefix, 0) != 0) continue;
+        std::error_code ec_time;
+        auto mtime = std::filesystem::last_write_time(it->path(), ec_time);
+        if (!ec_time && mtime < cutoff) stale.push_back(it->path());
+    }
+    for (const auto& p : stale) std::filesystem::remove(p, ec);
+}
+
+} // namespace core
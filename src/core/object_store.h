@@ -0,0 +1,68 @@
+#ifndef CORE_OBJECT_STORE_H
+#define CORE_OBJECT_STORE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace core {
+
+// Content-addressable blob store: one file per distinct content, named by its
+// sha256 (.repoman/objects/<sha256>). Files in the repo are reflinks to their
+// blob where the filesystem supports it, so identical content is stored once;
+// otherwise they are copies, or read-only hard links if those are enabled.
+class ObjectStore {
+public:
+    enum class LinkKind { Reflink, Hardlink, Copy };
+
+    explicit ObjectStore(std::string dir) : dir(std::move(dir)) {}
+
+    const std::string& directory() const { return dir; }
+    // The store is in use once its directory exists
+    bool enabled() const;
+    bool create() const;
+
+    std::string blobPath(const std::string& sha256) const;
+    bool contains(const std::string& sha256) const;
+
+    // Stores the content of sourcePath and returns its digest (empty on
+    // error). The source is read once, copied and hashed in the same pass;
+    // the copy is dropped if the store already had that content. observe
+    // sees the data as it is hashed (see utils::copyFileSha256).
+    std::string importFile(const std::string& sourcePath, uint64_t* size = nullptr,
+                           const std::function<void(const unsigned char*, std::size_t)>& observe = nullptr) const;
+    // Takes over a file already in the repo: it becomes (or is linked to)
+    // the blob for sha256. Sets duplicate when the blob already existed;
+    // kind tells how path now relates to the blob.
+    bool adoptFile(const std::string& path, const std::string& sha256, bool& duplicate,
+                   LinkKind* kind = nullptr) const;
+    // Replaces destPath with a reflink to the blob, else a hard link (if
+    // enabled), else a copy
+    bool install(const std::string& sha256, const std::string& destPath, LinkKind* kind = nullptr) const;
+
+    // Allows hard links when reflinks are unavailable. A hard link shares
+    // one inode between the blob and every path holding that content, so
+    // an edit made in place would change them all; linked blobs are made
+    // read-only to keep that from happening silently. Process-wide, from
+    // config; off by default.
+    static void setHardlinks(bool enabled);
+    static bool hardlinks();
+
+    // Digests of all blobs
+    std::vector<std::string> list() const;
+    // Deletes a blob; freed is its size if no other path links to it
+    bool remove(const std::string& sha256, uint64_t& freed) const;
+    // Deletes temp files (older than an hour) left by interrupted imports
+    void removeTemporaries() const;
+
+private:
+    std::string dir;
+
+    std::string tempPath() const;
+};
+
+}
+
+#endif // CORE_OBJECT_STORE_H
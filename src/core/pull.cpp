@@ -0,0 +1,542 @@
+#include "pull.h"
+#include "repo.h"
+#include "hash_cache.h"
+#include "index_json.h"
+#include "../system/logger.h"
+#include "../utils/hash.h"
+#include "../utils/sha256.h"
+#include "../utils/parallel.h"
+#include "../utils/path.h"
+#include "../utils/zip.h"
+#include "../utils/http.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace core {
+
+namespace {
+
+constexpr std::size_t kCopyBlock = 1 << 20;
+constexpr unsigned kDefaultDownloads = 8;
+const char* kTempSuffix = ".pulltmp";
+
+// Digest by path of the items a pull last brought in ("<sha256> <path>" lines
+// in RepoManager::getPullBasePath); tells files that came from upstream apart
+// from ones added or edited locally
+std::unordered_map<std::string, std::string> loadPullBase(const std::string& path) {
+    std::unordered_map<std::string, std::string> base;
+    std::ifstream in(std::filesystem::u8path(path), std::ios::binary);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.size() < 66 || line[64] != ' ') continue;
+        base[line.substr(65)] = line.substr(0, 64);
+    }
+    return base;
+}
+
+void savePullBase(const std::string& path, const RepoIndex& index) {
+    std::string temp = path + kTempSuffix;
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::u8path(path).parent_path(), ec);
+    {
+        std::ofstream out(std::filesystem::u8path(temp), std::ios::binary | std::ios::trunc);
+        for (const auto& item : index.items) {
+            if (item.sha256.size() != 64) continue;
+            out << item.sha256 << ' ' << utils::normalizeRelative(item.relativePath) << '\n';
+        }
+        if (!out) {
+            logger::warning("pull: cannot record pulled digests in " + path);
+            std::filesystem::remove(std::filesystem::u8path(temp), ec);
+            return;
+        }
+    }
+    std::filesystem::rename(std::filesystem::u8path(temp), std::filesystem::u8path(path), ec);
+    if (ec) std::filesystem::remove(std::filesystem::u8path(temp), ec);
+}
+
+// Records the index.json a zipball pull just wrote as the new pull base
+void recordPulledIndex(const RepoManager& local) {
+    RepoIndex pulled;
+    std::string error;
+    if (readIndexJson(local.getIndexPath(), pulled, error)) savePullBase(local.getPullBasePath(), pulled);
+}
+
+// Hands chunks from the HTTP thread to streamArchive, holding at most
+// kPipeLimit bytes so a slow disk throttles the download
+class BodyPipe {
+public:
+    // Producer side; false once the reader gave up
+    bool write(const char* data, std::size_t size) {
+        std::unique_lock<std::mutex> lock(mu);
+        space.wait(lock, [&] { return closedRead || queued < kPipeLimit; });
+        if (closedRead) return false;
+        chunks.emplace_back(data, size);
+        queued += size;
+        ready.notify_one();
+        return true;
+    }
+    void closeWrite() {
+        std::lock_guard<std::mutex> lock(mu);
+        closedWrite = true;
+        ready.notify_one();
+    }
+    // Consumer side; 0 at the end of the body
+    std::size_t read(unsigned char* buffer, std::size_t capacity) {
+        std::unique_lock<std::mutex> lock(mu);
+        ready.wait(lock, [&] { return closedWrite || !chunks.empty(); });
+        std::size_t got = 0;
+        while (got < capacity && !chunks.empty()) {
+            std::string& front = chunks.front();
+            std::size_t n = std::min(capacity - got, front.size() - offset);
+            std::memcpy(buffer + got, front.data() + offset, n);
+            got += n;
+            offset += n;
+            if (offset == front.size()) {
+                queued -= front.size();
+                chunks.pop_front();
+                offset = 0;
+            }
+        }
+        space.notify_one();
+        return got;
+    }
+    void closeRead() {
+        std::lock_guard<std::mutex> lock(mu);
+        closedRead = true;
+        space.notify_one();
+    }
+
+private:
+    static constexpr std::size_t kPipeLimit = 8u << 20;
+    std::mutex mu;
+    std::condition_variable ready, space;
+    std::deque<std::string> chunks;
+    std::size_t offset = 0;
+    std::size_t queued = 0;
+    bool closedWrite = false;
+    bool closedRead = false;
+};
+
+// Writes streamed entries over the repo, skipping files that are unchanged
+class ApplySink : public ziputil::StreamSink {
+public:
+    ApplySink(const RepoManager& local, PullReport& report, const PullProgressFn& progress)
+        : local(local), report(report), progress(progress), buffer(kCopyBlock) {}
+    ~ApplySink() override { discard(); }
+
+    const std::string& error() const { return errorMessage; }
+
+    bool beginEntry(const ziputil::Entry& e) override {
+        active = false;
+        if (e.isDirectory()) return true;
+        // Everything lives under the archive's single top-level folder
+        auto slash = e.name.find('/');
+        if (slash == std::string::npos || slash + 1 == e.name.size()) return true;
+        rel = e.name.substr(slash + 1);
+        if (!utils::isSafeRelativePath(rel)) {
+            errorMessage = "unsafe path in archive: " + e.name;
+            return false;
+        }
+        // Git and RepoMan state stay local; the repo's own index.json is applied
+        if (rel != "index.json" && RepoManager::isInternalPath(rel)) {
+            logger::debug("pull: skipped " + rel + " (internal path)");
+            return true;
+        }
+        dest = (std::filesystem::path(local.getStoragePath()) / std::filesystem::u8path(rel)).u8string();
+        active = true;
+        comparing = false;
+        matched = 0;
+        written = 0;
+
+        // Sizes are deferred to a data descriptor for some entries; the
+        // comparison then finds out on its own
+        const ContentItem* item = local.findByPath(rel);
+        bool sizeKnown = (e.flags & 0x8) == 0;
+        if (item && !item->sha256.empty() && (!sizeKnown || item->fileSizeBytes == e.uncompressedSize)) {
+            FileIdentity id;
+            if (statFileIdentity(dest, id) && id.size == item->fileSizeBytes) {
+                original.open(std::filesystem::u8path(dest), std::ios::binary);
+                comparing = original.is_open();
+                localSize = id.size;
+            }
+        }
+        return comparing || openTemp();
+    }
+
+    bool entryData(const unsigned char* data, std::size_t size) override {
+        if (!active) return true;
+        if (comparing) {
+            if (matched + size <= localSize) {
+                if (buffer.size() < size) buffer.resize(size);
+                original.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(size));
+                if (static_cast<std::size_t>(original.gcount()) == size && std::memcmp(buffer.data(), data, size) == 0) {
+                    matched += size;
+                    return true;
+                }
+            }
+            if (!spill()) return false;
+        }
+        return write(data, size);
+    }
+
+    bool endEntry(const ziputil::Entry&) override {
+        if (!active) return true;
+        active = false;
+        if (comparing && matched == localSize) {
+            comparing = false;
+            original.close();
+            ++report.unchanged;
+            if (progress) progress(report);
+            return true;
+        }
+        if (comparing && !spill()) return false;
+        out.close();
+        if (!out) {
+            errorMessage = "write failed: " + dest;
+            discard();
+            return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(std::filesystem::u8path(temp), std::filesystem::u8path(dest), ec);
+        if (ec) {
+            errorMessage = "cannot replace " + dest + ": " + ec.message();
+            discard();
+            return false;
+        }
+        temp.clear();
+        ++report.written;
+        report.bytesWritten += written;
+        if (progress) progress(report);
+        return true;
+    }
+
+private:
+    const RepoManager& local;
+    PullReport& report;
+    const PullProgressFn& progress;
+    std::string errorMessage;
+
+    // Current entry
+    bool active = false;
+    std::string rel;
+    std::string dest;
+    std::string temp;          // non-empty while a temp file exists
+    std::ofstream out;
+    uint64_t written = 0;
+    // Comparison with the local copy: matched bytes are identical so far
+    bool comparing = false;
+    std::ifstream original;
+    uint64_t localSize = 0;
+    uint64_t matched = 0;
+    std::vector<unsigned char> buffer;
+
+    bool openTemp() {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::u8path(dest).parent_path(), ec);
+        temp = dest + kTempSuffix;
+        out.open(std::filesystem::u8path(temp), std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            errorMessage = "cannot create " + temp;
+            temp.clear();
+            return false;
+        }
+        return true;
+    }
+
+    bool write(const unsigned char* data, std::size_t size) {
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        written += size;
+        if (!out) {
+            errorMessage = "write failed: " + temp;
+            return false;
+        }
+        return true;
+    }
+
+    // The entry differs from the local copy: start the temp file with the
+    // part that matched, taken from the local copy
+    bool spill() {
+        comparing = false;
+        if (!openTemp()) return false;
+        original.clear();
+        original.seekg(0);
+        for (uint64_t left = matched; left > 0;) {
+            std::size_t take = static_cast<std::size_t>(std::min<uint64_t>(left, buffer.size()));
+            original.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(take));
+            if (static_cast<std::size_t>(original.gcount()) != take) {
+                errorMessage = "cannot read " + dest;
+                return false;
+            }
+            if (!write(buffer.data(), take)) return false;
+            left -= take;
+        }
+        original.close();
+        return true;
+    }
+
+    void discard() {
+        if (out.is_open()) out.close();
+        if (temp.empty()) return;
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::u8path(temp), ec);
+        temp.clear();
+    }
+};
+
+// Feeds the download to streamArchive as it arrives
+bool pullStreamed(const RepoManager& local, const std::string& url, const std::string& token,
+                  PullReport& report, std::string& errorMessage, const PullProgressFn& progress) {
+    BodyPipe pipe;
+    utils::http::Response response;
+    std::thread fetcher([&] {
+        response = utils::http::gitHub().get(url, utils::http::gitHubHeaders(token), [&](const char* data, std::size_t size) {
+            return pipe.write(data, size);
+        });
+        pipe.closeWrite();
+    });
+    ApplySink sink(local, report, progress);
+    ziputil::SourceFn source = [&pipe](unsigned char* buffer, std::size_t capacity) {
+        return pipe.read(buffer, capacity);
+    };
+    std::string streamError;
+    bool ok = ziputil::streamArchive(source, sink, streamError);
+    pipe.closeRead();
+    fetcher.join();
+    // Stopping early aborts the download too, so our own errors come first
+    bool fetched = response.ok();
+    if (!sink.error().empty()) {
+        errorMessage = sink.error();
+    } else if (!fetched) {
+        errorMessage = "download failed (" + (response.error.empty() ? "HTTP " + std::to_string(response.status) : response.error) + ")";
+        if (!ok) errorMessage += ": " + streamError;
+    } else if (!ok) {
+        errorMessage = streamError;
+    }
+    return ok && fetched;
+}
+
+// Downloads and extracts to workDir, then renames the files into place
+bool pullExtracted(const std::string& repoRoot, const std::string& url, const std::string& token,
+                   const std::string& workDir, PullReport& report, std::string& errorMessage,
+                   const PullProgressFn& progress) {
+    std::string zip = workDir + "/pull_tmp.zip";
+    std::string unzipDir = workDir + "/pull_unzip_tmp";
+    auto response = utils::http::gitHub().download(url, utils::http::gitHubHeaders(token), zip);
+    if (!response.ok()) {
+        errorMessage = "download failed" + (response.error.empty() ? " (HTTP " + std::to_string(response.status) + ")" : ": " + response.error);
+        return false;
+    }
+    std::error_code ec;
+    bool ok = ziputil::extractArchive(zip, unzipDir, errorMessage);
+    std::string top;
+    if (ok) {
+        for (auto& e : std::filesystem::directory_iterator(unzipDir)) { if (e.is_directory()) { top = e.path().string(); break; } }
+        if (top.empty()) { errorMessage = "unexpected zip layout"; ok = false; }
+    }
+    if (ok) {
+        for (auto& p : std::filesystem::recursive_directory_iterator(top)) {
+            if (!p.is_regular_file()) continue;
+            std::filesystem::path relPath = std::filesystem::relative(p.path(), top);
+            std::string rel = relPath.generic_u8string();
+            if (rel != "index.json" && RepoManager::isInternalPath(rel)) {
+                logger::debug("pull: skipped " + rel + " (internal path)");
+                continue;
+            }
+            std::filesystem::path dest = std::filesystem::path(repoRoot) / relPath;
+            std::filesystem::create_directories(dest.parent_path(), ec);
+            uint64_t size = static_cast<uint64_t>(p.file_size(ec));
+            // rename replaces dest in one step; copy only across filesystems
+            std::filesystem::rename(p.path(), dest, ec);
+            if (ec) std::filesystem::copy_file(p.path(), dest, std::filesystem::copy_options::overwrite_existing, ec);
+            if (ec) {
+                errorMessage = "copy failed: " + ec.message();
+                ok = false;
+                break;
+            }
+            ++report.written;
+            report.bytesWritten += size;
+            if (progress) progress(report);
+        }
+    }
+    std::filesystem::remove(zip, ec);
+    std::filesystem::remove_all(unzipDir, ec);
+    return ok;
+}
+
+} // namespace
+
+bool pullZipball(const std::string& repoRoot, const std::string& url, const std::string& token,
+                 const std::string& workDir, PullReport& report, std::string& errorMessage,
+                 const PullProgressFn& progress) {
+    report = PullReport{};
+    RepoManager local(repoRoot);
+    bool ok;
+    if (!ziputil::nativeExtractionAvailable()) {
+        ok = pullExtracted(repoRoot, url, token, workDir, report, errorMessage, progress);
+    } else {
+        if (!local.loadIndex()) logger::debug("pull: no local index, every file will be written");
+        report.streamed = true;
+        ok = pullStreamed(local, url, token, report, errorMessage, progress);
+    }
+    if (ok) recordPulledIndex(local);
+    return ok;
+}
+
+bool fetchRemoteIndex(const std::string& rawBaseUrl, const std::string& token,
+                      RepoIndex& index, std::string& json) {
+    auto response = utils::http::gitHub().get(rawBaseUrl + "/index.json",
+                                              utils::http::gitHubHeaders(token, "application/vnd.github.v3.raw"));
+    // A pull must not act on a stale copy of the remote index
+    if (!response.ok() || response.stale) return false;
+    json = std::move(response.body);
+    try {
+        nlohmann::json j = nlohmann::json::parse(json);
+        if (!j.is_object() || !j.contains("version") || !j.contains("items") || !j["items"].is_array()) return false;
+        index = j.get<RepoIndex>();
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool probeRemoteIndex(const std::string& rawBaseUrl, const std::string& token) {
+    auto response = utils::http::gitHub().get(rawBaseUrl + "/index.json",
+                                              utils::http::gitHubHeaders(token, "application/vnd.github.v3.raw"));
+    if (!response.ok()) return false;
+    nlohmann::json j = nlohmann::json::parse(response.body, nullptr, false);
+    return j.is_object() && j.contains("version") && j.contains("items") && j["items"].is_array();
+}
+
+bool pullDelta(const std::string& repoRoot, const RepoIndex& remote, const std::string& remoteJson,
+               const std::string& rawBaseUrl, const std::string& token, unsigned jobs,
+               PullReport& report, std::string& errorMessage, const PullProgressFn& progress) {
+    report = PullReport{};
+    RepoManager local(repoRoot);
+    if (!local.loadIndex()) logger::debug("pull: no local index, every item will be fetched");
+
+    // Items to fetch: new paths, changed digests and files gone from disk
+    std::vector<const ContentItem*> fetch;
+    std::unordered_set<std::string> remotePaths;
+    for (const auto& item : remote.items) {
+        std::string rel = utils::normalizeRelative(item.relativePath);
+        if (!utils::isSafeRelativePath(rel) || RepoManager::isInternalPath(rel)) {
+            errorMessage = "unsafe path in remote index: " + item.relativePath;
+            return false;
+        }
+        if (!remotePaths.insert(rel).second) continue;
+        const ContentItem* mine = local.findByPath(rel);
+        std::error_code ec;
+        bool present = std::filesystem::exists(std::filesystem::path(local.getStoragePath()) / std::filesystem::u8path(rel), ec);
+        if (mine && present && mine->sha256 == item.sha256) {
+            ++report.unchanged;
+            continue;
+        }
+        fetch.push_back(&item);
+    }
+    logger::debug("pull: fetching " + std::to_string(fetch.size()) + " of " + std::to_string(remote.items.size()) + " item(s)");
+
+    std::mutex mu;
+    std::atomic<bool> failed{false};
+    utils::parallelFor(fetch.size(), jobs ? jobs : kDefaultDownloads, [&](std::size_t k) {
+        if (failed.load()) return;
+        const ContentItem& item = *fetch[k];
+        std::string rel = utils::normalizeRelative(item.relativePath);
+        std::filesystem::path dest = std::filesystem::path(local.getStoragePath()) / std::filesystem::u8path(rel);
+        std::string temp = dest.u8string() + kTempSuffix;
+        std::error_code ec;
+        std::filesystem::create_directories(dest.parent_path(), ec);
+        // Hashed as it arrives, so the file is not read back to be checked
+        utils::sha256::Hasher hasher;
+        uint64_t size = 0;
+        std::ofstream out(std::filesystem::u8path(temp), std::ios::binary | std::ios::trunc);
+        auto response = utils::http::gitHub().get(rawBaseUrl + "/" + utils::http::encodePath(rel),
+                                                  utils::http::gitHubHeaders(token, "application/vnd.github.v3.raw"),
+                                                  [&](const char* data, std::size_t n) {
+            hasher.update(data, n);
+            size += n;
+            out.write(data, static_cast<std::streamsize>(n));
+            return static_cast<bool>(out);
+        });
+        out.close();
+        std::string error;
+        if (!response.ok()) {
+            error = "download failed: " + rel;
+        } else if (!out) {
+            error = "cannot write " + temp;
+        } else if (!item.sha256.empty() && utils::sha256::toHex(hasher.finish()) != item.sha256) {
+            error = "sha256 mismatch after download: " + rel;
+        } else {
+            std::filesystem::rename(std::filesystem::u8path(temp), dest, ec);
+            if (ec) error = "cannot replace " + rel + ": " + ec.message();
+        }
+        if (!error.empty()) std::filesystem::remove(std::filesystem::u8path(temp), ec);
+
+        std::lock_guard<std::mutex> lock(mu);
+        if (!error.empty()) {
+            if (!failed.exchange(true)) errorMessage = error;
+            return;
+        }
+        ++report.written;
+        report.bytesWritten += size;
+        if (progress) progress(report);
+    });
+    if (failed.load()) return false;
+
+    // Only files that came from upstream are deleted: the last pull brought
+    // the path in and the file still has that content. Anything added or
+    // edited here since then stays.
+    auto base = loadPullBase(local.getPullBasePath());
+    std::unordered_set<std::string> seen;
+    for (const auto& item : local.index().items) {
+        std::string rel = utils::normalizeRelative(item.relativePath);
+        if (remotePaths.count(rel) || !utils::isSafeRelativePath(rel) || RepoManager::isInternalPath(rel) ||
+            !seen.insert(rel).second) continue;
+        std::filesystem::path full = std::filesystem::path(local.getStoragePath()) / std::filesystem::u8path(rel);
+        std::error_code ec;
+        if (!std::filesystem::exists(full, ec)) continue;
+        auto pulled = base.find(rel);
+        if (pulled == base.end() || utils::computeFileSha256(full.u8string()) != pulled->second) {
+            logger::warning("pull: kept " + rel + ": not upstream, added or changed locally since the last pull");
+            ++report.kept;
+            continue;
+        }
+        if (std::filesystem::remove(full, ec)) {
+            logger::info("pull: removed " + rel + " (deleted upstream)");
+            ++report.removed;
+        }
+    }
+
+    std::string indexTemp = local.getIndexPath() + kTempSuffix;
+    {
+        std::ofstream out(std::filesystem::u8path(indexTemp), std::ios::binary | std::ios::trunc);
+        out.write(remoteJson.data(), static_cast<std::streamsize>(remoteJson.size()));
+        if (!out) {
+            errorMessage = "cannot write " + indexTemp;
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(std::filesystem::u8path(indexTemp), std::filesystem::u8path(local.getIndexPath()), ec);
+    if (ec) {
+        std::filesystem::remove(std::filesystem::u8path(indexTemp), ec);
+        errorMessage = "cannot replace index.json: " + ec.message();
+        return false;
+    }
+    savePullBase(local.getPullBasePath(), remote);
+    if (progress) progress(report);
+    return true;
+}
+
+}
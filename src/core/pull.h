@@ -0,0 +1,67 @@
+#ifndef CORE_PULL_H
+#define CORE_PULL_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include "types.h"
+
+namespace core {
+
+// Result of pullZipball
+struct PullReport {
+    std::size_t written = 0;    // new or changed files renamed into place
+    std::size_t unchanged = 0;  // identical to the local copy, not touched
+    std::size_t removed = 0;    // deleted upstream (pullDelta only)
+    std::size_t kept = 0;       // not upstream but local work, left in place (pullDelta only)
+    uint64_t bytesWritten = 0;
+    bool streamed = false;      // applied while downloading (false: zip fallback)
+};
+
+using PullProgressFn = std::function<void(const PullReport& soFar)>;
+
+// Applies a GitHub zipball (one top-level folder holding the repo) to the
+// repo at repoRoot. With zlib the archive is read from the connection as it
+// arrives: a file whose local index entry has the entry's size is compared
+// byte for byte with the local copy and left alone if identical; everything
+// else is written to a temp name next to its destination and renamed into
+// place, so readers never see a half-written file. Without zlib the archive
+// is downloaded to workDir and extracted there first. Files missing from
+// the archive are kept. Returns false and sets errorMessage on failure;
+// files renamed before the failure stay updated. On success the pulled
+// index.json becomes the base later pullDelta calls delete against.
+// url may be relative to the GitHub API base (utils::http::gitHub).
+bool pullZipball(const std::string& repoRoot, const std::string& url, const std::string& token,
+                 const std::string& workDir, PullReport& report, std::string& errorMessage,
+                 const PullProgressFn& progress = nullptr);
+
+// Fetches <rawBaseUrl>/index.json (rawBaseUrl being e.g.
+// https://raw.githubusercontent.com/<owner>/<repo>/<branch>). Returns false
+// if it is missing or not a repoman index; json receives the raw text.
+bool fetchRemoteIndex(const std::string& rawBaseUrl, const std::string& token,
+                      RepoIndex& index, std::string& json);
+
+// True if <rawBaseUrl>/index.json is a repoman index. Only the top-level
+// shape is checked, nothing is converted, so it is cheap enough to run for
+// every repo of a listing; safe to call from several threads at once.
+bool probeRemoteIndex(const std::string& rawBaseUrl, const std::string& token);
+
+// Brings the repo at repoRoot to the state of a remote index by fetching
+// only the items whose path is new or whose sha256 differs from the local
+// index (or whose file is missing), each through <rawBaseUrl>/<path> on up
+// to `jobs` concurrent downloads (0 = 8). Every file is checked against its
+// remote sha256 (hashed as it downloads) before it is renamed into place.
+// Once all arrived, files of items the remote index no longer has are
+// deleted if the previous pull brought them in and they are unchanged since
+// (see RepoManager::getPullBasePath); files added or edited locally are kept
+// and counted in report.kept. remoteJson then becomes the new index.json.
+// Files outside the index are not synced. Returns false on the first failed
+// or mismatched download; nothing is deleted then.
+bool pullDelta(const std::string& repoRoot, const RepoIndex& remote, const std::string& remoteJson,
+               const std::string& rawBaseUrl, const std::string& token, unsigned jobs,
+               PullReport& report, std::string& errorMessage, const PullProgressFn& progress = nullptr);
+
+}
+
+#endif // CORE_PULL_H
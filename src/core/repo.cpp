@@ -1,19 +1,41 @@
 #include "repo.h"
 #include "types.h"
+#include "index_snapshot.h"
+#include "index_json.h"
+#include "index_journal.h"
+#include "hash_cache.h"
 #include "../system/logger.h"
 #include "../system/fs.h"
 #include "../utils/hash.h"
 #include "../utils/path.h"
 #include "../utils/git.h"
+#include "../utils/chunker.h"
+#include "../utils/parallel.h"
+#include "../utils/zip.h"
 
 #include <filesystem>
 #include <fstream>
 #include <random>
-#include <unordered_set>
 #include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <algorithm>
+#include <stdexcept>
 
 namespace core {
 
+// Journal is folded into index.json once it exceeds this size or the size of
+// index.json itself, whichever is larger, keeping total writes linear.
+static constexpr uint64_t kJournalCompactBytes = 256 * 1024;
+
+// Files from this size on get a chunk sidecar; see setChunkThreshold
+static uint64_t chunkThresholdBytes = 64ull * 1024 * 1024;
+
+// index.json without indentation; see setCompactIndexJson
+static bool compactIndexJson = false;
+
 static std::string generateId() {
     static std::mt19937_64 rng{std::random_device{}()};
     uint64_t a = rng();
@@ -32,12 +54,58 @@ static bool isAsciiString(const std::string& text) {
     return true;
 }
 
-RepoManager::RepoManager(const std::string& rootDir) : root(rootDir) {}
+// Type of a file added by discovery, from its extension
+static ContentType inferContentType(const std::filesystem::path& path) {
+    std::string ext = path.extension().u8string();
+    for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    if (ext == ".cfg") return ContentType::CFG;
+    if (ext == ".exe") return ContentType::EXECUTABLE;
+    return ContentType::PK3;
+}
+
+bool RepoManager::isInternalPath(const std::string& rel) {
+    if (rel == "index.json") return true;
+    if (rel.size() >= 4 && rel.substr(0, 4) == ".git") return true;
+    if (rel == ".repoman" || rel.rfind(".repoman/", 0) == 0) return true;
+    return false;
+}
+
+RepoManager::RepoManager(const std::string& rootDir)
+    : root(rootDir), hashCache(rootDir + "/.repoman/hashcache"), objects(rootDir + "/.repoman/objects"),
+      catalog(rootDir + "/.repoman/catalog") {}
 
 std::string RepoManager::getIndexPath() const {
     return root + "/index.json";
 }
 
+std::string RepoManager::getStateDir() const {
+    return root + "/.repoman";
+}
+
+std::string RepoManager::getSnapshotPath() const {
+    return getStateDir() + "/index.bin";
+}
+
+std::string RepoManager::getJournalPath() const {
+    return getStateDir() + "/index.journal";
+}
+
+std::string RepoManager::getObjectsDir() const {
+    return objects.directory();
+}
+
+std::string RepoManager::getChunksDir() const {
+    return getStateDir() + "/chunks";
+}
+
+std::string RepoManager::getCatalogPath() const {
+    return getStateDir() + "/catalog";
+}
+
+std::string RepoManager::getPullBasePath() const {
+    return getStateDir() + "/pulled";
+}
+
 std::string RepoManager::getStoragePath() const {
     // Store files at the repo root to mirror the Quake 3 layout (e.g., baseq3/*, osp/*).
     return root;
@@ -78,11 +146,127 @@ bool RepoManager::init(const std::string& name, const std::string& description)
     }
 }
 
+bool RepoManager::ensureStateDir() const {
+    std::error_code ec;
+    std::filesystem::create_directories(getStateDir(), ec);
+    if (ec) return false;
+    std::string ignorePath = getStateDir() + "/.gitignore";
+    if (!std::filesystem::exists(ignorePath)) {
+        std::ofstream gi(ignorePath);
+        gi << "# RepoMan local state, not part of the repository\n*\n";
+    }
+    return true;
+}
+
+void RepoManager::refreshSnapshot() const {
+    SnapshotSource src;
+    if (!statSnapshotSource(getIndexPath(), src)) return;
+    if (!ensureStateDir() || !writeIndexSnapshot(getSnapshotPath(), indexData, src)) {
+        logger::debug("Index snapshot not written: " + getSnapshotPath());
+    }
+}
+
+bool RepoManager::journalMutation(const nlohmann::json& record) {
+    if (inBatch()) {
+        batchDirty = true;
+        return true;
+    }
+    SnapshotSource base;
+    if (!statSnapshotSource(getIndexPath(), base) || !ensureStateDir() ||
+        !appendJournalRecord(getJournalPath(), base, record)) {
+        // Journal unavailable: persist the full index instead
+        return saveIndex();
+    }
+    if (journalSize(getJournalPath()) > std::max<uint64_t>(kJournalCompactBytes, base.size)) {
+        return saveIndex();
+    }
+    return true;
+}
+
+bool RepoManager::persistIndex() {
+    if (inBatch()) {
+        batchDirty = true;
+        return true;
+    }
+    return saveIndex();
+}
+
+void RepoManager::beginBatch() {
+    ++batchDepth;
+}
+
+bool RepoManager::commitBatch() {
+    if (batchDepth == 0) return true;
+    if (--batchDepth > 0) return true;
+    if (!batchDirty) return true;
+    batchDirty = false;
+    if (!saveIndex()) {
+        logger::error("Failed to save index after batch");
+        return false;
+    }
+    return true;
+}
+
+bool RepoManager::compactIndex() {
+    if (journalSize(getJournalPath()) == 0) return true;
+    return saveIndex();
+}
+
+void RepoManager::reindex() {
+    byId.rebuild(indexData.items);
+    byPath.rebuild(indexData.items);
+    byDigest.rebuild(indexData.items);
+}
+
+void RepoManager::indexItem(std::size_t pos) {
+    byId.insert(indexData.items, pos);
+    byPath.insert(indexData.items, pos);
+    byDigest.insert(indexData.items, pos);
+}
+
+const ContentItem* RepoManager::findById(const std::string& id) const {
+    std::size_t pos = byId.find(indexData.items, id);
+    return pos == ItemHashIndex::npos ? nullptr : &indexData.items[pos];
+}
+
+const ContentItem* RepoManager::findByPath(const std::string& relativePath) const {
+    std::size_t pos = byPath.find(indexData.items, utils::normalizeRelative(relativePath));
+    return pos == ItemHashIndex::npos ? nullptr : &indexData.items[pos];
+}
+
+std::vector<const ContentItem*> RepoManager::findByDigest(const std::string& sha256) const {
+    std::vector<const ContentItem*> out;
+    for (std::size_t pos : byDigest.findAll(indexData.items, sha256)) out.push_back(&indexData.items[pos]);
+    return out;
+}
+
+ContentItem* RepoManager::findMutable(const std::string& id) {
+    std::size_t pos = byId.find(indexData.items, id);
+    return pos == ItemHashIndex::npos ? nullptr : &indexData.items[pos];
+}
+
 bool RepoManager::loadIndex() {
     try {
-        std::ifstream in(getIndexPath());
-        if (!in.is_open()) return false;
-        nlohmann::json j; in >> j; indexData = j.get<RepoIndex>();
+        SnapshotSource src;
+        if (!statSnapshotSource(getIndexPath(), src)) return false;
+        // Fast path: snapshot built from this exact index.json
+        if (!readIndexSnapshot(getSnapshotPath(), src, indexData)) {
+            std::string err;
+            if (!readIndexJson(getIndexPath(), indexData, err)) {
+                logger::error("Load index failed: " + err);
+                return false;
+            }
+            refreshSnapshot();
+        }
+
+        // Re-apply mutations recorded since index.json was last written
+        std::size_t applied = 0;
+        if (!replayJournal(getJournalPath(), src, indexData, applied)) {
+            clearJournal(getJournalPath());
+        } else if (applied > 0) {
+            logger::debug("Replayed " + std::to_string(applied) + " journal records");
+        }
+        reindex();
         return true;
     } catch (const std::exception& e) {
         logger::error(std::string("Load index failed: ") + e.what());
@@ -92,10 +276,16 @@ bool RepoManager::loadIndex() {
 
 bool RepoManager::saveIndex() const {
     try {
-        std::ofstream out(getIndexPath());
-        if (!out.is_open()) return false;
-        nlohmann::json j = indexData;
-        out << j.dump(2);
+        // tree_root lets readers of index.json compare whole repos by one hash
+        std::string err;
+        if (!writeIndexJson(getIndexPath(), indexData, MerkleTree::build(indexData.items).rootHash(),
+                            compactIndexJson, err)) {
+            logger::error("Save index failed: " + err);
+            return false;
+        }
+        // index.json now holds everything the journal recorded
+        clearJournal(getJournalPath());
+        refreshSnapshot();
         return true;
     } catch (const std::exception& e) {
         logger::error(std::string("Save index failed: ") + e.what());
@@ -117,17 +307,140 @@ std::size_t RepoManager::pruneMissingFiles() {
     }
     if (removed > 0) {
         indexData.items.swap(kept);
-        saveIndex();
+        reindex();
+        persistIndex();
     }
     return removed;
 }
 
-std::size_t RepoManager::discoverNewFiles() {
+std::vector<std::string> RepoManager::hashFiles(const std::vector<std::string>& relativePaths,
+                                                unsigned jobs, bool trustCache,
+                                                std::size_t* hashedCount, bool chunkLarge) const {
+    hashCache.load();
+    std::vector<std::string> digests(relativePaths.size());
+    std::vector<FileIdentity> ids(relativePaths.size());
+    std::vector<char> haveId(relativePaths.size(), 0);
+    std::vector<std::size_t> misses;
+    std::vector<std::string> missPaths;
+    std::vector<std::size_t> chunked; // misses hashed by chunking them
+    for (std::size_t i = 0; i < relativePaths.size(); ++i) {
+        std::string full = (std::filesystem::path(getStoragePath()) / std::filesystem::u8path(relativePaths[i])).u8string();
+        haveId[i] = statFileIdentity(full, ids[i]) ? 1 : 0;
+        if (haveId[i] && trustCache) {
+            if (auto cached = hashCache.lookup(relativePaths[i], ids[i])) {
+                digests[i] = *cached;
+                continue;
+            }
+        }
+        if (chunkLarge && chunkThresholdBytes > 0 && haveId[i] && ids[i].size >= chunkThresholdBytes) {
+            chunked.push_back(i);
+            continue;
+        }
+        misses.push_back(i);
+        missPaths.push_back(full);
+    }
+
+    std::vector<std::string> fresh = utils::computeFilesSha256(missPaths, jobs);
+    for (std::size_t k = 0; k < misses.size(); ++k) digests[misses[k]] = std::move(fresh[k]);
+    // chunkFile yields the whole-file digest too, so these are read only once
+    std::mutex saveMutex;
+    utils::parallelFor(chunked.size(), jobs, [&](std::size_t k) {
+        std::size_t i = chunked[k];
+        std::string full = (std::filesystem::path(getStoragePath()) / std::filesystem::u8path(relativePaths[i])).u8string();
+        ChunkManifest manifest;
+        if (!utils::chunkFile(full, manifest.params, manifest.chunks, &digests[i])) return;
+        std::lock_guard<std::mutex> lock(saveMutex);
+        saveChunks(digests[i], manifest);
+    });
+    misses.insert(misses.end(), chunked.begin(), chunked.end());
+    for (std::size_t i : misses) {
+        // Identity was taken before hashing, so a file edited meanwhile won't match next time
+        if (haveId[i] && !digests[i].empty()) hashCache.store(relativePaths[i], ids[i], digests[i]);
+    }
+    if (hashedCount) *hashedCount = misses.size();
+    if (!misses.empty() && (!ensureStateDir() || !hashCache.save())) {
+        logger::debug("Hash cache not saved");
+    }
+    return digests;
+}
+
+VerifyReport RepoManager::verify(unsigned jobs, bool deep) const {
+    VerifyReport report;
+    const auto& items = indexData.items;
+
+    // Existence first, then hash every present file that has a recorded digest
+    std::vector<char> present(items.size(), 0);
+    std::vector<std::size_t> toHash;
+    std::vector<std::string> rels;
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        std::filesystem::path full = std::filesystem::path(getStoragePath()) / std::filesystem::u8path(items[i].relativePath);
+        std::error_code ec;
+        present[i] = std::filesystem::exists(full, ec) ? 1 : 0;
+        if (present[i] && !items[i].sha256.empty()) {
+            toHash.push_back(i);
+            rels.push_back(items[i].relativePath);
+        }
+    }
+    // Forget cache entries for files that are no longer indexed
+    hashCache.load();
+    hashCache.retain([this](const std::string& rel) { return findByPath(rel) != nullptr; });
+    std::vector<std::string> digests = hashFiles(rels, jobs, !deep, &report.hashed);
+    std::vector<std::string> actual(items.size());
+    for (std::size_t k = 0; k < toHash.size(); ++k) actual[toHash[k]] = std::move(digests[k]);
+
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (!present[i]) {
+            report.problems.push_back({VerifyReport::Problem::Missing, i, "", {}});
+            ++report.missing;
+        } else if (!actual[i].empty() && actual[i] != items[i].sha256) {
+            report.problems.push_back({VerifyReport::Problem::HashMismatch, i, actual[i], {}});
+            ++report.hashMismatch;
+        }
+    }
+
+    // Narrow mismatches down to byte ranges by rehashing at the recorded chunk boundaries
+    for (auto& p : report.problems) {
+        if (p.problem != VerifyReport::Problem::HashMismatch) continue;
+        const ContentItem& item = items[p.item];
+        ChunkManifest manifest;
+        if (!loadChunks(item.sha256, manifest)) continue;
+        std::string full = (std::filesystem::path(getStoragePath()) / std::filesystem::u8path(item.relativePath)).u8string();
+        std::vector<std::string> got;
+        if (!utils::hashFileRanges(full, manifest.chunks, got)) continue;
+        for (std::size_t c = 0; c < manifest.chunks.size(); ++c) {
+            if (got[c] == manifest.chunks[c].sha256) continue;
+            const auto& chunk = manifest.chunks[c];
+            if (!p.corruptRanges.empty() && p.corruptRanges.back().first + p.corruptRanges.back().second == chunk.offset) {
+                p.corruptRanges.back().second += chunk.length;
+            } else {
+                p.corruptRanges.emplace_back(chunk.offset, chunk.length);
+            }
+        }
+        // Bytes appended past the recorded end
+        std::error_code ec;
+        uint64_t size = static_cast<uint64_t>(std::filesystem::file_size(full, ec));
+        if (!ec && size > manifest.fileSize) p.corruptRanges.emplace_back(manifest.fileSize, size - manifest.fileSize);
+    }
+
+    // Duplicates, sorted by key so output is stable
+    std::map<std::string, int> pathCount, idCount;
+    for (const auto& it : items) {
+        pathCount[it.relativePath]++;
+        idCount[it.id]++;
+    }
+    for (const auto& [p, c] : pathCount) if (c > 1) { report.duplicatePaths.emplace_back(p, c); report.dupPaths += c - 1; }
+    for (const auto& [id, c] : idCount) if (c > 1) { report.duplicateIds.emplace_back(id, c); report.dupIds += c - 1; }
+    return report;
+}
+
+std::size_t RepoManager::discoverNewFiles(unsigned jobs) {
     std::size_t added = 0;
-    // Build a set of known relative paths
-    std::unordered_set<std::string> known;
-    known.reserve(indexData.items.size() * 2);
-    for (const auto& it : indexData.items) known.insert(it.relativePath);
+    struct Candidate {
+        std::string rel;
+        ContentType type;
+        std::string stem;
+    };
+    std::vector<Candidate> candidates;
 
     std::error_code ec;
     for (std::filesystem::recursive_directory_iterator it(getStoragePath(), ec), end; it != end && !ec; it.increment(ec)) {
@@ -139,17 +452,11 @@ std::size_t RepoManager::discoverNewFiles() {
 
         // Use UTF-8 with generic separators '/'
         std::string rel = relPath.generic_u8string();
-        // Skip repo index itself and Git internals
-        if (rel == "index.json") continue;
-        if (rel.size() >= 4 && rel.substr(0, 4) == ".git") continue;
-        if (known.find(rel) != known.end()) continue;
-
-        // Infer content type from extension
-        std::string ext = abs.extension().u8string();
-        for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
-        ContentType type = ContentType::PK3;
-        if (ext == ".cfg") type = ContentType::CFG;
-        else if (ext == ".exe") type = ContentType::EXECUTABLE;
+        // Skip repo index itself, Git internals and RepoMan state
+        if (isInternalPath(rel)) continue;
+        if (byPath.find(indexData.items, rel) != ItemHashIndex::npos) continue;
+
+        ContentType type = inferContentType(abs);
 
         // Derive human name from filename (without extension)
         std::string stem = abs.stem().u8string();
@@ -158,19 +465,32 @@ std::size_t RepoManager::discoverNewFiles() {
             logger::warning("discovery: skipped non-ASCII path '" + rel + "'");
             continue;
         }
-        if (addIndexEntryForExistingFile(rel, type, stem)) {
-            logger::info("discovery: added '" + rel + "'");
-            known.insert(rel);
+        candidates.push_back({rel, type, stem});
+    }
+
+    // Hash all candidates in parallel (cache first), then add them in directory order
+    std::vector<std::string> rels;
+    rels.reserve(candidates.size());
+    for (const auto& c : candidates) rels.push_back(c.rel);
+    std::vector<std::string> digests = hashFiles(rels, jobs, true, nullptr, true);
+    std::vector<std::size_t> positions;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        const auto& c = candidates[i];
+        if (addIndexEntryForExistingFile(c.rel, c.type, c.stem, digests[i])) {
+            logger::info("discovery: added '" + c.rel + "'");
+            positions.push_back(indexData.items.size() - 1);
             ++added;
         }
     }
-    if (added > 0) saveIndex();
+    if (added > 0) persistIndex();
+    recordChunks(positions, jobs);
     return added;
 }
 
 bool RepoManager::addIndexEntryForExistingFile(const std::string& relativePath,
                                                ContentType type,
-                                               const std::string& humanName) {
+                                               const std::string& humanName,
+                                               const std::string& knownSha256) {
     try {
         if (!isAsciiString(relativePath)) {
             logger::warning("Index add skipped: non-ASCII path '" + relativePath + "'");
@@ -179,7 +499,7 @@ bool RepoManager::addIndexEntryForExistingFile(const std::string& relativePath,
         std::filesystem::path full = std::filesystem::path(getStoragePath()) / std::filesystem::u8path(relativePath);
         if (!std::filesystem::exists(full)) return false;
 
-        std::string sha = utils::computeFileSha256(full.u8string());
+        std::string sha = knownSha256.empty() ? hashFiles({relativePath}, 1, true).front() : knownSha256;
         uint64_t size = std::filesystem::file_size(full);
 
         ContentItem item;
@@ -197,6 +517,7 @@ bool RepoManager::addIndexEntryForExistingFile(const std::string& relativePath,
         item.fileSizeBytes = size;
 
         indexData.items.push_back(item);
+        indexItem(indexData.items.size() - 1);
         return true;
     } catch (const std::exception& e) {
         logger::error(std::string("Index discovery add failed: ") + e.what());
@@ -241,10 +562,35 @@ std::optional<std::string> RepoManager::addFile(const std::string& sourcePath,
         std::filesystem::path srcPath(sourcePath);
         // Remove destination first to avoid platform-specific EEXIST quirks
         std::error_code ec_rm; std::filesystem::remove(dest, ec_rm);
-        std::filesystem::copy_file(srcPath, dest, std::filesystem::copy_options::overwrite_existing);
-
-        std::string sha = utils::computeFileSha256(dest.u8string());
-        uint64_t size = std::filesystem::file_size(dest);
+        uint64_t size = 0;
+        std::string sha;
+        // A large file is chunked from the same read that copies and hashes it
+        std::error_code ec_size;
+        uintmax_t sourceSize = std::filesystem::file_size(srcPath, ec_size);
+        bool chunk = chunkThresholdBytes > 0 && !ec_size && sourceSize >= chunkThresholdBytes;
+        ChunkManifest manifest;
+        utils::Chunker chunker(manifest.params);
+        std::function<void(const unsigned char*, std::size_t)> observe;
+        if (chunk) {
+            observe = [&](const unsigned char* data, std::size_t n) { chunker.update(data, n, manifest.chunks); };
+        }
+        if (objects.enabled()) {
+            // Content already in the store is linked, not copied again
+            sha = objects.importFile(srcPath.u8string(), &size, observe);
+            if (sha.empty() || !objects.install(sha, dest.u8string())) {
+                throw std::runtime_error("cannot store '" + sourcePath + "' in the object store");
+            }
+        } else {
+            // Copy and hash in one pass over the source
+            sha = utils::copyFileSha256(srcPath.u8string(), dest.u8string(), &size, observe);
+            if (sha.empty()) {
+                throw std::runtime_error("cannot copy '" + sourcePath + "' to '" + dest.u8string() + "'");
+            }
+        }
+        if (chunk) {
+            chunker.finish(manifest.chunks);
+            saveChunks(sha, manifest);
+        }
 
         ContentItem item;
         item.id = generateId();
@@ -260,7 +606,8 @@ std::optional<std::string> RepoManager::addFile(const std::string& sourcePath,
         item.fileSizeBytes = size;
 
         indexData.items.push_back(item);
-        if (!saveIndex()) return std::nullopt;
+        indexItem(indexData.items.size() - 1);
+        if (!journalMutation({{"op", "add"}, {"item", item}})) return std::nullopt;
         return item.id;
     } catch (const std::exception& e) {
         logger::error(std::string("Add file failed: ") + e.what());
@@ -268,16 +615,30 @@ std::optional<std::string> RepoManager::addFile(const std::string& sourcePath,
     }
 }
 
+std::vector<std::optional<std::string>> RepoManager::addFiles(const std::vector<AddRequest>& requests) {
+    std::vector<std::optional<std::string>> ids;
+    ids.reserve(requests.size());
+    IndexTransaction tx(*this);
+    for (const auto& r : requests) {
+        ids.push_back(addFile(r.sourcePath, r.type, r.relativePath, r.name,
+                              r.description, r.author, r.tags, r.downloadUrl));
+    }
+    if (!tx.commit()) {
+        // Files were copied but the index was not written
+        for (auto& id : ids) id.reset();
+    }
+    return ids;
+}
+
 bool RepoManager::removeItem(const std::string& itemId) {
     try {
         // Find the item in the index
-        auto it = std::find_if(indexData.items.begin(), indexData.items.end(),
-                              [&itemId](const ContentItem& item) { return item.id == itemId; });
-        
-        if (it == indexData.items.end()) {
+        std::size_t pos = byId.find(indexData.items, itemId);
+        if (pos == ItemHashIndex::npos) {
             logger::error("Item not found: " + itemId);
             return false;
         }
+        auto it = indexData.items.begin() + static_cast<std::ptrdiff_t>(pos);
 
         // Delete the physical file
         std::string filePath = root + "/" + it->relativePath;
@@ -286,11 +647,12 @@ bool RepoManager::removeItem(const std::string& itemId) {
             logger::debug("Deleted file: " + filePath);
         }
 
-        // Remove from index
+        // Remove from index; later positions shift, so rebuild lookups
         indexData.items.erase(it);
+        reindex();
         
         // Save updated index
-        if (!saveIndex()) {
+        if (!journalMutation({{"op", "remove"}, {"id", itemId}})) {
             logger::error("Failed to save index after removing item");
             return false;
         }
@@ -303,13 +665,348 @@ bool RepoManager::removeItem(const std::string& itemId) {
     }
 }
 
+std::size_t RepoManager::removeItems(const std::vector<std::string>& itemIds) {
+    std::vector<bool> doomed(indexData.items.size(), false);
+    std::vector<std::string> removedIds;
+    for (const auto& id : itemIds) {
+        std::size_t pos = byId.find(indexData.items, id);
+        if (pos == ItemHashIndex::npos || doomed[pos]) {
+            if (pos == ItemHashIndex::npos) logger::error("Item not found: " + id);
+            continue;
+        }
+        std::error_code ec;
+        std::filesystem::path filePath = std::filesystem::path(root) / std::filesystem::u8path(indexData.items[pos].relativePath);
+        if (std::filesystem::remove(filePath, ec)) logger::debug("Deleted file: " + filePath.u8string());
+        doomed[pos] = true;
+        removedIds.push_back(id);
+    }
+    if (removedIds.empty()) return 0;
+
+    dropItems(doomed, removedIds);
+    logger::info("Removed " + std::to_string(removedIds.size()) + " items");
+    return removedIds.size();
+}
+
+void RepoManager::dropItems(const std::vector<bool>& doomed, const std::vector<std::string>& ids) {
+    // Single order-preserving compaction instead of one erase per item
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < indexData.items.size(); ++i) {
+        if (doomed[i]) continue;
+        if (out != i) indexData.items[out] = std::move(indexData.items[i]);
+        ++out;
+    }
+    indexData.items.resize(out);
+    reindex();
+
+    bool saved = true;
+    for (const auto& id : ids) saved = journalMutation({{"op", "remove"}, {"id", id}}) && saved;
+    if (!saved) logger::error("Failed to save index after removing items");
+}
+
+ChangeReport RepoManager::applyChanges(const std::vector<std::string>& relativePaths, unsigned jobs) {
+    ChangeReport report;
+    const std::filesystem::path storage(getStoragePath());
+
+    // Sort each path into files to (re)index and paths that no longer exist;
+    // directories stand for every file below them
+    std::set<std::string> files, gone;
+    for (const auto& p : relativePaths) {
+        std::string rel = utils::normalizeRelative(p);
+        if (isInternalPath(rel)) continue;
+        std::filesystem::path full = rel.empty() ? storage : storage / std::filesystem::u8path(rel);
+        std::error_code ec;
+        auto status = std::filesystem::status(full, ec);
+        if (std::filesystem::is_regular_file(status)) {
+            files.insert(rel);
+        } else if (std::filesystem::is_directory(status)) {
+            for (std::filesystem::recursive_directory_iterator it(full, ec), end; !ec && it != end; it.increment(ec)) {
+                std::string sub = std::filesystem::relative(it->path(), storage, ec).generic_u8string();
+                if (isInternalPath(sub)) {
+                    if (it->is_directory()) it.disable_recursion_pending();
+                    continue;
+                }
+                if (it->is_regular_file()) files.insert(sub);
+            }
+        } else if (!std::filesystem::exists(status)) {
+            gone.insert(rel);
+        }
+    }
+
+    // Items at or below vanished paths
+    std::vector<bool> doomed(indexData.items.size(), false);
+    std::vector<std::string> removedIds;
+    auto isGone = [&gone](const std::string& path) {
+        if (gone.count("") || gone.count(path)) return true;
+        for (std::size_t slash = path.rfind('/'); slash != std::string::npos && slash > 0; slash = path.rfind('/', slash - 1)) {
+            if (gone.count(path.substr(0, slash))) return true;
+        }
+        return false;
+    };
+    for (std::size_t i = 0; i < indexData.items.size() && !gone.empty(); ++i) {
+        if (isGone(indexData.items[i].relativePath)) {
+            doomed[i] = true;
+            removedIds.push_back(indexData.items[i].id);
+        }
+    }
+    if (!removedIds.empty()) {
+        dropItems(doomed, removedIds);
+        report.removed = removedIds.size();
+    }
+
+    // Unchanged files come from the hash cache; only new or modified ones are read
+    std::vector<std::string> rels;
+    for (const auto& rel : files) {
+        if (isAsciiString(rel)) rels.push_back(rel);
+        else logger::warning("watch: skipped non-ASCII path '" + rel + "'");
+    }
+    std::vector<std::string> digests = hashFiles(rels, jobs, true, nullptr, true);
+    std::vector<std::size_t> changed;
+    const uint64_t now = static_cast<uint64_t>(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+    for (std::size_t i = 0; i < rels.size(); ++i) {
+        if (digests[i].empty()) continue; // vanished or unreadable; a later event will tell
+        std::filesystem::path full = storage / std::filesystem::u8path(rels[i]);
+        std::vector<std::size_t> positions = byPath.findAll(indexData.items, rels[i]);
+        if (positions.empty()) {
+            if (addIndexEntryForExistingFile(rels[i], inferContentType(full), full.stem().u8string(), digests[i])) {
+                journalMutation({{"op", "add"}, {"item", indexData.items.back()}});
+                changed.push_back(indexData.items.size() - 1);
+                ++report.added;
+            }
+            continue;
+        }
+        std::error_code ec;
+        uint64_t size = static_cast<uint64_t>(std::filesystem::file_size(full, ec));
+        for (std::size_t pos : positions) {
+            ContentItem& item = indexData.items[pos];
+            if (item.sha256 == digests[i]) continue;
+            byDigest.erase(indexData.items, pos);
+            item.sha256 = digests[i];
+            item.fileSizeBytes = size;
+            item.updatedAt = now;
+            byDigest.insert(indexData.items, pos);
+            journalMutation({{"op", "content"}, {"id", item.id}, {"sha256", item.sha256},
+                             {"size", item.fileSizeBytes}, {"updated_at", item.updatedAt}});
+            changed.push_back(pos);
+            ++report.updated;
+        }
+    }
+    recordChunks(changed, jobs);
+    return report;
+}
+
+void RepoManager::setChunkThreshold(uint64_t bytes) {
+    chunkThresholdBytes = bytes;
+}
+
+uint64_t RepoManager::chunkThreshold() {
+    return chunkThresholdBytes;
+}
+
+void RepoManager::setCompactIndexJson(bool compact) {
+    compactIndexJson = compact;
+}
+
+bool RepoManager::compactIndexJsonEnabled() {
+    return compactIndexJson;
+}
+
+bool RepoManager::loadChunks(const std::string& sha256, ChunkManifest& out) const {
+    if (sha256.empty()) return false;
+    return loadChunkManifest(getChunksDir() + "/" + sha256, out);
+}
+
+bool RepoManager::saveChunks(const std::string& sha256, ChunkManifest& manifest) const {
+    std::string path = getChunksDir() + "/" + sha256;
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)) return true;
+    if (!ensureStateDir() || (std::filesystem::create_directories(getChunksDir(), ec), ec)) {
+        logger::error("Cannot create chunk directory: " + getChunksDir());
+        return false;
+    }
+    manifest.fileSize = 0;
+    for (const auto& c : manifest.chunks) manifest.fileSize += c.length;
+    return saveChunkManifest(path, manifest);
+}
+
+std::size_t RepoManager::recordChunks(const std::vector<std::size_t>& positions, unsigned jobs) const {
+    if (chunkThresholdBytes == 0) return 0;
+    // One job per digest that reaches the threshold and has no sidecar yet
+    std::vector<std::size_t> todo;
+    std::set<std::string> seen;
+    for (std::size_t pos : positions) {
+        const ContentItem& item = indexData.items[pos];
+        if (item.fileSizeBytes < chunkThresholdBytes || item.sha256.empty()) continue;
+        if (!seen.insert(item.sha256).second) continue;
+        std::error_code ec;
+        if (std::filesystem::exists(getChunksDir() + "/" + item.sha256, ec)) continue;
+        todo.push_back(pos);
+    }
+    if (todo.empty()) return 0;
+
+    std::vector<char> written(todo.size(), 0);
+    utils::parallelFor(todo.size(), jobs, [&](std::size_t k) {
+        const ContentItem& item = indexData.items[todo[k]];
+        std::string full = (std::filesystem::path(getStoragePath()) / std::filesystem::u8path(item.relativePath)).u8string();
+        ChunkManifest manifest;
+        std::string sha;
+        if (!utils::chunkFile(full, manifest.params, manifest.chunks, &sha)) return;
+        // The file changed since it was indexed; its chunks describe other content
+        if (sha != item.sha256) return;
+        written[k] = saveChunks(sha, manifest) ? 1 : 0;
+    });
+    std::size_t count = 0;
+    for (char w : written) count += w ? 1 : 0;
+    if (count > 0) logger::debug("Recorded chunks for " + std::to_string(count) + " large file(s)");
+    return count;
+}
+
+std::size_t RepoManager::updateChunkManifests(unsigned jobs) {
+    std::vector<std::size_t> all(indexData.items.size());
+    for (std::size_t i = 0; i < all.size(); ++i) all[i] = i;
+    std::size_t written = recordChunks(all, jobs);
+
+    // Sidecars of content no longer in the index
+    std::error_code ec;
+    std::vector<std::filesystem::path> stale;
+    for (std::filesystem::directory_iterator it(getChunksDir(), ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (byDigest.findAll(indexData.items, name).empty()) stale.push_back(it->path());
+    }
+    for (const auto& p : stale) std::filesystem::remove(p, ec);
+    return written;
+}
+
+std::size_t RepoManager::updateCatalog(unsigned jobs) {
+    catalog.load();
+    std::vector<std::size_t> todo;
+    std::set<std::string> wanted;
+    for (std::size_t i = 0; i < indexData.items.size(); ++i) {
+        const ContentItem& item = indexData.items[i];
+        if (item.type != ContentType::PK3 || item.sha256.empty()) continue;
+        if (!wanted.insert(item.sha256).second) continue;
+        if (!catalog.find(item.sha256)) todo.push_back(i);
+    }
+    catalog.retain([&wanted](const std::string& sha) { return wanted.count(sha) > 0; });
+
+    // Only the central directory is read, so this is cheap even for huge packs
+    std::vector<std::vector<AssetEntry>> listings(todo.size());
+    std::vector<char> read(todo.size(), 0);
+    utils::parallelFor(todo.size(), jobs, [&](std::size_t k) {
+        const ContentItem& item = indexData.items[todo[k]];
+        std::string full = (std::filesystem::path(getStoragePath()) / std::filesystem::u8path(item.relativePath)).u8string();
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(full, ec)) return;
+        std::vector<ziputil::Entry> entries;
+        std::string err;
+        // Unreadable archives are cataloged as empty so they are not retried
+        read[k] = 1;
+        if (!ziputil::listArchive(full, entries, err)) {
+            logger::debug("catalog: " + item.relativePath + ": " + err);
+            return;
+        }
+        auto& out = listings[k];
+        out.reserve(entries.size());
+        for (auto& e : entries) {
+            if (e.isDirectory() || e.name.find_first_of("\r\n") != std::string::npos) continue;
+            out.push_back({std::move(e.name), e.uncompressedSize, e.crc32});
+        }
+    });
+    std::size_t count = 0;
+    for (std::size_t k = 0; k < todo.size(); ++k) {
+        if (!read[k]) continue;
+        catalog.store(indexData.items[todo[k]].sha256, std::move(listings[k]));
+        ++count;
+    }
+    if (ensureStateDir() && !catalog.save()) logger::warning("Failed to save asset catalog: " + getCatalogPath());
+    return count;
+}
+
+std::vector<AssetMatch> RepoManager::findAsset(const std::string& query, unsigned jobs) {
+    std::vector<AssetMatch> matches;
+    updateCatalog(jobs);
+    auto fold = [](char c) {
+        return c == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    };
+    auto same = [&fold](char a, char b) { return fold(a) == fold(b); };
+    for (std::size_t i = 0; i < indexData.items.size(); ++i) {
+        const ContentItem& item = indexData.items[i];
+        if (item.type != ContentType::PK3) continue;
+        const std::vector<AssetEntry>* entries = catalog.find(item.sha256);
+        if (!entries) continue;
+        for (const auto& e : *entries) {
+            if (std::search(e.path.begin(), e.path.end(), query.begin(), query.end(), same) != e.path.end()) {
+                matches.push_back({i, e});
+            }
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [this](const AssetMatch& a, const AssetMatch& b) {
+        if (a.asset.path != b.asset.path) return a.asset.path < b.asset.path;
+        return indexData.items[a.item].relativePath < indexData.items[b.item].relativePath;
+    });
+    return matches;
+}
+
+DedupReport RepoManager::dedupFiles(unsigned jobs) {
+    DedupReport report;
+    if (!ensureStateDir() || !objects.create()) {
+        logger::error("Cannot create object store: " + objects.directory());
+        report.failed = indexData.items.size();
+        return report;
+    }
+
+    // Each distinct path once; the digest on disk decides the blob, not the index
+    std::vector<std::string> rels;
+    std::vector<uint64_t> sizes;
+    for (const auto& item : indexData.items) {
+        if (findByPath(item.relativePath) != &item) continue;
+        std::filesystem::path full = std::filesystem::path(getStoragePath()) / std::filesystem::u8path(item.relativePath);
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(full, ec);
+        if (ec) continue;
+        rels.push_back(item.relativePath);
+        sizes.push_back(static_cast<uint64_t>(size));
+    }
+    std::vector<std::string> digests = hashFiles(rels, jobs, true);
+
+    for (std::size_t i = 0; i < rels.size(); ++i) {
+        std::string full = (std::filesystem::path(getStoragePath()) / std::filesystem::u8path(rels[i])).u8string();
+        bool duplicate = false;
+        ObjectStore::LinkKind kind = ObjectStore::LinkKind::Copy;
+        if (digests[i].empty() || !objects.adoptFile(full, digests[i], duplicate, &kind)) {
+            logger::warning("Not deduplicated: " + rels[i]);
+            ++report.failed;
+            continue;
+        }
+        ++report.files;
+        if (duplicate) {
+            ++report.duplicates;
+            // A copy of the blob takes as much space as the file did
+            if (kind != ObjectStore::LinkKind::Copy) report.savedBytes += sizes[i];
+        }
+    }
+    return report;
+}
+
+GcReport RepoManager::gcObjects() {
+    GcReport report;
+    if (!objects.enabled()) return report;
+    for (const auto& sha : objects.list()) {
+        if (!byDigest.findAll(indexData.items, sha).empty()) continue;
+        uint64_t freed = 0;
+        if (objects.remove(sha, freed)) {
+            ++report.removed;
+            report.freedBytes += freed;
+        }
+    }
+    objects.removeTemporaries();
+    return report;
+}
+
 bool RepoManager::renameItem(const std::string& itemId, const std::string& newName) {
     try {
         // Find the item in the index
-        auto it = std::find_if(indexData.items.begin(), indexData.items.end(),
-                              [&itemId](const ContentItem& item) { return item.id == itemId; });
-        
-        if (it == indexData.items.end()) {
+        ContentItem* it = findMutable(itemId);
+        if (!it) {
             logger::error("Item not found: " + itemId);
             return false;
         }
@@ -319,7 +1016,7 @@ bool RepoManager::renameItem(const std::string& itemId, const std::string& newNa
         it->name = newName;
         
         // Save updated index
-        if (!saveIndex()) {
+        if (!journalMutation({{"op", "rename"}, {"id", itemId}, {"name", newName}})) {
             logger::error("Failed to save index after renaming item");
             return false;
         }
@@ -334,12 +1031,12 @@ bool RepoManager::renameItem(const std::string& itemId, const std::string& newNa
 
 bool RepoManager::moveItem(const std::string& itemId, const std::string& newRelativePath) {
     try {
-        auto it = std::find_if(indexData.items.begin(), indexData.items.end(),
-                               [&itemId](const ContentItem& item) { return item.id == itemId; });
-        if (it == indexData.items.end()) {
+        std::size_t pos = byId.find(indexData.items, itemId);
+        if (pos == ItemHashIndex::npos) {
             logger::error("Item not found: " + itemId);
             return false;
         }
+        ContentItem* it = &indexData.items[pos];
         std::string normalized = utils::normalizeRelative(newRelativePath);
         if (!utils::isSafeRelativePath(normalized)) {
             logger::error("Unsafe relative path for move: " + newRelativePath);
@@ -359,10 +1056,12 @@ bool RepoManager::moveItem(const std::string& itemId, const std::string& newRela
             logger::error(std::string("Move failed: ") + ec.message());
             return false;
         }
+        byPath.erase(indexData.items, pos);
         it->relativePath = normalized;
+        byPath.insert(indexData.items, pos);
         it->updatedAt = static_cast<uint64_t>(
             std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
-        if (!saveIndex()) {
+        if (!journalMutation({{"op", "move"}, {"id", itemId}, {"path", normalized}, {"updated_at", it->updatedAt}})) {
             logger::error("Failed to save index after move");
             return false;
         }
@@ -379,9 +1078,8 @@ bool RepoManager::updateItemMetadata(const std::string& itemId,
                             const std::string& newAuthor,
                             const std::vector<std::string>& newTags) {
     try {
-        auto it = std::find_if(indexData.items.begin(), indexData.items.end(),
-                               [&itemId](const ContentItem& item) { return item.id == itemId; });
-        if (it == indexData.items.end()) {
+        ContentItem* it = findMutable(itemId);
+        if (!it) {
             logger::error("Item not found: " + itemId);
             return false;
         }
@@ -393,7 +1091,11 @@ bool RepoManager::updateItemMetadata(const std::string& itemId,
         it->updatedAt = static_cast<uint64_t>(
             std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
 
-        if (!saveIndex()) {
+        nlohmann::json record = {
+            {"op", "update"}, {"id", itemId}, {"name", it->name}, {"description", it->description},
+            {"author", it->author}, {"tags", it->tags}, {"updated_at", it->updatedAt}
+        };
+        if (!journalMutation(record)) {
             logger::error("Failed to save index after metadata update");
             return false;
         }
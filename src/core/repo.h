@@ -6,23 +6,134 @@
 #include <optional>
 #include <nlohmann/json.hpp>
 #include "types.h"
+#include "item_index.h"
+#include "hash_cache.h"
+#include "object_store.h"
+#include "merkle.h"
+#include "chunk_manifest.h"
+#include "asset_catalog.h"
 
 namespace core {
 
+// One file to import through RepoManager::addFiles
+struct AddRequest {
+    std::string sourcePath;
+    ContentType type = ContentType::PK3;
+    std::string relativePath;
+    std::string name;
+    std::string description;
+    std::string author;
+    std::vector<std::string> tags;
+    std::string downloadUrl;
+};
+
+// Result of RepoManager::verify
+struct VerifyReport {
+    enum class Problem { Missing, HashMismatch };
+    struct Entry {
+        Problem problem;
+        std::size_t item;          // position in index().items
+        std::string actualSha256;  // for HashMismatch
+        // For HashMismatch on files with a chunk sidecar: the damaged
+        // (offset, length) byte ranges, adjacent chunks merged
+        std::vector<std::pair<uint64_t, uint64_t>> corruptRanges;
+    };
+    std::vector<Entry> problems;   // in item order
+    std::vector<std::pair<std::string, int>> duplicatePaths; // path, occurrences
+    std::vector<std::pair<std::string, int>> duplicateIds;   // id, occurrences
+    std::size_t missing = 0;
+    std::size_t hashMismatch = 0;
+    std::size_t dupPaths = 0;      // extra occurrences beyond the first
+    std::size_t dupIds = 0;
+    std::size_t hashed = 0;        // files actually read (not served from the hash cache)
+};
+
+// Result of RepoManager::applyChanges
+struct ChangeReport {
+    std::size_t added = 0;
+    std::size_t updated = 0;       // digest changed
+    std::size_t removed = 0;
+};
+
+// One hit of RepoManager::findAsset
+struct AssetMatch {
+    std::size_t item;              // position in index().items (the pk3)
+    AssetEntry asset;
+};
+
+// Result of RepoManager::dedupFiles
+struct DedupReport {
+    std::size_t files = 0;         // indexed files now backed by a blob
+    std::size_t duplicates = 0;    // of those, files whose content was already stored
+    std::size_t failed = 0;
+    uint64_t savedBytes = 0;       // size of the duplicates now sharing storage
+};
+
+// Result of RepoManager::gcObjects
+struct GcReport {
+    std::size_t removed = 0;       // blobs no item refers to
+    uint64_t freedBytes = 0;       // space released (blobs still linked elsewhere free nothing)
+};
+
 class RepoManager {
 public:
     explicit RepoManager(const std::string& rootDir);
 
     bool init(const std::string& name, const std::string& description);
+    // Loads index.json (or its snapshot) and replays pending journal records
     bool loadIndex();
+    // Writes the whole index to index.json and clears the journal
     bool saveIndex() const;
+    // Folds pending journal records into index.json; no-op when there are none
+    bool compactIndex();
 
     // Remove entries whose files are missing from the repo root.
     // Returns number of removed items.
     std::size_t pruneMissingFiles();
 
-    // Discover files present on disk but missing in index; returns number added
-    std::size_t discoverNewFiles();
+    // Discover files present on disk but missing in index; returns number added.
+    // New files are hashed on up to `jobs` threads (0 = one per core).
+    std::size_t discoverNewFiles(unsigned jobs = 0);
+
+    // Incremental counterpart of prune + discover for a known set of changed
+    // paths (e.g. from a file watcher). Each path may be a file or directory
+    // relative to the repo root: new files are added, files whose content
+    // changed get a new digest, and items at or under vanished paths are
+    // dropped from the index. Only new or modified files are hashed.
+    ChangeReport applyChanges(const std::vector<std::string>& relativePaths, unsigned jobs = 0);
+
+    // index.json, .git* and .repoman/ are never indexed or watched
+    static bool isInternalPath(const std::string& relativePath);
+
+    // Items of at least this many bytes get a chunk sidecar (see
+    // ChunkManifest); 0 disables chunking. Process-wide, from config.
+    static void setChunkThreshold(uint64_t bytes);
+    static uint64_t chunkThreshold();
+    // Writes index.json without indentation (smaller and faster, harder to
+    // diff). Process-wide, from config.
+    static void setCompactIndexJson(bool compact);
+    static bool compactIndexJsonEnabled();
+    // Writes missing sidecars for large items, chunking on up to `jobs`
+    // threads, and deletes sidecars no item refers to. Adding or re-indexing
+    // a large file records its sidecar already; this backfills the rest.
+    // Returns the number of sidecars written.
+    std::size_t updateChunkManifests(unsigned jobs = 0);
+    // Sidecar for a digest; false if there is none
+    bool loadChunks(const std::string& sha256, ChunkManifest& out) const;
+
+    // Reads the central directory of every pk3 item not cataloged yet (on
+    // up to `jobs` threads, nothing is extracted) and forgets archives that
+    // are no longer indexed. Returns the number of archives read.
+    std::size_t updateCatalog(unsigned jobs = 0);
+    // Files inside pk3 items whose path contains query (case-insensitive,
+    // '\' taken as '/'), ordered by asset path, then pack path. Brings the
+    // catalog up to date first.
+    std::vector<AssetMatch> findAsset(const std::string& query, unsigned jobs = 0);
+
+    // Check every item for a missing file or digest mismatch and report
+    // duplicate paths/ids. Files are hashed on up to `jobs` threads; unless
+    // deep is set, unchanged files take their digest from the hash cache.
+    VerifyReport verify(unsigned jobs = 0, bool deep = false) const;
 
     // Add file to repo with metadata; returns id
     std::optional<std::string> addFile(const std::string& sourcePath,
@@ -34,9 +145,23 @@ public:
                                        const std::vector<std::string>& tags,
                                        const std::string& downloadUrl);
 
+    // Import several files; the index is written once at the end.
+    // Result i holds the new id for requests[i], or nullopt if it failed.
+    std::vector<std::optional<std::string>> addFiles(const std::vector<AddRequest>& requests);
+
+    // Batch mode: mutations between beginBatch() and commitBatch() only touch
+    // the in-memory index; commitBatch() persists them with one saveIndex().
+    // Batches nest; only the outermost commit writes.
+    void beginBatch();
+    bool commitBatch();
+    bool inBatch() const { return batchDepth > 0; }
+
     // Remove item by ID (removes from index and deletes file)
     bool removeItem(const std::string& itemId);
 
+    // Remove several items in one pass; returns number removed
+    std::size_t removeItems(const std::vector<std::string>& itemIds);
+
     // Rename item by ID
     bool renameItem(const std::string& itemId, const std::string& newName);
 
@@ -44,6 +169,15 @@ public:
     // newRelativePath is relative to the repo root; directories will be created as needed
     bool moveItem(const std::string& itemId, const std::string& newRelativePath);
 
+    // Moves the repo to the object store (creating it if needed): every
+    // indexed file becomes a link to a blob, identical files share one.
+    // Files are hashed on up to `jobs` threads. Afterwards addFile imports
+    // through the store.
+    DedupReport dedupFiles(unsigned jobs = 0);
+    // Deletes blobs that no item refers to
+    GcReport gcObjects();
+    bool objectStoreEnabled() const { return objects.enabled(); }
+
     // Update item metadata fields
     bool updateItemMetadata(const std::string& itemId,
                             const std::string& newName,
@@ -51,22 +185,115 @@ public:
                             const std::string& newAuthor,
                             const std::vector<std::string>& newTags);
 
+    // Read-only: all changes go through RepoManager so lookups stay in sync
     const RepoIndex& index() const { return indexData; }
-    RepoIndex& index() { return indexData; }
+    // Merkle summary of the current items; its root is saved as "tree_root"
+    MerkleTree merkleTree() const { return MerkleTree::build(indexData.items); }
+
+    // Hashed lookups; nullptr/empty when absent. Returned pointers are
+    // invalidated by the next mutation.
+    const ContentItem* findById(const std::string& id) const;
+    // relativePath is normalized (separators, leading ./ or /) before lookup
+    const ContentItem* findByPath(const std::string& relativePath) const;
+    std::vector<const ContentItem*> findByDigest(const std::string& sha256) const;
 
     std::string getRoot() const { return root; }
     std::string getIndexPath() const;
+    // Local, non-versioned state (caches, snapshots). Ignored by git and discovery.
+    std::string getStateDir() const;
+    // Binary snapshot of index.json used for fast loads
+    std::string getSnapshotPath() const;
+    // Append-only log of mutations not yet folded into index.json
+    std::string getJournalPath() const;
+    // Content-addressable blob store, see ObjectStore
+    std::string getObjectsDir() const;
+    // Chunk sidecars by digest, see ChunkManifest
+    std::string getChunksDir() const;
+    // Listings of pk3 contents, see AssetCatalog
+    std::string getCatalogPath() const;
+    // Digests of the items as last pulled, see pullDelta
+    std::string getPullBasePath() const;
     // Where files are stored inside repo. Currently the repo root (mirrors install layout).
     std::string getStoragePath() const;
 
 private:
     std::string root;
     RepoIndex indexData;
+    int batchDepth = 0;
+    bool batchDirty = false;
+
+    // Digests of files by identity (.repoman/hashcache), loaded on first use
+    mutable HashCache hashCache;
+    // Optional blob store (.repoman/objects); in use once dedupFiles created it
+    ObjectStore objects;
+    // pk3 contents by archive digest (.repoman/catalog), loaded on first use
+    AssetCatalog catalog;
+
+    // Secondary indexes over indexData.items
+    ItemHashIndex byId{&ContentItem::id};
+    ItemHashIndex byPath{&ContentItem::relativePath};
+    ItemHashIndex byDigest{&ContentItem::sha256};
+
+    // Rebuilds all secondary indexes after items were replaced or reordered
+    void reindex();
+    // Adds items[pos] to all secondary indexes
+    void indexItem(std::size_t pos);
+    ContentItem* findMutable(const std::string& id);
+    // Removes items flagged in doomed (one flag per item) from the index
+    // only, journaling a remove for each of ids
+    void dropItems(const std::vector<bool>& doomed, const std::vector<std::string>& ids);
+
+    // Digests for repo-relative paths in input order, hashing cache misses on
+    // up to `jobs` threads and recording them in the hash cache. With
+    // chunkLarge, misses that reach the chunk threshold are chunked in the
+    // same read and their sidecars written, so recordChunks skips them.
+    std::vector<std::string> hashFiles(const std::vector<std::string>& relativePaths,
+                                       unsigned jobs, bool trustCache,
+                                       std::size_t* hashedCount = nullptr, bool chunkLarge = false) const;
+    // Writes the sidecar for sha256 unless one exists; manifest.fileSize is
+    // derived from the chunks
+    bool saveChunks(const std::string& sha256, ChunkManifest& manifest) const;
+
+    // Chunks items[positions] that reach the threshold and lack a sidecar;
+    // returns the number of sidecars written
+    std::size_t recordChunks(const std::vector<std::size_t>& positions, unsigned jobs) const;
 
-    // Add an index entry for an existing on-disk file (no copy)
+    // Creates the state directory with a .gitignore so it is never committed
+    bool ensureStateDir() const;
+    // Rewrites the binary snapshot to mirror the current index.json
+    void refreshSnapshot() const;
+    // Persists a single mutation to the journal, compacting when it grows large
+    bool journalMutation(const nlohmann::json& record);
+    // Persists the whole index now, or at commit when inside a batch
+    bool persistIndex();
+
+    // Add an index entry for an existing on-disk file (no copy).
+    // knownSha256 skips hashing when the caller already has the digest.
     bool addIndexEntryForExistingFile(const std::string& relativePath,
                                       ContentType type,
-                                      const std::string& humanName);
+                                      const std::string& humanName,
+                                      const std::string& knownSha256 = "");
+};
+
+// Scoped batch on a RepoManager. Commits on destruction if commit() was not
+// called: file operations already happened, so the index must follow them.
+class IndexTransaction {
+public:
+    explicit IndexTransaction(RepoManager& repo) : repo(repo) { repo.beginBatch(); }
+    ~IndexTransaction() { if (open) repo.commitBatch(); }
+
+    IndexTransaction(const IndexTransaction&) = delete;
+    IndexTransaction& operator=(const IndexTransaction&) = delete;
+
+    bool commit() {
+        if (!open) return true;
+        open = false;
+        return repo.commitBatch();
+    }
+
+private:
+    RepoManager& repo;
+    bool open = true;
 };
 
 }
@@ -11,7 +11,7 @@ static std::string contentTypeToString(ContentType t) {
     return "pk3";
 }
 
-static ContentType contentTypeFromString(const std::string& s) {
+ContentType contentTypeFromString(const std::string& s) {
     if (s == "pk3") return ContentType::PK3;
     if (s == "cfg") return ContentType::CFG;
     return ContentType::EXECUTABLE;
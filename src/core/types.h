@@ -27,6 +27,9 @@ struct ContentItem {
     uint64_t fileSizeBytes;         // size for verification
 };
 
+// index.json additionally carries "tree_root", the MerkleTree root hash of
+// the items, and "item_count", which lets readers size the items up front;
+// RepoManager::saveIndex derives both on every write
 struct RepoIndex {
     std::string version = "1";     // schema version
     std::string repositoryName;
@@ -41,6 +44,9 @@ NLOHMANN_JSON_SERIALIZE_ENUM(ContentType, {
     {ContentType::EXECUTABLE, "exe"}
 })
 
+// Unknown names map to EXECUTABLE
+ContentType contentTypeFromString(const std::string& s);
+
 void to_json(nlohmann::json& j, const ContentItem& v);
 void from_json(const nlohmann::json& j, ContentItem& v);
 void to_json(nlohmann::json& j, const RepoIndex& v);
@@ -11,7 +11,10 @@
 #include "system/logger.h"
 #include "core/repo.h"
 #include "core/types.h"
+#include "core/pull.h"
 #include "utils/hash.h"
+#include "utils/http.h"
+#include "utils/json_records.h"
 
 // Dear ImGui
 #include "imgui.h"
@@ -81,116 +84,46 @@ void ui::resetGitHubOperation(ui::State& s)
     s.operationStatus.clear();
 }
 
+namespace {
+// Fills GitHubRepoInfo rows from a GitHub repository listing
+class RepoListVisitor : public utils::RecordVisitor {
+public:
+    explicit RepoListVisitor(std::vector<ui::GitHubRepoInfo>& repos) : repos(repos) {}
+
+    void beginRecord() override { repo = ui::GitHubRepoInfo{}; }
+    void stringField(const std::string& key, std::string& value) override {
+        if (key == "name") repo.name = std::move(value);
+        else if (key == "full_name") repo.full_name = std::move(value);
+        else if (key == "description") repo.description = std::move(value);
+        else if (key == "html_url") repo.html_url = std::move(value);
+        else if (key == "default_branch") repo.default_branch = std::move(value);
+    }
+    void boolField(const std::string& key, bool value) override {
+        if (key == "private") repo.is_private = value;
+    }
+    void endRecord() override {
+        if (!repo.name.empty()) repos.push_back(std::move(repo));
+    }
+
+private:
+    std::vector<ui::GitHubRepoInfo>& repos;
+    ui::GitHubRepoInfo repo;
+};
+}
+
 void ui::parseGitHubReposList(const std::string& json, std::vector<ui::GitHubRepoInfo>& repos)
 {
     repos.clear();
-    // Simple JSON parsing for GitHub repos
-    size_t pos = 0;
-    while ((pos = json.find("\"name\":", pos)) != std::string::npos) {
-        ui::GitHubRepoInfo repo;
-        
-        // Parse name
-        auto nameStart = json.find("\"", pos + 7);
-        if (nameStart != std::string::npos) {
-            auto nameEnd = json.find("\"", nameStart + 1);
-            if (nameEnd != std::string::npos) {
-                repo.name = json.substr(nameStart + 1, nameEnd - nameStart - 1);
-            }
-        }
-        
-        // Parse full_name
-        auto fullStart = json.find("\"full_name\":", pos);
-        if (fullStart != std::string::npos && fullStart < json.find("\"name\":", pos + 10)) {
-            fullStart = json.find("\"", fullStart + 12);
-            if (fullStart != std::string::npos) {
-                auto fullEnd = json.find("\"", fullStart + 1);
-                if (fullEnd != std::string::npos) {
-                    repo.full_name = json.substr(fullStart + 1, fullEnd - fullStart - 1);
-                }
-            }
-        }
-        
-        // Parse description
-        auto descStart = json.find("\"description\":", pos);
-        if (descStart != std::string::npos && descStart < json.find("\"name\":", pos + 10)) {
-            descStart = json.find("\"", descStart + 14);
-            if (descStart != std::string::npos) {
-                auto descEnd = json.find("\"", descStart + 1);
-                if (descEnd != std::string::npos) {
-                    repo.description = json.substr(descStart + 1, descEnd - descStart - 1);
-                }
-            }
-        }
-        
-        // Parse private status
-        auto privStart = json.find("\"private\":", pos);
-        if (privStart != std::string::npos && privStart < json.find("\"name\":", pos + 10)) {
-            auto boolStart = json.find_first_of("tf", privStart + 10);
-            if (boolStart != std::string::npos) {
-                repo.is_private = (json.substr(boolStart, 4) == "true");
-            }
-        }
-        
-        // Parse html_url
-        auto urlStart = json.find("\"html_url\":", pos);
-        if (urlStart != std::string::npos && urlStart < json.find("\"name\":", pos + 10)) {
-            urlStart = json.find("\"", urlStart + 11);
-            if (urlStart != std::string::npos) {
-                auto urlEnd = json.find("\"", urlStart + 1);
-                if (urlEnd != std::string::npos) {
-                    repo.html_url = json.substr(urlStart + 1, urlEnd - urlStart - 1);
-                }
-            }
-        }
-        
-        // Parse default_branch
-        auto branchStart = json.find("\"default_branch\":", pos);
-        if (branchStart != std::string::npos && branchStart < json.find("\"name\":", pos + 10)) {
-            branchStart = json.find("\"", branchStart + 17);
-            if (branchStart != std::string::npos) {
-                auto branchEnd = json.find("\"", branchStart + 1);
-                if (branchEnd != std::string::npos) {
-                    repo.default_branch = json.substr(branchStart + 1, branchEnd - branchStart - 1);
-                }
-            }
-        }
-        
-        if (!repo.name.empty()) {
-            repos.push_back(repo);
-        }
-        
-        pos = json.find("\"name\":", pos + 10);
-    }
+    RepoListVisitor visitor(repos);
+    utils::parseRecordArray(json, visitor);
 }
 
-void ui::checkRepoCompatibility(const std::string& exeDir, const std::string& token, ui::GitHubRepoInfo& repo)
+void ui::checkRepoCompatibility(const std::string& token, ui::GitHubRepoInfo& repo)
 {
     if (repo.compatibility_checked) return;
     
     // Check compatibility by trying to fetch index.json from default branch
-    std::string tmpIdx = exeDir + "/gh_idx_check.json";
-    std::string rawUrl = std::string("https://raw.githubusercontent.com/") + repo.full_name + "/" + repo.default_branch + "/index.json";
-    std::string getIdx = std::string("curl -sL -H \"Authorization: token ") + token + "\" -H \"Accept: application/vnd.github.v3.raw\" \"" + rawUrl + "\" -o \"" + tmpIdx + "\"";
-    int rc = std::system(getIdx.c_str()); (void)rc;
-    
-    bool compatible = false;
-    try {
-        std::ifstream fi(tmpIdx);
-        if (fi.good()) {
-            // Simple JSON validation - check if it contains required fields
-            std::string content((std::istreambuf_iterator<char>(fi)), std::istreambuf_iterator<char>());
-            fi.close();
-            
-            // Basic check for required JSON structure
-            compatible = (content.find("\"version\"") != std::string::npos) && 
-                        (content.find("\"items\"") != std::string::npos) &&
-                        (content.find("[") != std::string::npos); // items should be an array
-        }
-    } catch (...) { 
-        /* ignore parsing errors */ 
-    }
-    std::filesystem::remove(tmpIdx);
-    
+    bool compatible = core::probeRemoteIndex(utils::http::gitHubRawUrl() + "/" + repo.full_name + "/" + repo.default_branch, token);
     repo.is_compatible = compatible;
     repo.compatibility_checked = true;
 }
@@ -222,6 +155,11 @@ static int RunGui()
     ui::State ui{}; g_ui_state = &ui;
     ui.exeDir = exe;
     config::loadConfig(exe + "/config.json");
+    core::RepoManager::setChunkThreshold(config::getSettings().chunkThresholdMB * 1024 * 1024);
+    core::RepoManager::setCompactIndexJson(config::getSettings().compactIndex);
+    core::ObjectStore::setHardlinks(config::getSettings().objectHardlinks);
+    utils::http::setGitHubUrls(config::getSettings().githubApiUrl, config::getSettings().githubRawUrl);
+    utils::http::gitHub().setCacheDir(exe + "/http_cache");
     ui.selectedRepo = config::getCurrentRepo();
     ui::refreshRepos(ui);
 
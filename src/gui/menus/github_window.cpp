@@ -7,6 +7,8 @@
 #include <iterator>
 #include <thread>
 #include <algorithm>
+#include <map>
+#include <mutex>
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -14,14 +16,91 @@
 #include "system/config.h"
 #include "system/version.h"
 #include "core/repo.h"
+#include "core/pull.h"
 #include "utils/hash.h"
 #include "utils/zip.h"
+#include "utils/http.h"
+#include "utils/parallel.h"
 
 #include "../ui_state.h"
 #include "system/fs.h"
 
 namespace ui { namespace menus {
 
+// One GitHub API call with an optional JSON body
+static utils::http::Response gitHubCall(const std::string& method, const std::string& path,
+                                        const std::string& token, const std::string& body = std::string())
+{
+    utils::http::Request req;
+    req.method = method;
+    req.url = path;
+    req.headers = utils::http::gitHubHeaders(token);
+    if (!body.empty()) {
+        req.headers.emplace_back("Content-Type", "application/json");
+        req.body = body;
+    }
+    return utils::http::gitHub().send(req);
+}
+
+// Page fetches and compatibility probes in flight while listing repos
+static constexpr unsigned kCompatibilityProbes = 16;
+
+// Fills ui.gitHubRepos with the user's repos page by page, then probes each
+// for an index.json; rows are shown as they arrive and updated as their
+// probe finishes
+static void listGitHubRepos(State& ui, const std::string& token)
+{
+    {
+        std::lock_guard<std::mutex> lock(ui.gitHubReposMutex);
+        ui.gitHubRepos.clear();
+    }
+    // Pages arrive in any order; rows are inserted in page order
+    std::map<int, std::size_t> pageRows;
+    std::string listErr;
+    bool listed = utils::http::gitHub().getPages("user/repos?per_page=100", utils::http::gitHubHeaders(token), kCompatibilityProbes,
+        [&](int page, const utils::http::Response& resp) {
+            std::vector<ui::GitHubRepoInfo> rows;
+            ui::parseGitHubReposList(resp.body, rows);
+            std::lock_guard<std::mutex> lock(ui.gitHubReposMutex);
+            std::size_t at = 0;
+            for (const auto& [p, n] : pageRows) if (p < page) at += n;
+            pageRows[page] = rows.size();
+            at = std::min(at, ui.gitHubRepos.size());
+            ui.gitHubRepos.insert(ui.gitHubRepos.begin() + at, rows.begin(), rows.end());
+            ui.operationStatus = "Fetched " + std::to_string(ui.gitHubRepos.size()) + " repositories...";
+        }, listErr);
+    ui.operationProgress = 0.4f;
+
+    std::vector<ui::GitHubRepoInfo> reposTmp;
+    {
+        std::lock_guard<std::mutex> lock(ui.gitHubReposMutex);
+        reposTmp = ui.gitHubRepos;
+    }
+
+    ui.operationStatus = "Checking compatibility...";
+    std::size_t probed = 0, compatibleCount = 0;
+    utils::parallelFor(reposTmp.size(), kCompatibilityProbes, [&](std::size_t i) {
+        ui::GitHubRepoInfo& r = reposTmp[i];
+        ui::checkRepoCompatibility(token, r);
+        std::lock_guard<std::mutex> lock(ui.gitHubReposMutex);
+        for (auto& row : ui.gitHubRepos) {
+            if (row.full_name == r.full_name) {
+                row.is_compatible = r.is_compatible;
+                row.compatibility_checked = true;
+                break;
+            }
+        }
+        if (r.is_compatible) compatibleCount++;
+        ui.operationProgress = 0.4f + 0.58f * (float)(++probed) / (float)reposTmp.size();
+    });
+
+    ui.githubOutput = reposTmp.empty() ?
+        std::string("No repositories found or API error") :
+        (std::string("Found ") + std::to_string(reposTmp.size()) + " repositories (" + std::to_string(compatibleCount) + " compatible)");
+    if (!listed) ui.githubOutput += "\nListing incomplete: " + listErr;
+    ui::resetGitHubOperation(ui);
+}
+
 void drawGitHub(State& ui)
 {
     if (!ui.showGitHubWindow) return;
@@ -36,6 +115,11 @@ void drawGitHub(State& ui)
             for (auto& ch : token) ch = (char)(((uint8_t)ch) ^ key);
             return token;
         };
+        // Extraction fills the 0.7..0.95 part of the progress bar
+        auto extractProgress = [&ui](std::size_t done, std::size_t total, uint64_t) {
+            ui.operationProgress = 0.7f + 0.25f * (total ? (float)done / (float)total : 1.0f);
+            ui.operationStatus = "Extracting files... " + std::to_string(done) + "/" + std::to_string(total);
+        };
 
         // User info and login section
         std::string currentUser = config::Config::getInstance().getGithubUser();
@@ -53,13 +137,9 @@ void drawGitHub(State& ui)
             ImGui::InputText("Token", token, IM_ARRAYSIZE(token), ImGuiInputTextFlags_Password);
             ImGui::Separator();
             if (ImGui::Button("Save & Login")) {
-                std::string tmpFile = ui.exeDir + "/gh_user_gui.json";
-                std::string cmd = std::string("curl -s -H \"Authorization: token ") + token + "\" https://api.github.com/user -o \"" + tmpFile + "\"";
-                int rc = std::system(cmd.c_str()); (void)rc;
-                std::ifstream fin(tmpFile);
-                std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
-                fin.close(); 
-                std::filesystem::remove(tmpFile);
+                // A stale cached answer would log in without reaching GitHub
+                auto me = gitHubCall("GET", "user", token);
+                std::string content = me.stale ? std::string() : me.body;
                 std::string login; 
                 auto pos = content.find("\"login\":");
                 if (pos != std::string::npos) { 
@@ -130,72 +210,23 @@ void drawGitHub(State& ui)
                     ui.operationStatus = "Fetching repositories...";
                     ui.operationProgress = 0.02f;
                     
-                    std::string tmp = ui.exeDir + "/gh_list_gui.json";
-                    std::string cmd = std::string("curl -s -H \"Authorization: token ") + token + "\" https://api.github.com/user/repos?per_page=100 -o \"" + tmp + "\"";
                     
                     
                     // Background worker (Windows: Win32 thread; others: std::thread)
                     
 #if defined(_WIN32)
-                    struct GitHubListTask { ui::State* ui; std::string exeDir; std::string token; std::string tmp; std::string cmd; };
-                    auto* task = new GitHubListTask{ &ui, ui.exeDir, token, tmp, cmd };
+                    struct GitHubListTask { ui::State* ui; std::string token; };
+                    auto* task = new GitHubListTask{ &ui, token };
                     HANDLE h = CreateThread(NULL, 0, [](LPVOID lp)->DWORD {
                         auto* t = static_cast<GitHubListTask*>(lp);
-                        std::system(t->cmd.c_str());
-                        t->ui->operationStatus = "Parsing repositories...";
-                        t->ui->operationProgress = 0.4f;
-                        std::ifstream fin(t->tmp);
-                        std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
-                        fin.close();
-                        std::filesystem::remove(t->tmp);
-                        
-                        std::vector<ui::GitHubRepoInfo> reposTmp;
-                        ui::parseGitHubReposList(content, reposTmp);
-                        
-                        t->ui->operationStatus = "Checking compatibility...";
-                        t->ui->operationProgress = 0.7f;
-                        size_t compatibleCount = 0;
-                        for (auto &r : reposTmp) {
-                            ui::checkRepoCompatibility(t->exeDir, t->token, r);
-                            if (r.is_compatible) compatibleCount++;
-                        }
-                        
-                        t->ui->gitHubRepos.swap(reposTmp);
-                        t->ui->githubOutput = t->ui->gitHubRepos.empty() ?
-                            std::string("No repositories found or API error") :
-                            (std::string("Found ") + std::to_string(t->ui->gitHubRepos.size()) + " repositories (" + std::to_string(compatibleCount) + " compatible)");
-                        ui::resetGitHubOperation(*t->ui);
+                        listGitHubRepos(*t->ui, t->token);
                         delete t;
                         return 0;
                     }, task, 0, NULL);
                     if (h) CloseHandle(h);
 #else
-                    std::thread([&, tmp, cmd, token]() {
-                        std::system(cmd.c_str());
-                        ui.operationStatus = "Parsing repositories...";
-                        ui.operationProgress = 0.4f;
-                        std::ifstream fin(tmp);
-                        std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
-                        fin.close();
-                        std::filesystem::remove(tmp);
-                        
-                        std::vector<ui::GitHubRepoInfo> reposTmp;
-                        ui::parseGitHubReposList(content, reposTmp);
-                        
-                        ui.operationStatus = "Checking compatibility...";
-                        ui.operationProgress = 0.7f;
-                        size_t compatibleCount = 0;
-                        for (auto &r : reposTmp) {
-                            ui::checkRepoCompatibility(ui.exeDir, token, r);
-                            if (r.is_compatible) compatibleCount++;
-                        }
-                        
-                        // Publish results
-                        ui.gitHubRepos.swap(reposTmp);
-                        ui.githubOutput = ui.gitHubRepos.empty() ?
-                            std::string("No repositories found or API error") :
-                            (std::string("Found ") + std::to_string(ui.gitHubRepos.size()) + " repositories (" + std::to_string(compatibleCount) + " compatible)");
-                        ui::resetGitHubOperation(ui);
+                    std::thread([&, token]() {
+                        listGitHubRepos(ui, token);
                     }).detach();
 #endif
                 }
@@ -227,9 +258,7 @@ void drawGitHub(State& ui)
                         ui.operationStatus = "Downloading archive...";
                         
                         std::string zip = ui.exeDir + "/" + localName + ".zip";
-                        std::string url = std::string("https://api.github.com/repos/") + remote + "/zipball/" + branch;
-                        std::string cmd = std::string("curl -L -H \"Authorization: token ") + token + "\" -o \"" + zip + "\" \"" + url + "\"";
-                        int rc = std::system(cmd.c_str()); (void)rc;
+                        utils::http::gitHub().download("repos/" + remote + "/zipball/" + branch, utils::http::gitHubHeaders(token), zip);
                         
                         ui.operationProgress = 0.7f;
                         ui.operationStatus = "Extracting files...";
@@ -237,7 +266,7 @@ void drawGitHub(State& ui)
                         std::string unzipDir = ui.exeDir + "/ziptmp_" + localName; 
                         std::string err;
                         std::filesystem::create_directories(unzipDir);
-                        if (ziputil::extractArchive(zip, unzipDir, err)) {
+                        if (ziputil::extractArchive(zip, unzipDir, err, 0, extractProgress)) {
                             std::string top; 
                             for (auto& e : std::filesystem::directory_iterator(unzipDir)) 
                                 if (e.is_directory()) { top = e.path().string(); break; }
@@ -297,37 +326,40 @@ void drawGitHub(State& ui)
                             (currentUser.empty() ? ui.selectedRepo : (currentUser + "/" + ui.selectedRepo));
                         std::string branch = strlen(ui.gitHubBranch) > 0 ? ui.gitHubBranch : "main";
                         
-                        std::string zip = ui.exeDir + "/pull_tmp.zip"; 
-                        std::string url = "https://api.github.com/repos/" + remotePath + "/zipball/" + branch;
-                        std::string cmd = std::string("curl -L -H \"Authorization: token ") + token + "\" -o \"" + zip + "\" \"" + url + "\"";
-                        int rc = std::system(cmd.c_str()); (void)rc;
-                        
-                        ui.operationProgress = 0.7f;
-                        ui.operationStatus = "Merging changes...";
-                        
-                        std::string unzipDir = ui.exeDir + "/pull_unzip_tmp"; 
-                        std::string err; 
-                        std::filesystem::create_directories(unzipDir);
-                        if (ziputil::extractArchive(zip, unzipDir, err)) {
-                            std::string top; 
-                            for (auto& e : std::filesystem::directory_iterator(unzipDir)) 
-                                if (e.is_directory()) { top = e.path().string(); break; }
-                            if (!top.empty()) {
-                                std::string repoRoot = ui.exeDir + "/repos/" + ui.selectedRepo;
-                                for (auto& p : std::filesystem::recursive_directory_iterator(top)) 
-                                    if (p.is_regular_file()) {
-                                        auto rel = std::filesystem::relative(p.path(), top).string();
-                                        std::filesystem::path dest = std::filesystem::path(repoRoot) / rel;
-                                        std::filesystem::create_directories(dest.parent_path());
-                                        std::error_code ec_rm; std::filesystem::remove(dest, ec_rm);
-                                        std::error_code ec_cp; std::filesystem::copy_file(p.path(), dest, std::filesystem::copy_options::overwrite_existing, ec_cp);
-                                    }
+                        std::string url = "repos/" + remotePath + "/zipball/" + branch;
+                        std::string repoRoot = ui.exeDir + "/repos/" + ui.selectedRepo;
+                        core::PullReport pullReport;
+                        std::string err;
+                        auto pullProgress = [&ui](const core::PullReport& r) {
+                            ui.operationStatus = "Applying changes... " + std::to_string(r.written + r.unchanged) + " files";
+                        };
+                        // Fetch only changed items when the remote index allows it
+                        std::string rawBase = utils::http::gitHubRawUrl() + "/" + remotePath + "/" + branch;
+                        core::RepoIndex remoteIndex;
+                        std::string remoteJson;
+                        bool pulledOk = core::fetchRemoteIndex(rawBase, token, remoteIndex, remoteJson) &&
+                                        core::pullDelta(repoRoot, remoteIndex, remoteJson, rawBase, token, 0, pullReport, err, pullProgress);
+                        if (!pulledOk) pulledOk = core::pullZipball(repoRoot, url, token, ui.exeDir, pullReport, err, pullProgress);
+                        if (pulledOk) {
+                            ui.githubOutput = " Successfully pulled changes from " + remotePath + " (" +
+                                              std::to_string(pullReport.written) + " written, " +
+                                              std::to_string(pullReport.removed) + " removed, " +
+                                              std::to_string(pullReport.unchanged) + " unchanged)";
+                            if (pullReport.kept > 0) {
+                                ui.githubOutput += "\n Kept " + std::to_string(pullReport.kept) +
+                                                   " local file(s) not in the remote index (see log)";
+                            }
+                            // Check pulled files against the new index and refresh the hash cache
+                            core::RepoManager pulled(repoRoot);
+                            if (pulled.loadIndex()) {
+                                core::VerifyReport report = pulled.verify();
+                                if (report.missing > 0 || report.hashMismatch > 0) {
+                                    ui.githubOutput += "\n Warning: " + std::to_string(report.missing) + " missing, " +
+                                                       std::to_string(report.hashMismatch) + " mismatched file(s)";
+                                }
                             }
-                            std::filesystem::remove_all(unzipDir); 
-                            std::filesystem::remove(zip); 
-                            ui.githubOutput = " Successfully pulled changes from " + remotePath;
                         } else {
-                            ui.githubOutput = " Extract failed: " + err;
+                            ui.githubOutput = " Pull failed: " + err;
                         }
                         ui::resetGitHubOperation(ui);
                     }
@@ -382,37 +414,16 @@ void drawGitHub(State& ui)
                         std::string body = std::string("{\"name\":\"") + (hasOwner ? remote.substr(remote.find('/')+1) : remote) + 
                                           "\",\"private\":" + (ui.gitHubPrivate ? "true" : "false") + "}";
                         std::string url = hasOwner ? 
-                            ("https://api.github.com/orgs/" + remote.substr(0, remote.find('/')) + "/repos") :
-                            "https://api.github.com/user/repos";
-                        
-                        std::string bodyFile = ui.exeDir + "/gh_create_body.json";
-                        std::ofstream bf(bodyFile, std::ios::binary);
-                        bf << body;
-                        bf.close();
-                        
-                        // Try create at intended URL, capture HTTP code
-                        std::string httpCodeFile = ui.exeDir + "/gh_create_code.txt";
-                        std::string cmd = std::string("curl -s -o \"") + (ui.exeDir + "/gh_create_resp.json") + "\" -w \"%{http_code}\" -X POST -H \"Authorization: token " + token + 
-                                         "\" -H \"Content-Type: application/json\" --data @\"" + bodyFile + "\" \"" + url + "\" > \"" + httpCodeFile + "\"";
-                        std::system(cmd.c_str());
-                        std::filesystem::remove(bodyFile);
+                            ("orgs/" + remote.substr(0, remote.find('/')) + "/repos") :
+                            "user/repos";
+                        auto created = gitHubCall("POST", url, token, body);
                         
                         // If org creation failed (likely 404/403), retry under user namespace and adjust remotePath
-                        if (hasOwner) {
-                            std::ifstream codeIn(httpCodeFile);
-                            std::string codeStr; codeIn >> codeStr; codeIn.close();
-                            std::filesystem::remove(httpCodeFile);
-                            if (codeStr != "201" && codeStr != "200") {
-                                std::string userUrl = "https://api.github.com/user/repos";
-                                std::string cmd2 = std::string("curl -s -X POST -H \"Authorization: token ") + token +
-                                                  "\" -H \"Content-Type: application/json\" --data \"" + body + "\" \"" + userUrl + "\"";
-                                std::system(cmd2.c_str());
-                                if (!currentUser.empty()) {
-                                    remotePath = currentUser + "/" + remote.substr(remote.find('/')+1);
-                                }
+                        if (hasOwner && created.status != 201 && created.status != 200) {
+                            gitHubCall("POST", "user/repos", token, body);
+                            if (!currentUser.empty()) {
+                                remotePath = currentUser + "/" + remote.substr(remote.find('/')+1);
                             }
-                        } else {
-                            std::filesystem::remove(httpCodeFile);
                         }
                     }
                     
@@ -442,6 +453,11 @@ void drawGitHub(State& ui)
                     std::system(gitCmd(std::string("git remote remove origin") + redirectStderrToNull).c_str());
                     std::system(gitCmd(std::string("git remote add origin \"") + https + "\"").c_str());
                     std::system(gitCmd(std::string("git checkout -B ") + branch).c_str());
+                    {
+                        // Fold pending journal records so the pushed index.json is complete
+                        core::RepoManager pushRepo(repoRoot);
+                        if (pushRepo.loadIndex()) pushRepo.compactIndex();
+                    }
                     std::system(gitCmd("git add .").c_str());
                     std::system(gitCmd(std::string("git commit -m \"Update via RepoMan GUI\"") + redirectStderrToNull).c_str());
                     int pushResult = std::system(gitCmd(std::string("git push ") + (ui.gitHubForce ? "-f " : "") + "-u origin " + branch + redirectStderrToNull).c_str());
@@ -467,7 +483,8 @@ void drawGitHub(State& ui)
 
         ImGui::Separator();
         
-        // Repository list display (human-readable)
+        // Repository list display (human-readable); the list worker updates rows meanwhile
+        std::unique_lock<std::mutex> reposLock(ui.gitHubReposMutex);
         if (!ui.gitHubRepos.empty()) {
             static bool showOnlyCompatible = true;
             ImGui::Text("Your Repositories:");
@@ -477,7 +494,7 @@ void drawGitHub(State& ui)
             // Filter repositories based on compatibility
             std::vector<std::reference_wrapper<const ui::GitHubRepoInfo>> filteredRepos;
             for (const auto& repo : ui.gitHubRepos) {
-                if (!showOnlyCompatible || repo.is_compatible) {
+                if (!showOnlyCompatible || repo.is_compatible || !repo.compatibility_checked) {
                     filteredRepos.push_back(std::cref(repo));
                 }
             }
@@ -534,27 +551,13 @@ void drawGitHub(State& ui)
                             std::string token = decodeToken(ui.exeDir);
                             if (!token.empty()) {
                                 std::string body = std::string("{\"private\":") + (repo.is_private ? "false" : "true") + "}";
-                                std::string bodyFile = ui.exeDir + "/gh_vis_body_ctx.json";
-                                std::ofstream bf(bodyFile);
-                                bf << body;
-                                bf.close();
-                                std::string cmd = std::string("curl -s -X PATCH -H \"Authorization: token ") + token +
-                                                 "\" -H \"Content-Type: application/json\" --data @\"" + bodyFile +
-                                                 "\" \"https://api.github.com/repos/" + repo.full_name + "\"";
-                                int result = std::system(cmd.c_str());
-                                std::filesystem::remove(bodyFile);
-                                ui.githubOutput = result == 0 ? (std::string("Visibility updated for ") + repo.full_name)
-                                                              : (std::string("Failed to update visibility for ") + repo.full_name);
-                                // Fetch fresh repo info and update row
-                                if (result == 0) {
-                                    std::string tmp = ui.exeDir + "/gh_repo_refresh.json";
-                                    std::string getCmd = std::string("curl -s -H \"Authorization: token ") + token +
-                                                         "\" \"https://api.github.com/repos/" + repo.full_name + "\" -o \"" + tmp + "\"";
-                                    std::system(getCmd.c_str());
-                                    std::ifstream fin(tmp);
-                                    std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
-                                    fin.close();
-                                    std::filesystem::remove(tmp);
+                                auto updated = gitHubCall("PATCH", "repos/" + repo.full_name, token, body);
+                                bool result = updated.ok();
+                                ui.githubOutput = result ? (std::string("Visibility updated for ") + repo.full_name)
+                                                         : (std::string("Failed to update visibility for ") + repo.full_name);
+                                // The response carries the updated repo; refresh the row from it
+                                if (result) {
+                                    const std::string& content = updated.body;
                                     // Minimal parse of 'private' and 'description'
                                     auto find_bool = [&](const std::string& key)->bool { auto p = content.find(key); if(p==std::string::npos) return false; auto q = content.find_first_of("tf", p); return q!=std::string::npos && content.substr(q,4)=="true"; };
                                     auto find_string = [&](const std::string& key)->std::string { auto p=content.find(key); if(p==std::string::npos) return std::string(); auto q1=content.find('"', p+key.size()); if(q1==std::string::npos) return std::string(); auto q2=content.find('"', q1+1); if(q2==std::string::npos) return std::string(); return content.substr(q1+1, q2-q1-1); };
@@ -574,12 +577,10 @@ void drawGitHub(State& ui)
                         if (ImGui::MenuItem("Delete Repository")) {
                             std::string token = decodeToken(ui.exeDir);
                             if (!token.empty()) {
-                                std::string cmd = std::string("curl -s -X DELETE -H \"Authorization: token ") + token +
-                                                 "\" \"https://api.github.com/repos/" + repo.full_name + "\"";
-                                int result = std::system(cmd.c_str());
-                                ui.githubOutput = result == 0 ? (std::string("Repository deleted: ") + repo.full_name)
-                                                              : (std::string("Failed to delete repository: ") + repo.full_name);
-                                if (result == 0) {
+                                bool result = gitHubCall("DELETE", "repos/" + repo.full_name, token).status == 204;
+                                ui.githubOutput = result ? (std::string("Repository deleted: ") + repo.full_name)
+                                                         : (std::string("Failed to delete repository: ") + repo.full_name);
+                                if (result) {
                                     // Remove from table immediately
                                     ui.gitHubRepos.erase(std::remove_if(ui.gitHubRepos.begin(), ui.gitHubRepos.end(), [&](const ui::GitHubRepoInfo& r){return r.full_name==repo.full_name;}), ui.gitHubRepos.end());
                                 }
@@ -594,7 +595,9 @@ void drawGitHub(State& ui)
                     }
                     
                     ImGui::TableSetColumnIndex(1);
-                    if (repo.is_compatible) {
+                    if (!repo.compatibility_checked) {
+                        ImGui::TextDisabled("Checking...");
+                    } else if (repo.is_compatible) {
                         ImGui::TextColored(ImVec4(0.0f, 0.8f, 0.0f, 1.0f), "Compatible");
                     } else {
                         ImGui::TextColored(ImVec4(0.8f, 0.4f, 0.0f, 1.0f), "Incompatible");
@@ -625,24 +628,9 @@ void drawGitHub(State& ui)
                     if (!token.empty() && strlen(ui.gitHubSelectedFullName) > 0) {
                         // PATCH repo name
                         std::string owner_repo = ui.gitHubSelectedFullName;
-                        std::string bodyFile = ui.exeDir + "/gh_rename_body.json";
-                        std::ofstream bf(bodyFile);
-                        bf << std::string("{\"name\":\"") << ui.githubRenameBuffer << "\"}";
-                        bf.close();
-                        std::string cmd = std::string("curl -s -X PATCH -H \"Authorization: token ") + token +
-                                         "\" -H \"Content-Type: application/json\" --data @\"" + bodyFile +
-                                         "\" \"https://api.github.com/repos/" + owner_repo + "\"";
-                        std::system(cmd.c_str());
-                        std::filesystem::remove(bodyFile);
-                        // Fetch fresh data and update row
-                        std::string tmp = ui.exeDir + "/gh_repo_refresh.json";
-                        std::string getCmd = std::string("curl -s -H \"Authorization: token ") + token +
-                                             "\" \"https://api.github.com/repos/" + owner_repo + "\" -o \"" + tmp + "\"";
-                        std::system(getCmd.c_str());
-                        std::ifstream fin(tmp);
-                        std::string content((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
-                        fin.close();
-                        std::filesystem::remove(tmp);
+                        std::string body = std::string("{\"name\":\"") + ui.githubRenameBuffer + "\"}";
+                        // The response carries the updated repo; refresh the row from it
+                        std::string content = gitHubCall("PATCH", "repos/" + owner_repo, token, body).body;
                         // Parse name/full_name/description/private
                         auto find_string = [&](const std::string& key)->std::string { auto p=content.find(key); if(p==std::string::npos) return std::string(); auto q1=content.find('"', p+key.size()); if(q1==std::string::npos) return std::string(); auto q2=content.find('"', q1+1); if(q2==std::string::npos) return std::string(); return content.substr(q1+1, q2-q1-1); };
                         auto find_bool = [&](const std::string& key)->bool { auto p=content.find(key); if(p==std::string::npos) return false; auto q=content.find_first_of("tf", p); return q!=std::string::npos && content.substr(q,4)=="true"; };
@@ -669,6 +657,8 @@ void drawGitHub(State& ui)
             }
         }
         
+        reposLock.unlock();
+        
         // Status/output area
         ImGui::Text("Status:");
         ImGui::BeginChild("gh_output", ImVec2(0, 80), true);
@@ -696,10 +686,8 @@ void drawGitHub(State& ui)
                 if (ImGui::Button("Yes, DELETE")) {
                     std::string token = decodeToken(ui.exeDir);
                     if (!token.empty() && strlen(ui.gitHubRemote) > 0) {
-                        std::string cmd = std::string("curl -s -X DELETE -H \"Authorization: token ") + token + 
-                                         "\" \"https://api.github.com/repos/" + ui.gitHubRemote + "\"";
-                        int result = std::system(cmd.c_str());
-                        ui.githubOutput = result == 0 ? (" Repository " + std::string(ui.gitHubRemote) + " deleted") :
+                        bool result = gitHubCall("DELETE", std::string("repos/") + ui.gitHubRemote, token).status == 204;
+                        ui.githubOutput = result ? (" Repository " + std::string(ui.gitHubRemote) + " deleted") :
                                                        (" Failed to delete repository");
                     } else {
                         ui.githubOutput = " Please login and specify repository";
@@ -724,18 +712,9 @@ void drawGitHub(State& ui)
                 std::string token = decodeToken(ui.exeDir);
                 if (!token.empty() && strlen(ui.gitHubRemote) > 0) {
                     std::string body = std::string("{\"private\":") + (ui.gitHubVisibility == 1 ? "true" : "false") + "}";
-                    std::string bodyFile = ui.exeDir + "/gh_vis_body.json";
-                    std::ofstream bf(bodyFile);
-                    bf << body;
-                    bf.close();
-                    
-                    std::string cmd = std::string("curl -s -X PATCH -H \"Authorization: token ") + token + 
-                                     "\" -H \"Content-Type: application/json\" --data @\"" + bodyFile + 
-                                     "\" \"https://api.github.com/repos/" + ui.gitHubRemote + "\"";
-                    int result = std::system(cmd.c_str());
-                    std::filesystem::remove(bodyFile);
+                    bool result = gitHubCall("PATCH", std::string("repos/") + ui.gitHubRemote, token, body).ok();
                     
-                    ui.githubOutput = result == 0 ? (" Visibility updated to " + std::string(visOptions[ui.gitHubVisibility])) :
+                    ui.githubOutput = result ? (" Visibility updated to " + std::string(visOptions[ui.gitHubVisibility])) :
                                                    (" Failed to update visibility");
                 } else {
                     ui.githubOutput = " Please login and specify repository";
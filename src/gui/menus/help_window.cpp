@@ -37,7 +37,7 @@ void drawHelpWindow(State& ui)
         if (ImGui::CollapsingHeader("GitHub Manager")) {
             ImGui::BulletText("Login with a token, list repositories, clone/pull/push.");
             ImGui::BulletText("Context menu on a repo row allows renaming, visibility toggle, delete, copy name.");
-            ImGui::BulletText("Compare with GitHub loads remote index.json and shows local/remote status per item.");
+            ImGui::BulletText("Compare with GitHub loads remote index.json and shows local/remote/changed status per item.");
         }
         if (ImGui::CollapsingHeader("Keyboard & Tips")) {
             ImGui::BulletText("Ctrl+Click: multi-select in items table.");
@@ -6,17 +6,45 @@
 #include <iterator>
 #include "system/config.h"
 #include "core/repo.h"
+#include "system/watcher.h"
 #include "utils/hash.h"
 #include "utils/zip.h"
+#include "utils/http.h"
 #include "../ui_state.h"
 #include "github_window.h"
 #include <nlohmann/json.hpp>
 #include <ctime>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
 #ifdef _WIN32
 #include <windows.h>
 #endif
 namespace ui { namespace menus {
+// Runs one asset search on the worker. The index is reloaded in case it
+// changed since the last search; the catalog stays loaded in repo.
+static void searchAssets(State& ui, std::shared_ptr<core::RepoManager> repo,
+                         const std::string& repoName, const std::string& query)
+{
+    std::vector<std::string> results;
+    std::size_t count = 0;
+    if (repo->loadIndex()) {
+        auto matches = repo->findAsset(query);
+        count = matches.size();
+        for (const auto& m : matches) {
+            if (results.size() >= 500) break;
+            results.push_back(m.asset.path + "  <-  " + repo->index().items[m.item].relativePath);
+        }
+    }
+    std::lock_guard<std::mutex> lock(ui.assetMutex);
+    ui.assetResultQuery = query;
+    ui.assetResultRepo = repoName;
+    ui.assetResults = std::move(results);
+    ui.assetResultCount = count;
+    ui.assetSearchBusy = false;
+}
+
 void drawMain(State& ui, bool* p_open)
 {
     static bool firstFrame = true;
@@ -29,7 +57,13 @@ void drawMain(State& ui, bool* p_open)
         // Calculate appropriate window height
         float baseHeight = 300; // Minimum height for UI elements
         float itemsHeight = (float)items.size() * 25.0f + 60.0f; // 25px per row + header
-        float githubHeight = ui.gitHubRepos.empty() ? 0 : std::min(200.0f, (float)ui.gitHubRepos.size() * 20.0f + 100.0f);
+        std::size_t gitHubRows = 0;
+        {
+            // The list worker may be adding rows right now
+            std::lock_guard<std::mutex> lock(ui.gitHubReposMutex);
+            gitHubRows = ui.gitHubRepos.size();
+        }
+        float githubHeight = gitHubRows == 0 ? 0 : std::min(200.0f, (float)gitHubRows * 20.0f + 100.0f);
         float totalHeight = baseHeight + itemsHeight + githubHeight;
         // Clamp to reasonable limits
         totalHeight = std::max(400.0f, std::min(totalHeight, 800.0f));
@@ -153,21 +187,15 @@ void drawMain(State& ui, bool* p_open)
             ImGui::EndPopup();
         }
         if (ImGui::BeginPopupModal("verify_popup", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
-            // Moved verification logic here to ensure repo is in scope
-            size_t missing=0, hashMismatch=0, dupPaths=0, dupIds=0;
-            std::unordered_map<std::string,int> pathCount, idCount;
-            for (const auto& it : repo.index().items) { pathCount[it.relativePath]++; idCount[it.id]++; }
-            for (const auto& it : repo.index().items) {
-                std::string full = repoRoot + "/" + it.relativePath;
-                if (!std::filesystem::exists(full)) { ++missing; continue; }
-                if (!it.sha256.empty()) {
-                    std::string got = utils::computeFileSha256(full);
-                    if (!got.empty() && got != it.sha256) ++hashMismatch;
-                }
+            // Verify once when the popup opens instead of rehashing every frame
+            if (ImGui::IsWindowAppearing()) {
+                core::VerifyReport report = repo.verify();
+                ui.verifyMissing = report.missing;
+                ui.verifyHashMismatch = report.hashMismatch;
+                ui.verifyDupPaths = report.dupPaths;
+                ui.verifyDupIds = report.dupIds;
             }
-            for (auto& kv : pathCount) if (kv.second>1) dupPaths += kv.second-1;
-            for (auto& kv : idCount) if (kv.second>1) dupIds += kv.second-1;
-            ImGui::Text("Missing: %zu\nHash mismatch: %zu\nDup paths: %zu\nDup ids: %zu", missing, hashMismatch, dupPaths, dupIds);
+            ImGui::Text("Missing: %zu\nHash mismatch: %zu\nDup paths: %zu\nDup ids: %zu", ui.verifyMissing, ui.verifyHashMismatch, ui.verifyDupPaths, ui.verifyDupIds);
             if (ImGui::Button("Close")) ImGui::CloseCurrentPopup();
             ImGui::EndPopup();
         }
@@ -265,6 +293,7 @@ void drawMain(State& ui, bool* p_open)
                     }
                 }
                 std::vector<std::string> files = ui.dropQueue.empty() ? std::vector<std::string>{ui.addSrc} : ui.dropQueue;
+                std::vector<core::AddRequest> requests;
                 for (size_t idx=0; idx<files.size(); ++idx) {
                     if (!ui.dropQueue.empty() && idx < ui.dropInclude.size() && !ui.dropInclude[idx]) continue;
                     const std::string& src = files[idx];
@@ -283,9 +312,21 @@ void drawMain(State& ui, bool* p_open)
                         else if (rel.back() == '/') rel += sp.filename().string();
                     }
                     // If item with same rel exists, we update by re-importing and overwriting
-                    core::RepoManager addRepo(repoRoot); // Declare repo manager inside loop scope
+                    core::AddRequest req;
+                    req.sourcePath = src;
+                    req.type = t;
+                    req.relativePath = rel;
+                    req.name = ui.addName;
+                    req.description = ui.addDesc;
+                    req.author = ui.addAuthor;
+                    req.tags = tags;
+                    requests.push_back(req);
+                }
+                if (!requests.empty()) {
+                    // Import all files with a single index write
+                    core::RepoManager addRepo(repoRoot);
                     addRepo.loadIndex();
-                    auto id = addRepo.addFile(src, t, rel, ui.addName, ui.addDesc, ui.addAuthor, tags, ""); (void)id;
+                    addRepo.addFiles(requests);
                 }
                 ui.showAddModal = false;
                 ui.addSrc[0]=ui.addRel[0]=ui.addName[0]=ui.addAuthor[0]=ui.addDesc[0]=ui.addTags[0]=0;
@@ -322,8 +363,31 @@ void drawMain(State& ui, bool* p_open)
             }
             ImGui::Separator();
         }
+        // Follow file changes; rescan manually where watching is unavailable
+        if (ui.watchedRepo != ui.selectedRepo) {
+            ui.watchedRepo = ui.selectedRepo;
+            ui.pendingChanges.clear();
+            ui.repoWatcher.reset();
+            if (watcher::DirectoryWatcher::supported()) {
+                auto w = std::make_shared<watcher::DirectoryWatcher>();
+                if (w->start(repoRoot, [](const std::string& rel) { return core::RepoManager::isInternalPath(rel); })) ui.repoWatcher = w;
+            }
+        }
+        if (ui.repoWatcher) {
+            for (const auto& ev : ui.repoWatcher->poll(0)) {
+                if (ev.kind == watcher::Event::Kind::Overflow) ui.requestRescan = true;
+                else ui.pendingChanges.insert(ev.relativePath);
+                ui.lastChangeTime = ImGui::GetTime();
+            }
+            // Apply once the burst has settled
+            if (!ui.pendingChanges.empty() && !ui.requestRescan && ImGui::GetTime() - ui.lastChangeTime > 0.5) {
+                repo.applyChanges(std::vector<std::string>(ui.pendingChanges.begin(), ui.pendingChanges.end()));
+                ui.pendingChanges.clear();
+            }
+        }
         // Handle rescan request from top menu
         if (ui.requestRescan) {
+            ui.pendingChanges.clear();
             repo.pruneMissingFiles();
             repo.discoverNewFiles();
             repo.loadIndex();
@@ -334,6 +398,64 @@ void drawMain(State& ui, bool* p_open)
         ImGui::SameLine();
         ImGui::SetNextItemWidth(240);
         ImGui::InputTextWithHint("##live_search", "Search name or path...", ui.filterSearch, IM_ARRAYSIZE(ui.filterSearch));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(240);
+        if (ImGui::InputTextWithHint("##asset_search", "Find file inside pk3s...", ui.assetSearch, IM_ARRAYSIZE(ui.assetSearch))) {
+            ui.assetEditTime = ImGui::GetTime();
+        }
+        if (ui.assetQueryRepo != ui.selectedRepo) {
+            ui.assetQueryRepo = ui.selectedRepo;
+            ui.assetQuery.clear();
+            ui.assetRepo.reset();
+        }
+        // Search once typing has paused, one search at a time, off the UI
+        // thread; very short queries match almost everything
+        std::string assetText = ui.assetSearch;
+        bool assetBusy;
+        {
+            std::lock_guard<std::mutex> lock(ui.assetMutex);
+            assetBusy = ui.assetSearchBusy;
+        }
+        if (assetText != ui.assetQuery && !assetBusy && ImGui::GetTime() - ui.assetEditTime > 0.3) {
+            ui.assetQuery = assetText;
+            if (assetText.size() >= 3) {
+                if (!ui.assetRepo) ui.assetRepo = std::make_shared<core::RepoManager>(repoRoot);
+                {
+                    std::lock_guard<std::mutex> lock(ui.assetMutex);
+                    ui.assetSearchBusy = true;
+                }
+#if defined(_WIN32)
+                struct AssetSearchTask { ui::State* ui; std::shared_ptr<core::RepoManager> repo; std::string repoName; std::string query; };
+                auto* task = new AssetSearchTask{ &ui, ui.assetRepo, ui.selectedRepo, assetText };
+                HANDLE h = CreateThread(NULL, 0, [](LPVOID lp)->DWORD {
+                    auto* t = static_cast<AssetSearchTask*>(lp);
+                    searchAssets(*t->ui, t->repo, t->repoName, t->query);
+                    delete t;
+                    return 0;
+                }, task, 0, NULL);
+                if (h) CloseHandle(h);
+                else { delete task; std::lock_guard<std::mutex> lock(ui.assetMutex); ui.assetSearchBusy = false; }
+#else
+                std::thread([&ui, repo = ui.assetRepo, repoName = ui.selectedRepo, query = assetText]() {
+                    searchAssets(ui, repo, repoName, query);
+                }).detach();
+#endif
+            }
+        }
+        if (assetText.size() >= 3) {
+            std::lock_guard<std::mutex> lock(ui.assetMutex);
+            if (ui.assetResultQuery != assetText || ui.assetResultRepo != ui.selectedRepo) {
+                ImGui::TextDisabled("Searching pk3s for '%s'...", assetText.c_str());
+            } else {
+                ImGui::Text("Assets matching '%s': %d", assetText.c_str(), (int)ui.assetResultCount);
+                if (!ui.assetResults.empty()) {
+                    ImGui::BeginChild("asset_results", ImVec2(0, 120), true);
+                    for (const auto& r : ui.assetResults) ImGui::TextUnformatted(r.c_str());
+                    if (ui.assetResultCount > ui.assetResults.size()) ImGui::TextDisabled("(first %d shown)", (int)ui.assetResults.size());
+                    ImGui::EndChild();
+                }
+            }
+        }
         // Batch actions
         ImGui::Separator();
         int selectedCount = (int)ui.selectedItemIdsSet.size();
@@ -354,6 +476,8 @@ void drawMain(State& ui, bool* p_open)
             ui.gitHubRemotePaths.clear();
             ui.gitHubRemoteOnlyCount = 0;
             ui.gitHubRemoteOnlySample.clear();
+            ui.gitHubChangedPaths.clear();
+            ui.gitHubDiffCount = 0;
             // Get token for private repos
             auto decodeToken = [&](const std::string& exeDir) -> std::string {
                 std::string enc = config::Config::getInstance().getGithubTokenEncrypted();
@@ -367,47 +491,48 @@ void drawMain(State& ui, bool* p_open)
             // Determine remote path guess
             std::string remotePath = strlen(ui.gitHubRemote)>0 ? ui.gitHubRemote : (config::Config::getInstance().getGithubUser().empty()?ui.selectedRepo:(config::Config::getInstance().getGithubUser()+"/"+ui.selectedRepo));
             std::string branch = strlen(ui.gitHubBranch)>0 ? ui.gitHubBranch : "main";
-            std::string tmpIdx = ui.exeDir + "/gh_idx_compare.json";
             // Try API first (works for private repos), then fallback to raw
-            std::string apiUrl = std::string("https://api.github.com/repos/") + remotePath + "/contents/index.json?ref=" + branch;
-            std::string cmd;
+            utils::http::Response resp;
             if (!token.empty()) {
                 // Request raw content directly for private repos
-                cmd = std::string("curl -sL -H \"Authorization: token ") + token +
-                      "\" -H \"Accept: application/vnd.github.v3.raw\" \"" + apiUrl + "\" -o \"" + tmpIdx + "\"";
+                resp = utils::http::gitHub().get("repos/" + remotePath + "/contents/index.json?ref=" + branch,
+                                                 utils::http::gitHubHeaders(token, "application/vnd.github.v3.raw"));
             } else {
-                std::string rawUrl = std::string("https://raw.githubusercontent.com/") + remotePath + "/" + branch + "/index.json";
-                cmd = std::string("curl -sL \"") + rawUrl + "\" -o \"" + tmpIdx + "\"";
+                resp = utils::http::gitHub().get(utils::http::gitHubRawUrl() + "/" + remotePath + "/" + branch + "/index.json");
             }
-            // Execute synchronously to avoid MinGW threading issues
-            std::system(cmd.c_str());
             try {
-                std::ifstream fin(tmpIdx);
-                if (fin.good()) {
-                    nlohmann::json j; fin >> j; fin.close();
+                if (resp.ok()) {
+                    nlohmann::json j = nlohmann::json::parse(resp.body);
                     if (j.is_object() && j.contains("items") && j["items"].is_array()) {
-                        for (const auto& it : j["items"]) {
-                            if (it.contains("relative_path") && it["relative_path"].is_string()) {
-                                ui.gitHubRemotePaths.insert(it["relative_path"].get<std::string>());
-                            }
-                        }
-                        // summarize remote-only sample
+                        core::RepoIndex remoteIndex = j.get<core::RepoIndex>();
+                        for (const auto& it : remoteIndex.items) ui.gitHubRemotePaths.insert(it.relativePath);
+                        // Walk only the subtrees whose Merkle hashes differ
+                        auto changes = core::MerkleTree::diff(repo.merkleTree(), core::MerkleTree::build(remoteIndex.items));
+                        ui.gitHubDiffCount = changes.size();
                         ui.gitHubRemoteOnlyCount = 0; ui.gitHubRemoteOnlySample.clear();
-                        for (const auto &rel : ui.gitHubRemotePaths) {
-                            std::string full = ui.exeDir + "/repos/" + ui.selectedRepo + "/" + rel;
-                            if (!std::filesystem::exists(full)) {
+                        for (const auto& c : changes) {
+                            if (c.kind == core::TreeChange::Kind::Modified) {
+                                ui.gitHubChangedPaths.insert(c.relativePath);
+                            } else if (c.kind == core::TreeChange::Kind::Added) {
                                 ui.gitHubRemoteOnlyCount++;
                                 if (ui.gitHubRemoteOnlySample.size() < 3)
-                                    ui.gitHubRemoteOnlySample.push_back(rel);
+                                    ui.gitHubRemoteOnlySample.push_back(c.relativePath);
                             }
                         }
                         ui.gitHubCompareReady = true;
                     }
                 }
             } catch(...) {}
-            std::filesystem::remove(tmpIdx);
             ui.gitHubCompareInProgress = false;
         }
+        if (ui.gitHubCompareReady) {
+            ImGui::SameLine();
+            if (ui.gitHubDiffCount == 0) {
+                ImGui::TextColored(ImVec4(0.6f,1.0f,0.6f,1.0f), "In sync with GitHub");
+            } else {
+                ImGui::Text("%d difference(s), %d remote only", (int)ui.gitHubDiffCount, ui.gitHubRemoteOnlyCount);
+            }
+        }
         // Selection macros (operate on visible rows per current filters)
         {
             const auto& itemsAll = repo.index().items;
@@ -689,7 +814,9 @@ void drawMain(State& ui, bool* p_open)
                 if (ui.gitHubCompareReady) {
                     bool localExists = std::filesystem::exists(fullPath);
                     bool remoteHas = (ui.gitHubRemotePaths.find(it.relativePath) != ui.gitHubRemotePaths.end());
-                    if (localExists && remoteHas) {
+                    if (localExists && remoteHas && ui.gitHubChangedPaths.count(it.relativePath)) {
+                        ImGui::TextColored(ImVec4(1.0f,0.8f,0.4f,1.0f), "Changed");
+                    } else if (localExists && remoteHas) {
                         ImGui::TextColored(ImVec4(0.6f,1.0f,0.6f,1.0f), "OK");
                     } else if (localExists && !remoteHas) {
                         ImGui::TextColored(ImVec4(1.0f,0.8f,0.4f,1.0f), "Local only");
@@ -711,9 +838,7 @@ void drawMain(State& ui, bool* p_open)
             ImGui::Text("Delete %d selected items?", (int)ui.selectedItemIdsSet.size());
             ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.5f, 1.0f), "This cannot be undone.");
             if (ImGui::Button("Yes, delete")) {
-                for (const auto& id : ui.selectedItemIdsSet) {
-                    repo.removeItem(id);
-                }
+                repo.removeItems(std::vector<std::string>(ui.selectedItemIdsSet.begin(), ui.selectedItemIdsSet.end()));
                 repo.loadIndex();
                 ui.selectedItemIdsSet.clear();
                 ImGui::CloseCurrentPopup();
@@ -732,17 +857,18 @@ void drawMain(State& ui, bool* p_open)
                 if (!folder.empty() && folder.back() != '/') folder += '/';
                 core::RepoManager r2(repoRoot);
                 r2.loadIndex();
+                core::IndexTransaction tx(r2);
                 for (const auto& id : ui.selectedItemIdsSet) {
                     // Find current item to keep filename
-                    auto& items2 = r2.index();
-                    auto it2 = std::find_if(items2.items.begin(), items2.items.end(), [&](const core::ContentItem& c){ return c.id == id; });
-                    if (it2 != items2.items.end()) {
+                    const core::ContentItem* it2 = r2.findById(id);
+                    if (it2) {
                         std::string filename;
                         auto pos = it2->relativePath.find_last_of('/');
                         filename = (pos == std::string::npos) ? it2->relativePath : it2->relativePath.substr(pos+1);
                         r2.moveItem(id, folder + filename);
                     }
                 }
+                tx.commit();
                 r2.loadIndex();
                 repo.loadIndex();
                 ui.selectedItemIdsSet.clear();
@@ -781,11 +907,11 @@ void drawMain(State& ui, bool* p_open)
                 std::string addMulti = ui.batchAddMulti;
                 core::RepoManager r2(repoRoot);
                 r2.loadIndex();
+                core::IndexTransaction tx(r2);
                 for (const auto& id : ui.selectedItemIdsSet) {
                     // Read current item
-                    const auto& items2 = r2.index().items;
-                    auto it2 = std::find_if(items2.begin(), items2.end(), [&](const core::ContentItem& c){ return c.id == id; });
-                    if (it2 == items2.end()) continue;
+                    const core::ContentItem* it2 = r2.findById(id);
+                    if (!it2) continue;
                     std::vector<std::string> newTags = it2->tags;
                     std::string newAuthor = it2->author;
                     if (ui.batchAuthorSet) newAuthor = ui.batchAuthor;
@@ -836,6 +962,7 @@ void drawMain(State& ui, bool* p_open)
                     }
                     r2.updateItemMetadata(id, it2->name, it2->description, newAuthor, newTags);
                 }
+                tx.commit();
                 r2.loadIndex();
                 repo.loadIndex();
                 if (!ui.batchKeepSelection) ui.selectedItemIdsSet.clear();
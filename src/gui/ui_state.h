@@ -4,6 +4,12 @@
 #include <string>
 #include <vector>
 #include <unordered_set>
+#include <set>
+#include <memory>
+#include <mutex>
+
+namespace watcher { class DirectoryWatcher; }
+namespace core { class RepoManager; }
 
 namespace ui {
 
@@ -71,6 +77,20 @@ struct State {
 
     // Filtering / search / sorting
     char filterSearch[128] = {0}; // live search by name/path
+    // Search inside pk3s (asset catalog). A worker runs it once typing has
+    // paused; assetRepo keeps the catalog loaded between searches and is only
+    // used by that worker. Hold assetMutex for the fields after it.
+    char assetSearch[128] = {0};
+    std::string assetQuery;       // last text searched for (or too short to search)
+    std::string assetQueryRepo;
+    double assetEditTime = 0.0;
+    std::shared_ptr<core::RepoManager> assetRepo;
+    std::mutex assetMutex;
+    bool assetSearchBusy = false;
+    std::string assetResultQuery; // results below are for this text in assetResultRepo
+    std::string assetResultRepo;
+    std::vector<std::string> assetResults;
+    std::size_t assetResultCount = 0;
     char filterName[128] = {0};
     char filterAuthor[128] = {0};
     char filterTag[128] = {0}; // key or key:value
@@ -82,6 +102,16 @@ struct State {
     bool showFiltersWindow = false;
     // Requests triggered from top menu
     bool requestRescan = false;
+    // Live index updates for the selected repo (Linux only)
+    std::shared_ptr<watcher::DirectoryWatcher> repoWatcher;
+    std::string watchedRepo;
+    std::set<std::string> pendingChanges;
+    double lastChangeTime = 0.0;
+    // Last verify result, computed when the verify popup opens
+    size_t verifyMissing = 0;
+    size_t verifyHashMismatch = 0;
+    size_t verifyDupPaths = 0;
+    size_t verifyDupIds = 0;
 
     // Multi-selection for batch operations
     std::unordered_set<std::string> selectedItemIdsSet;
@@ -118,8 +148,10 @@ struct State {
     std::string operationStatus;
     float operationProgress = 0.0f;
     
-    // GitHub repos list
+    // GitHub repos list; rows are updated by the list worker while it
+    // probes compatibility, so hold gitHubReposMutex when touching them
     std::vector<GitHubRepoInfo> gitHubRepos;
+    std::mutex gitHubReposMutex;
     std::string githubOutput; // for messages and logs
     
     // Context menu
@@ -140,13 +172,15 @@ struct State {
     std::unordered_set<std::string> gitHubRemotePaths;
     int gitHubRemoteOnlyCount = 0;
     std::vector<std::string> gitHubRemoteOnlySample;
+    std::unordered_set<std::string> gitHubChangedPaths; // same path, different content
+    std::size_t gitHubDiffCount = 0; // paths that differ in any way; 0 = root hashes match
     bool gitHubCompareInProgress = false;
 };
 
 void refreshRepos(State& s);
 void resetGitHubOperation(State& s);
 void parseGitHubReposList(const std::string& json, std::vector<GitHubRepoInfo>& repos);
-void checkRepoCompatibility(const std::string& exeDir, const std::string& token, GitHubRepoInfo& repo);
+void checkRepoCompatibility(const std::string& token, GitHubRepoInfo& repo);
 
 }
 
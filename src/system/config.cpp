@@ -110,14 +110,25 @@ Repository* Config::getRepository(const std::string& name) {
 
 Settings Config::getSettings() const {
     Settings settings;
-    
-    // No settings currently used
-    
+    if (data.contains("settings") && data["settings"].is_object()) {
+        const auto& s = data["settings"];
+        try {
+            if (s.contains("chunk_threshold_mb")) settings.chunkThresholdMB = s.at("chunk_threshold_mb").get<uint64_t>();
+            if (s.contains("compact_index")) settings.compactIndex = s.at("compact_index").get<bool>();
+            if (s.contains("object_hardlinks")) settings.objectHardlinks = s.at("object_hardlinks").get<bool>();
+            if (s.contains("github_api_url")) settings.githubApiUrl = s.at("github_api_url").get<std::string>();
+            if (s.contains("github_raw_url")) settings.githubRawUrl = s.at("github_raw_url").get<std::string>();
+        } catch (...) {}
+    }
     return settings;
 }
 
 void Config::setSettings(const Settings& settings) {
-    (void)settings;
+    data["settings"]["chunk_threshold_mb"] = settings.chunkThresholdMB;
+    data["settings"]["compact_index"] = settings.compactIndex;
+    data["settings"]["object_hardlinks"] = settings.objectHardlinks;
+    data["settings"]["github_api_url"] = settings.githubApiUrl;
+    data["settings"]["github_raw_url"] = settings.githubRawUrl;
 }
 
 std::string Config::getCurrentRepo() const {
@@ -133,6 +144,7 @@ void Config::setCurrentRepo(const std::string& name) {
 
 void Config::setDefaultSettings() {
     data["settings"] = nlohmann::json::object();
+    setSettings(Settings());
 }
 
 void Config::setDefaultRepositories() {
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <nlohmann/json.hpp>
 
 namespace config {
@@ -13,8 +14,15 @@ namespace config {
     };
 
     struct Settings {
-        // Reserved for future; currently empty to reduce noise
-        bool reserved = false;
+        // Items of at least this size get content-defined chunk sidecars (0 = off)
+        uint64_t chunkThresholdMB = 64;
+        // Write index.json without indentation
+        bool compactIndex = false;
+        // Let the object store hard link files when reflinks are unavailable
+        bool objectHardlinks = false;
+        // GitHub endpoints; point these at a local server to test against it
+        std::string githubApiUrl = "https://api.github.com";
+        std::string githubRawUrl = "https://raw.githubusercontent.com";
     };
 
     class Config {
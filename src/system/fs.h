@@ -2,6 +2,7 @@
 #define FS_H
 
 #include <string>
+#include <cstdio>
 
 namespace fs {
     /**
@@ -24,6 +25,13 @@ namespace fs {
      * @return true if file was created or already exists, false on error
      */
     bool createFileIfNotExists(const std::string& filePath, const std::string& content = "");
+
+    /**
+     * Flush a stdio stream and push its contents to the disk (fsync)
+     * @param file An open, writable stream
+     * @return true once the data is durable, false on error
+     */
+    bool syncFile(std::FILE* file);
 }
 
 #endif // FS_H
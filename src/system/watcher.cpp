@@ -0,0 +1,190 @@
+#include "watcher.h"
+#include "logger.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace watcher {
+
+#ifdef __linux__
+
+namespace {
+    const uint32_t kDirMask = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                              IN_DELETE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+    std::string joinRelative(const std::string& dir, const std::string& name) {
+        return dir.empty() ? name : dir + "/" + name;
+    }
+}
+
+struct DirectoryWatcher::Impl {
+    int fd = -1;
+    std::string root;
+    Filter ignore;
+    std::unordered_map<int, std::string> dirs; // watch descriptor -> relative dir ("" = root)
+
+    bool addWatch(const std::string& relDir) {
+        std::string full = relDir.empty() ? root : root + "/" + relDir;
+        int wd = inotify_add_watch(fd, full.c_str(), kDirMask);
+        if (wd < 0) {
+            if (errno == ENOSPC) logger::warning("Watch limit reached (fs.inotify.max_user_watches); some directories are not watched");
+            return false;
+        }
+        dirs[wd] = relDir;
+        return true;
+    }
+
+    // Watches relDir and every directory below it
+    void addTree(const std::string& relDir) {
+        if (!addWatch(relDir)) return;
+        std::string full = relDir.empty() ? root : root + "/" + relDir;
+        std::error_code ec;
+        for (std::filesystem::recursive_directory_iterator it(full, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_directory(ec) || it->is_symlink(ec)) continue;
+            std::string rel = joinRelative(relDir, std::filesystem::relative(it->path(), full, ec).generic_string());
+            if (ignore && ignore(rel)) {
+                it.disable_recursion_pending();
+                continue;
+            }
+            addWatch(rel);
+        }
+    }
+
+    // Forgets watches on relDir and below (the directory left the tree)
+    void dropTree(const std::string& relDir) {
+        for (auto it = dirs.begin(); it != dirs.end();) {
+            const std::string& d = it->second;
+            if (d == relDir || d.rfind(relDir + "/", 0) == 0) {
+                inotify_rm_watch(fd, it->first);
+                it = dirs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void handle(const struct inotify_event* ev, std::vector<Event>& out) {
+        if (ev->mask & IN_Q_OVERFLOW) {
+            out.push_back({Event::Kind::Overflow, ""});
+            return;
+        }
+        auto dir = dirs.find(ev->wd);
+        if (dir == dirs.end()) return;
+        if (ev->mask & IN_IGNORED) {
+            dirs.erase(dir);
+            return;
+        }
+        if (ev->len == 0) {
+            // Self events; the parent already reported the entry, except for the root
+            if ((ev->mask & IN_DELETE_SELF) && dir->second.empty()) out.push_back({Event::Kind::Removed, ""});
+            return;
+        }
+
+        std::string rel = joinRelative(dir->second, ev->name);
+        if (ignore && ignore(rel)) return;
+        bool isDir = (ev->mask & IN_ISDIR) != 0;
+        if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+            if (isDir) dropTree(rel);
+            out.push_back({Event::Kind::Removed, rel});
+        } else if (ev->mask & (IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE)) {
+            // Files may appear in a new directory before its watch exists, so
+            // consumers treat a directory event as "everything below changed"
+            if (isDir) addTree(rel);
+            out.push_back({Event::Kind::Changed, rel});
+        }
+    }
+};
+
+DirectoryWatcher::DirectoryWatcher() : impl(new Impl) {}
+
+DirectoryWatcher::~DirectoryWatcher() {
+    stop();
+}
+
+bool DirectoryWatcher::supported() {
+    return true;
+}
+
+bool DirectoryWatcher::start(const std::string& root, Filter ignore) {
+    stop();
+    impl->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (impl->fd < 0) {
+        logger::error("inotify_init1 failed");
+        return false;
+    }
+    impl->root = root;
+    impl->ignore = std::move(ignore);
+    impl->addTree("");
+    if (impl->dirs.empty()) {
+        stop();
+        return false;
+    }
+    logger::debug("Watching " + std::to_string(impl->dirs.size()) + " directories under " + root);
+    return true;
+}
+
+void DirectoryWatcher::stop() {
+    if (impl->fd >= 0) ::close(impl->fd);
+    impl->fd = -1;
+    impl->dirs.clear();
+}
+
+bool DirectoryWatcher::running() const {
+    return impl->fd >= 0;
+}
+
+std::vector<Event> DirectoryWatcher::poll(int timeoutMs) {
+    std::vector<Event> out;
+    if (impl->fd < 0) return out;
+    struct pollfd pfd = {impl->fd, POLLIN, 0};
+    if (::poll(&pfd, 1, timeoutMs) <= 0) return out;
+
+    alignas(struct inotify_event) char buf[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(impl->fd, buf, sizeof(buf));
+        if (n <= 0) break; // EAGAIN: drained
+        for (char* p = buf; p < buf + n;) {
+            auto* ev = reinterpret_cast<struct inotify_event*>(p);
+            impl->handle(ev, out);
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    return out;
+}
+
+#else
+
+struct DirectoryWatcher::Impl {};
+
+DirectoryWatcher::DirectoryWatcher() : impl(new Impl) {}
+DirectoryWatcher::~DirectoryWatcher() = default;
+
+bool DirectoryWatcher::supported() {
+    return false;
+}
+
+bool DirectoryWatcher::start(const std::string&, Filter) {
+    return false;
+}
+
+void DirectoryWatcher::stop() {}
+
+bool DirectoryWatcher::running() const {
+    return false;
+}
+
+std::vector<Event> DirectoryWatcher::poll(int) {
+    return {};
+}
+
+#endif
+
+}
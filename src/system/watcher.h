@@ -0,0 +1,48 @@
+#ifndef WATCHER_H
+#define WATCHER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+namespace watcher {
+    struct Event {
+        enum class Kind {
+            Changed,  // file or directory created, written, or moved in
+            Removed,  // file or directory deleted or moved out
+            Overflow  // events were lost; a full rescan is needed
+        };
+        Kind kind;
+        std::string relativePath; // '/' separated, relative to the watched root
+    };
+
+    // Recursive change notifications for a directory tree.
+    // Linux: inotify, one watch per directory. Other platforms: start() fails
+    // and callers keep rescanning on demand.
+    class DirectoryWatcher {
+    public:
+        // Returns true for relative paths whose events (and subtrees) are ignored
+        using Filter = std::function<bool(const std::string& relativePath)>;
+
+        DirectoryWatcher();
+        ~DirectoryWatcher();
+        DirectoryWatcher(const DirectoryWatcher&) = delete;
+        DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+        static bool supported();
+
+        bool start(const std::string& root, Filter ignore = nullptr);
+        void stop();
+        bool running() const;
+
+        // Waits up to timeoutMs (0 = don't wait) and returns the pending events
+        std::vector<Event> poll(int timeoutMs);
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl;
+    };
+}
+
+#endif // WATCHER_H
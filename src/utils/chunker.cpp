@@ -0,0 +1,136 @@
+#include "chunker.h"
+#include "file_stream.h"
+
+#include <algorithm>
+#include <array>
+
+namespace utils {
+
+namespace {
+
+// Gear table: 256 fixed pseudo-random words (splitmix64). Must never change,
+// or chunk lists recorded earlier stop lining up with new ones.
+std::array<uint64_t, 256> makeGear() {
+    std::array<uint64_t, 256> table{};
+    uint64_t x = 0x52455030434443ULL; // "REP0CDC"
+    for (auto& v : table) {
+        x += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = x;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        v = z ^ (z >> 31);
+    }
+    return table;
+}
+
+const std::array<uint64_t, 256> kGear = makeGear();
+
+unsigned log2Floor(uint32_t v) {
+    unsigned bits = 0;
+    while (v >>= 1) ++bits;
+    return bits;
+}
+
+// Mask selecting the top `bits` bits of the gear hash
+uint64_t topBits(unsigned bits) {
+    if (bits == 0) return 0;
+    if (bits >= 64) return ~0ULL;
+    return ~0ULL << (64 - bits);
+}
+
+} // namespace
+
+Chunker::Chunker(const ChunkParams& p) : params(p) {
+    if (params.minSize == 0) params.minSize = 1;
+    if (params.avgSize < params.minSize) params.avgSize = params.minSize;
+    if (params.maxSize < params.avgSize) params.maxSize = params.avgSize;
+    // Normalization level 2: cuts are 4x less likely before the average size
+    // and 4x more likely after it, which narrows the size distribution
+    unsigned bits = log2Floor(params.avgSize);
+    maskSmall = topBits(bits + 2);
+    maskLarge = topBits(bits > 2 ? bits - 2 : 0);
+}
+
+void Chunker::cut(std::vector<Chunk>& out) {
+    out.push_back({offset, length, sha256::toHex(hasher.finish())});
+    offset += length;
+    length = 0;
+    hash = 0;
+    hasher = sha256::Hasher();
+}
+
+void Chunker::update(const unsigned char* data, std::size_t size, std::vector<Chunk>& out) {
+    std::size_t start = 0; // first byte of data not yet hashed into the chunk
+    std::size_t i = 0;
+    while (i < size) {
+        // Bytes below minSize can never end a chunk; only the last 64 before
+        // it can still influence the gear hash
+        uint32_t skipTo = params.minSize > 64 ? params.minSize - 64 : 0;
+        if (length < skipTo) {
+            std::size_t skip = std::min<std::size_t>(skipTo - length, size - i);
+            i += skip;
+            length += static_cast<uint32_t>(skip);
+            continue;
+        }
+        hash = (hash << 1) + kGear[data[i]];
+        ++i;
+        ++length;
+        if (length < params.minSize) continue;
+        uint64_t mask = length < params.avgSize ? maskSmall : maskLarge;
+        if ((hash & mask) == 0 || length >= params.maxSize) {
+            hasher.update(data + start, i - start);
+            start = i;
+            cut(out);
+        }
+    }
+    hasher.update(data + start, size - start);
+}
+
+void Chunker::finish(std::vector<Chunk>& out) {
+    if (length > 0) cut(out);
+}
+
+bool chunkFile(const std::string& path, const ChunkParams& params,
+               std::vector<Chunk>& out, std::string* fileSha256) {
+    Chunker chunker(params);
+    sha256::Hasher whole;
+    std::vector<Chunk> chunks;
+    bool ok = streamFile(path, [&](const unsigned char* data, std::size_t size) {
+        if (fileSha256) whole.update(data, size);
+        chunker.update(data, size, chunks);
+    });
+    if (!ok) return false;
+    chunker.finish(chunks);
+    if (fileSha256) *fileSha256 = sha256::toHex(whole.finish());
+    out = std::move(chunks);
+    return true;
+}
+
+bool hashFileRanges(const std::string& path, const std::vector<Chunk>& ranges,
+                    std::vector<std::string>& digests) {
+    digests.assign(ranges.size(), std::string());
+    std::size_t current = 0;
+    uint64_t pos = 0; // stream offset of the next byte
+    sha256::Hasher hasher;
+    bool ok = streamFile(path, [&](const unsigned char* data, std::size_t size) {
+        const uint64_t base = pos;
+        const uint64_t end = base + size;
+        while (current < ranges.size()) {
+            const Chunk& r = ranges[current];
+            const uint64_t rangeEnd = r.offset + r.length;
+            if (rangeEnd <= pos) { ++current; continue; } // empty or overlapping range
+            if (r.offset >= end) break;
+            uint64_t from = r.offset > pos ? r.offset : pos;
+            uint64_t to = rangeEnd < end ? rangeEnd : end;
+            hasher.update(data + (from - base), static_cast<std::size_t>(to - from));
+            pos = to;
+            if (to < rangeEnd) break; // continues in the next piece
+            digests[current++] = sha256::toHex(hasher.finish());
+            hasher = sha256::Hasher();
+        }
+        pos = end;
+    });
+    return ok;
+}
+
+} // namespace utils
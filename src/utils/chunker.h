@@ -0,0 +1,68 @@
+#ifndef UTILS_CHUNKER_H
+#define UTILS_CHUNKER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "sha256.h"
+
+namespace utils {
+
+// Chunk size bounds in bytes. Boundaries depend on these values, so chunk
+// lists made with different parameters cannot be compared.
+struct ChunkParams {
+    uint32_t minSize = 256 * 1024;
+    uint32_t avgSize = 1024 * 1024;
+    uint32_t maxSize = 4 * 1024 * 1024;
+
+    bool operator==(const ChunkParams& o) const {
+        return minSize == o.minSize && avgSize == o.avgSize && maxSize == o.maxSize;
+    }
+};
+
+struct Chunk {
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    std::string sha256;
+};
+
+// Content-defined chunking (FastCDC: gear rolling hash with normalized
+// chunking). A cut depends only on the bytes just before it, so an edit in
+// the middle of a file moves the boundaries next to the edit and leaves the
+// chunks elsewhere, and their digests, unchanged.
+class Chunker {
+public:
+    explicit Chunker(const ChunkParams& params = ChunkParams());
+
+    // Feeds the next bytes of the stream; completed chunks are appended to out
+    void update(const unsigned char* data, std::size_t size, std::vector<Chunk>& out);
+    // Ends the stream and appends the last (shorter) chunk, if any
+    void finish(std::vector<Chunk>& out);
+
+private:
+    ChunkParams params;
+    uint64_t maskSmall; // stricter mask before avgSize
+    uint64_t maskLarge; // looser mask after it
+    uint64_t hash = 0;
+    uint64_t offset = 0;     // stream offset of the current chunk
+    uint32_t length = 0;     // bytes in the current chunk
+    sha256::Hasher hasher;
+
+    void cut(std::vector<Chunk>& out);
+};
+
+// Chunks a whole file in one read; fileSha256 (optional) receives the digest
+// of the whole file from the same pass. False if the file cannot be read.
+bool chunkFile(const std::string& path, const ChunkParams& params,
+               std::vector<Chunk>& out, std::string* fileSha256 = nullptr);
+
+// Hashes the file at the given byte ranges (sorted, non-overlapping), e.g.
+// the boundaries recorded by an earlier chunkFile. digests[i] is empty for
+// ranges past the end of the file. False if the file cannot be read.
+bool hashFileRanges(const std::string& path, const std::vector<Chunk>& ranges,
+                    std::vector<std::string>& digests);
+
+} // namespace utils
+
+#endif // UTILS_CHUNKER_H
@@ -0,0 +1,152 @@
+#include "file_stream.h"
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#endif
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+constexpr std::size_t kBlockBytes = 1 << 20;        // read() size
+constexpr std::size_t kBlockAlign = 4096;           // page aligned buffers
+
+using Sink = std::function<void(const unsigned char*, std::size_t)>;
+
+struct AlignedFree {
+    void operator()(unsigned char* p) const {
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+};
+using AlignedBuffer = std::unique_ptr<unsigned char, AlignedFree>;
+
+AlignedBuffer allocateBlock() {
+#ifdef _WIN32
+    return AlignedBuffer(static_cast<unsigned char*>(_aligned_malloc(kBlockBytes, kBlockAlign)));
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, kBlockAlign, kBlockBytes) != 0) return AlignedBuffer();
+    return AlignedBuffer(static_cast<unsigned char*>(p));
+#endif
+}
+
+bool streamBuffered(const std::string& path, const Sink& sink) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::vector<char> chunk(kBlockBytes);
+    while (file) {
+        file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        if (file.gcount() > 0) {
+            sink(reinterpret_cast<const unsigned char*>(chunk.data()), static_cast<std::size_t>(file.gcount()));
+        }
+    }
+    return !file.bad();
+}
+
+#ifdef _WIN32
+
+bool streamDirect(HANDLE fh, unsigned char* block, const Sink& sink) {
+    for (;;) {
+        DWORD got = 0;
+        if (!ReadFile(fh, block, static_cast<DWORD>(kBlockBytes), &got, NULL)) return false;
+        if (got == 0) return true;
+        sink(block, got);
+    }
+}
+
+#else
+
+bool streamDirect(int fd, unsigned char* block, const Sink& sink) {
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    for (;;) {
+        ssize_t got = ::read(fd, block, kBlockBytes);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (got == 0) return true;
+        sink(block, static_cast<std::size_t>(got));
+    }
+}
+
+#endif
+
+} // namespace
+
+bool streamFile(const std::string& path, const Sink& sink, ReadStrategy* used) {
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fh != INVALID_HANDLE_VALUE) {
+        AlignedBuffer block = allocateBlock();
+        if (block) {
+            if (used) *used = ReadStrategy::Direct;
+            bool ok = streamDirect(fh, block.get(), sink);
+            CloseHandle(fh);
+            return ok;
+        }
+        CloseHandle(fh);
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        AlignedBuffer block = allocateBlock();
+        if (block) {
+            if (used) *used = ReadStrategy::Direct;
+            bool ok = streamDirect(fd, block.get(), sink);
+            ::close(fd);
+            return ok;
+        }
+        ::close(fd);
+    }
+#endif
+    if (used) *used = ReadStrategy::Buffered;
+    return streamBuffered(path, sink);
+}
+
+bool reflinkFile(const std::string& sourcePath, const std::string& destPath) {
+#if defined(__linux__) && defined(FICLONE)
+    int in = ::open(sourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+    struct stat st{};
+    if (::fstat(in, &st) != 0) {
+        ::close(in);
+        return false;
+    }
+    int out = ::open(destPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+    bool ok = ::ioctl(out, FICLONE, in) == 0;
+    ::close(in);
+    ::close(out);
+    if (!ok) ::unlink(destPath.c_str());
+    return ok;
+#else
+    (void)sourcePath;
+    (void)destPath;
+    return false;
+#endif
+}
+
+} // namespace utils
@@ -0,0 +1,32 @@
+#ifndef UTILS_FILE_STREAM_H
+#define UTILS_FILE_STREAM_H
+
+#include <string>
+#include <cstddef>
+#include <functional>
+
+namespace utils {
+
+// How streamFile() got at the data
+enum class ReadStrategy {
+    Direct,   // large aligned read(2)/ReadFile blocks with sequential hints
+    Buffered  // std::ifstream, when the above are unavailable
+};
+
+// Passes the whole file to sink as consecutive pieces, in order. The file is
+// read in big aligned blocks with sequential read-ahead hints, std::ifstream
+// being the last resort. Plain reads rather than mmap so a file truncated
+// while being read just ends early instead of raising SIGBUS. Returns false
+// if the file cannot be read (sink may already have seen part of it).
+bool streamFile(const std::string& path,
+                const std::function<void(const unsigned char* data, std::size_t size)>& sink,
+                ReadStrategy* used = nullptr);
+
+// Creates destPath as a copy-on-write clone of sourcePath (FICLONE). Only
+// works within one filesystem that supports it (btrfs, XFS, ...); returns
+// false otherwise, leaving destPath absent.
+bool reflinkFile(const std::string& sourcePath, const std::string& destPath);
+
+} // namespace utils
+
+#endif // UTILS_FILE_STREAM_H
@@ -1,28 +1,252 @@
 #include "hash.h"
+#include "parallel.h"
+#include "sha256.h"
+#include "file_stream.h"
 #include <fstream>
 #include <vector>
 #include <filesystem>
-#include <picosha2.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <cerrno>
+#endif
 
 namespace utils {
 
+namespace {
+
+// Files up to this size are read whole and hashed together in lane batches;
+// for them open/read overhead, not hashing, is most of the cost
+constexpr std::uintmax_t kSmallFileBytes = 64 * 1024;
+constexpr std::size_t kBatchFiles = 256;
+constexpr std::size_t kBatchBytes = 4 * 1024 * 1024;
+
+// Reads exactly `size` bytes; false if the file is unreadable or no longer that size
+bool readWholeFile(const std::string& path, unsigned char* out, std::size_t size) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    if (size && !file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(size))) return false;
+    return file.peek() == std::char_traits<char>::eof();
+}
+
+void hashSmallBatch(const std::vector<std::string>& filePaths, const std::vector<std::size_t>& batch,
+                    const std::vector<std::uintmax_t>& sizes, std::vector<std::string>& digests) {
+    std::size_t total = 0;
+    for (std::size_t i : batch) total += static_cast<std::size_t>(sizes[i]);
+    std::vector<unsigned char> buffer(total);
+
+    std::vector<std::size_t> ready;
+    std::vector<const uint8_t*> data;
+    std::vector<std::size_t> lengths;
+    std::size_t offset = 0;
+    for (std::size_t i : batch) {
+        std::size_t size = static_cast<std::size_t>(sizes[i]);
+        if (readWholeFile(filePaths[i], buffer.data() + offset, size)) {
+            ready.push_back(i);
+            data.push_back(buffer.data() + offset);
+            lengths.push_back(size);
+        } else {
+            // Changed since it was sized (or unreadable); take the normal path
+            digests[i] = computeFileSha256(filePaths[i]);
+        }
+        offset += size;
+    }
+
+    std::vector<sha256::Digest> out(ready.size());
+    sha256::digestMany(data.data(), lengths.data(), ready.size(), out.data());
+    for (std::size_t k = 0; k < ready.size(); ++k) digests[ready[k]] = sha256::toHex(out[k]);
+}
+
+#ifdef __linux__
+
+constexpr std::size_t kCopyChunkBytes = 1 << 20;
+
+bool writeAll(int fd, const unsigned char* data, std::size_t size) {
+    while (size) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// Copies in the kernel, hashing each chunk from the page cache right after
+// it was copied. Returns false with `unsupported` set if the kernel or
+// filesystem cannot do it before anything was written.
+bool copyRangeHashed(int in, int out, const std::function<void(const unsigned char*, std::size_t)>& feed,
+                     uint64_t& total, bool& unsupported) {
+    std::vector<unsigned char> chunk(kCopyChunkBytes);
+    for (;;) {
+        loff_t offIn = static_cast<loff_t>(total);
+        ssize_t copied = ::copy_file_range(in, &offIn, out, nullptr, kCopyChunkBytes, 0);
+        if (copied < 0) {
+            if (errno == EINTR) continue;
+            unsupported = total == 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP);
+            return false;
+        }
+        if (copied == 0) return true;
+        std::size_t done = 0;
+        while (done < static_cast<std::size_t>(copied)) {
+            ssize_t n = ::pread(in, chunk.data(), static_cast<std::size_t>(copied) - done, static_cast<off_t>(total + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            feed(chunk.data(), static_cast<std::size_t>(n));
+            done += static_cast<std::size_t>(n);
+        }
+        total += static_cast<uint64_t>(copied);
+    }
+}
+
+#endif
+
+} // namespace
+
 std::string computeFileSha256(const std::string& filePath) {
     try {
         if (!std::filesystem::exists(filePath)) {
             return "";
         }
-        std::ifstream file(filePath, std::ios::binary);
-        if (!file.is_open()) {
+        sha256::Hasher hasher;
+        bool ok = streamFile(filePath, [&hasher](const unsigned char* data, std::size_t size) {
+            hasher.update(data, size);
+        });
+        if (!ok) {
             return "";
         }
-        std::vector<unsigned char> s(picosha2::k_digest_size);
-        picosha2::hash256(file, s.begin(), s.end());
-        return picosha2::bytes_to_hex_string(s.begin(), s.end());
+        return sha256::toHex(hasher.finish());
     } catch (...) {
         return "";
     }
 }
 
+std::vector<std::string> computeFilesSha256(const std::vector<std::string>& filePaths, unsigned jobs) {
+    std::vector<std::string> digests(filePaths.size());
+
+    // Large (or unsized) files are one task each; small files are grouped
+    std::vector<std::uintmax_t> sizes(filePaths.size(), 0);
+    std::vector<std::size_t> large;
+    std::vector<std::vector<std::size_t>> batches;
+    std::vector<std::size_t> batch;
+    std::size_t batchBytes = 0;
+    for (std::size_t i = 0; i < filePaths.size(); ++i) {
+        std::error_code ec;
+        std::uintmax_t size = std::filesystem::file_size(filePaths[i], ec);
+        if (ec || size > kSmallFileBytes) {
+            large.push_back(i);
+            continue;
+        }
+        sizes[i] = size;
+        batch.push_back(i);
+        batchBytes += static_cast<std::size_t>(size);
+        if (batch.size() >= kBatchFiles || batchBytes >= kBatchBytes) {
+            batches.push_back(std::move(batch));
+            batch.clear();
+            batchBytes = 0;
+        }
+    }
+    if (!batch.empty()) batches.push_back(std::move(batch));
+
+    // Large files first so the longest tasks start early
+    parallelFor(large.size() + batches.size(), jobs, [&](std::size_t t) {
+        if (t < large.size()) {
+            digests[large[t]] = computeFileSha256(filePaths[large[t]]);
+            return;
+        }
+        const auto& b = batches[t - large.size()];
+        try {
+            hashSmallBatch(filePaths, b, sizes, digests);
+        } catch (...) {
+            for (std::size_t i : b) digests[i] = computeFileSha256(filePaths[i]);
+        }
+    });
+    return digests;
+}
+
+std::string copyFileSha256(const std::string& sourcePath, const std::string& destPath, uint64_t* size,
+                           const std::function<void(const unsigned char*, std::size_t)>& observe) {
+    sha256::Hasher hasher;
+    uint64_t total = 0;
+    bool ok = false;
+    auto hash = [&](const unsigned char* data, std::size_t n) {
+        hasher.update(data, n);
+        if (observe) observe(data, n);
+    };
+#ifdef __linux__
+    int in = ::open(sourcePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return "";
+    struct stat srcStat{};
+    if (::fstat(in, &srcStat) != 0 || !S_ISREG(srcStat.st_mode)) {
+        ::close(in);
+        return "";
+    }
+    int out = ::open(destPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, srcStat.st_mode & 0777);
+    if (out < 0) {
+        ::close(in);
+        return "";
+    }
+    struct stat dstStat{};
+    bool sameFs = ::fstat(out, &dstStat) == 0 && dstStat.st_dev == srcStat.st_dev;
+    bool copied = false;
+#ifdef FICLONE
+    // Shares extents with the source: no data is written, only hashed
+    if (sameFs && ::ioctl(out, FICLONE, in) == 0) {
+        copied = true;
+        ok = streamFile(sourcePath, [&](const unsigned char* data, std::size_t n) {
+            hash(data, n);
+            total += n;
+        });
+    }
+#endif
+    if (!copied && sameFs) {
+        bool unsupported = false;
+        ok = copyRangeHashed(in, out, hash, total, unsupported);
+        copied = ok || !unsupported;
+    }
+    if (!copied) {
+        bool written = true;
+        ok = streamFile(sourcePath, [&](const unsigned char* data, std::size_t n) {
+            if (!written) return;
+            written = writeAll(out, data, n);
+            hash(data, n);
+            total += n;
+        });
+        ok = ok && written;
+    }
+    ::close(in);
+    if (::close(out) != 0) ok = false;
+#else
+    try {
+        std::ofstream out(std::filesystem::u8path(destPath), std::ios::binary | std::ios::trunc);
+        if (out.is_open()) {
+            ok = streamFile(sourcePath, [&](const unsigned char* data, std::size_t n) {
+                out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(n));
+                hash(data, n);
+                total += n;
+            });
+            out.close();
+            ok = ok && !out.fail();
+        }
+    } catch (...) {
+        ok = false;
+    }
+#endif
+    if (!ok) {
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::u8path(destPath), ec);
+        return "";
+    }
+    if (size) *size = total;
+    return sha256::toHex(hasher.finish());
+}
+
 } // namespace utils
 
 
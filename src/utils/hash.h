@@ -2,10 +2,28 @@
 #define UTILS_HASH_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
 
 namespace utils {
     // Returns lowercase hex-encoded SHA-256 of a file. Empty string on error.
     std::string computeFileSha256(const std::string& filePath);
+
+    // Hashes many files on up to `jobs` worker threads (0 = one per core).
+    // Result i is the digest of filePaths[i] (empty on error), so the output
+    // order never depends on scheduling.
+    std::vector<std::string> computeFilesSha256(const std::vector<std::string>& filePaths, unsigned jobs = 0);
+
+    // Copies sourcePath to destPath (replacing it) and returns the SHA-256 of
+    // the copied data, reading the source only once. On Linux a reflink
+    // (FICLONE) or copy_file_range is tried first; otherwise the data is
+    // hashed while it is written. Empty string on error, with destPath removed.
+    // observe (optional) is handed the data in order as it is hashed, e.g. to
+    // chunk the file in the same pass.
+    std::string copyFileSha256(const std::string& sourcePath, const std::string& destPath, uint64_t* size = nullptr,
+                               const std::function<void(const unsigned char* data, std::size_t size)>& observe = nullptr);
 }
 
 #endif // UTILS_HASH_H
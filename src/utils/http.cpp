@@ -0,0 +1,1042 @@
+#include "http.h"
+#include "../system/logger.h"
+#include "../system/version.h"
+#include "sha256.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#define REPOMAN_HTTP_NATIVE 1
+#endif
+
+#if defined(REPOMAN_HTTP_NATIVE) && defined(REPOMAN_HAVE_OPENSSL)
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#define REPOMAN_HTTP_TLS 1
+#endif
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+// Requests go over our own sockets on POSIX (TLS through OpenSSL when built
+// with REPOMAN_HAVE_OPENSSL). Everything else runs the curl tool per request.
+
+namespace utils {
+namespace http {
+
+namespace {
+
+constexpr int kMaxRedirects = 10;
+constexpr std::size_t kReadBlock = 1 << 16;
+constexpr std::size_t kMaxHeaderLine = 1 << 16;
+constexpr std::size_t kPipelineBatch = 16;
+constexpr unsigned kDefaultPageFetches = 8;
+
+std::string lower(std::string s) {
+    for (auto& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+bool iequals(const std::string& a, const std::string& b) {
+    return a.size() == b.size() && lower(a) == lower(b);
+}
+
+std::string trim(const std::string& s) {
+    std::size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return std::string();
+    std::size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+struct Url {
+    std::string scheme;
+    std::string host;
+    int port = 0;
+    std::string target;  // path and query
+
+    std::string origin() const { return scheme + "://" + host + ":" + std::to_string(port); }
+    std::string hostHeader() const {
+        std::string h = host.find(':') != std::string::npos ? "[" + host + "]" : host;
+        bool defaultPort = (scheme == "http" && port == 80) || (scheme == "https" && port == 443);
+        return defaultPort ? h : h + ":" + std::to_string(port);
+    }
+};
+
+bool parseUrl(const std::string& text, Url& out) {
+    auto sep = text.find("://");
+    if (sep == std::string::npos) return false;
+    out.scheme = lower(text.substr(0, sep));
+    if (out.scheme == "http") out.port = 80;
+    else if (out.scheme == "https") out.port = 443;
+    else return false;
+
+    std::size_t hostStart = sep + 3;
+    std::size_t pathStart = text.find_first_of("/?#", hostStart);
+    std::string authority = text.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+    auto at = authority.rfind('@');
+    if (at != std::string::npos) authority = authority.substr(at + 1);
+    std::string portText;
+    if (!authority.empty() && authority[0] == '[') {
+        auto close = authority.find(']');
+        if (close == std::string::npos) return false;
+        out.host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size() && authority[close + 1] == ':') portText = authority.substr(close + 2);
+    } else {
+        auto colon = authority.rfind(':');
+        out.host = authority.substr(0, colon);
+        if (colon != std::string::npos) portText = authority.substr(colon + 1);
+    }
+    if (!portText.empty()) out.port = std::atoi(portText.c_str());
+    if (out.host.empty() || out.port <= 0 || out.port > 65535) return false;
+
+    out.target = pathStart == std::string::npos ? "/" : text.substr(pathStart);
+    auto hash = out.target.find('#');
+    if (hash != std::string::npos) out.target.erase(hash);
+    if (out.target.empty() || out.target[0] != '/') out.target = "/" + out.target;
+    return true;
+}
+
+// Location header relative to the URL that answered
+std::string resolveLocation(const Url& from, const std::string& location) {
+    if (location.find("://") != std::string::npos) return location;
+    std::string prefix = from.scheme + "://" + from.hostHeader();
+    if (location.rfind("//", 0) == 0) return from.scheme + ":" + location;
+    if (!location.empty() && location[0] == '/') return prefix + location;
+    std::string dir = from.target.substr(0, from.target.find('?'));
+    dir = dir.substr(0, dir.rfind('/') + 1);
+    return prefix + dir + location;
+}
+
+bool isRedirect(int status) {
+    return status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+}
+
+// Request for the next hop of a redirect, or false if it should not be followed
+bool redirectRequest(const Request& current, const Response& response, Request& next) {
+    if (!current.followRedirects || !isRedirect(response.status)) return false;
+    const std::string* location = response.header("Location");
+    Url from, to;
+    if (!location || !parseUrl(current.url, from)) return false;
+    next = current;
+    next.url = resolveLocation(from, *location);
+    if (!parseUrl(next.url, to)) return false;
+    if (response.status == 303 || ((response.status == 301 || response.status == 302) && current.method == "POST")) {
+        next.method = "GET";
+        next.body.clear();
+    }
+    // Credentials stay with the host they were meant for
+    if (!iequals(to.host, from.host)) {
+        next.headers.erase(std::remove_if(next.headers.begin(), next.headers.end(),
+                                          [](const auto& h) { return iequals(h.first, "Authorization"); }),
+                           next.headers.end());
+    }
+    return true;
+}
+
+// Target of the Link header entry with this rel, e.g.
+// Link: <https://api.github.com/user/repos?page=2>; rel="next", <...>; rel="last"
+std::string linkTarget(const Response& response, const std::string& rel) {
+    const std::string* link = response.header("Link");
+    if (!link) return std::string();
+    std::size_t pos = 0;
+    while ((pos = link->find('<', pos)) != std::string::npos) {
+        auto close = link->find('>', pos);
+        if (close == std::string::npos) break;
+        auto next = link->find('<', close);
+        std::string params = link->substr(close + 1, next == std::string::npos ? std::string::npos : next - close - 1);
+        if (params.find("rel=\"" + rel + "\"") != std::string::npos) return link->substr(pos + 1, close - pos - 1);
+        pos = close;
+    }
+    return std::string();
+}
+
+// Position of the value of the "page" query parameter, npos if absent
+std::size_t pageParam(const std::string& url) {
+    for (const char* key : {"?page=", "&page="}) {
+        auto at = url.find(key);
+        if (at != std::string::npos) return at + 6;
+    }
+    return std::string::npos;
+}
+
+std::string withPage(const std::string& url, std::size_t at, int page) {
+    auto end = url.find('&', at);
+    return url.substr(0, at) + std::to_string(page) + (end == std::string::npos ? std::string() : url.substr(end));
+}
+
+std::string failure(const Response& response) {
+    return response.error.empty() ? "HTTP " + std::to_string(response.status) : response.error;
+}
+
+bool hasBody(const std::string& method, int status) {
+    return method != "HEAD" && status != 204 && status != 304 && !(status >= 100 && status < 200);
+}
+
+std::string serialize(const Request& request, const Url& url) {
+    std::string out = request.method + " " + url.target + " HTTP/1.1\r\nHost: " + url.hostHeader() + "\r\n";
+    for (const auto& [name, value] : request.headers) out += name + ": " + value + "\r\n";
+    if (!request.body.empty() || request.method == "POST" || request.method == "PUT" || request.method == "PATCH") {
+        out += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+    }
+    out += "\r\n";
+    out += request.body;
+    return out;
+}
+
+// Parses "HTTP/x.y 200 OK"; returns the status or 0
+int parseStatusLine(const std::string& line, bool* http11 = nullptr) {
+    if (line.rfind("HTTP/", 0) != 0) return 0;
+    auto space = line.find(' ');
+    if (space == std::string::npos) return 0;
+    if (http11) *http11 = line.compare(0, space, "HTTP/1.0") != 0;
+    return std::atoi(line.c_str() + space + 1);
+}
+
+void addHeaderLine(Response& response, const std::string& line) {
+    auto colon = line.find(':');
+    if (colon == std::string::npos) return;
+    response.headers.emplace_back(trim(line.substr(0, colon)), trim(line.substr(colon + 1)));
+}
+
+// Delivers body bytes to the sink or the in-memory body
+bool deliver(Response& response, const BodySink& sink, const char* data, std::size_t size) {
+    if (size == 0) return true;
+    if (!sink) {
+        response.body.append(data, size);
+        return true;
+    }
+    if (sink(data, size)) return true;
+    response.error = "transfer aborted";
+    return false;
+}
+
+#ifdef REPOMAN_HTTP_TLS
+SSL_CTX* tlsContext() {
+    static SSL_CTX* ctx = [] {
+        // SSL_write can raise SIGPIPE on a connection the server dropped
+        signal(SIGPIPE, SIG_IGN);
+        SSL_CTX* c = SSL_CTX_new(TLS_client_method());
+        if (c) {
+            SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+            SSL_CTX_set_default_verify_paths(c);
+            SSL_CTX_set_verify(c, SSL_VERIFY_PEER, nullptr);
+        }
+        return c;
+    }();
+    return ctx;
+}
+#endif
+
+// Cache file for a GET: the key covers everything that selects the
+// representation, with the credentials only entering through the digest
+std::string cachePath(const std::string& dir, const std::string& url, const Headers& headers) {
+    std::string key = url;
+    for (const char* name : {"Accept", "Authorization"}) {
+        key += '\n';
+        for (const auto& h : headers) {
+            if (iequals(h.first, name)) key += h.second;
+        }
+    }
+    sha256::Hasher hasher;
+    hasher.update(key.data(), key.size());
+    return dir + "/" + sha256::toHex(hasher.finish());
+}
+
+// Stored as the status line, header lines, an empty line and the body
+bool loadCached(const std::string& path, Response& response) {
+    std::ifstream in(std::filesystem::u8path(path), std::ios::binary);
+    if (!in.is_open()) return false;
+    std::string line;
+    if (!std::getline(in, line)) return false;
+    response.status = std::atoi(line.c_str());
+    while (std::getline(in, line) && !line.empty()) addHeaderLine(response, line);
+    response.body.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return response.status == 200 && !in.bad();
+}
+
+void storeCached(const std::string& path, const Response& response) {
+    std::error_code ec;
+    std::filesystem::path target = std::filesystem::u8path(path);
+    std::filesystem::create_directories(target.parent_path(), ec);
+    // Concurrent requests for one URL each write their own temp file
+    std::random_device rd;
+    std::filesystem::path temp = target;
+    temp += ".tmp" + std::to_string(rd());
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out << response.status << '\n';
+        for (const auto& [name, value] : response.headers) out << name << ": " << value << '\n';
+        out << '\n';
+        out.write(response.body.data(), static_cast<std::streamsize>(response.body.size()));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(temp, target, ec);
+    if (ec) std::filesystem::remove(temp, ec);
+}
+
+std::string shellQuote(const std::string& s) {
+#ifdef _WIN32
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"') out += "\\\"";
+        else out.push_back(c);
+    }
+    return out + "\"";
+#else
+    std::string out = "'";
+    for (char c : s) {
+        if (c == '\'') out += "'\\''";
+        else out.push_back(c);
+    }
+    return out + "'";
+#endif
+}
+
+// Runs curl for the whole request, redirects included. Headers of every hop
+// come first on stdout (-i); the last block that is not a followed redirect
+// or an interim 1xx belongs to the body that follows.
+Response curlSend(const Request& request, const BodySink& sink, int timeoutSeconds) {
+    Response response;
+    std::string bodyFile;
+    std::string cmd = "curl -s -i";
+    if (request.followRedirects) cmd += " -L";
+    // Abort transfers that stall instead of capping their total time
+    cmd += " --connect-timeout " + std::to_string(timeoutSeconds) + " -y " + std::to_string(timeoutSeconds) + " -Y 1";
+    if (request.method == "HEAD") cmd += " -I";
+    else if (request.method != "GET") cmd += " -X " + request.method;
+    for (const auto& [name, value] : request.headers) cmd += " -H " + shellQuote(name + ": " + value);
+    if (!request.body.empty()) {
+        std::random_device rd;
+        bodyFile = (std::filesystem::temp_directory_path() / ("repoman_http_" + std::to_string(rd()) + ".body")).string();
+        std::ofstream out(bodyFile, std::ios::binary | std::ios::trunc);
+        out.write(request.body.data(), static_cast<std::streamsize>(request.body.size()));
+        if (!out) {
+            response.error = "cannot write request body";
+            return response;
+        }
+        cmd += " --data-binary @" + shellQuote(bodyFile);
+    }
+    cmd += " " + shellQuote(request.url);
+
+#ifdef _WIN32
+    FILE* pipe = popen(cmd.c_str(), "rb");
+#else
+    FILE* pipe = popen(cmd.c_str(), "r");
+#endif
+    if (!pipe) {
+        response.error = "cannot start curl";
+        return response;
+    }
+    std::string pending;
+    bool inBody = false;
+    bool aborted = false;
+    std::vector<char> buffer(kReadBlock);
+    std::size_t got = 0;
+    while (!aborted && (got = std::fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+        if (inBody) {
+            aborted = !deliver(response, sink, buffer.data(), got);
+            continue;
+        }
+        pending.append(buffer.data(), got);
+        // Consume complete header blocks until the final one
+        while (!inBody) {
+            auto end = pending.find("\r\n\r\n");
+            if (end == std::string::npos) break;
+            Response head;
+            std::size_t lineStart = 0;
+            while (lineStart < end) {
+                std::size_t lineEnd = pending.find("\r\n", lineStart);
+                std::string line = pending.substr(lineStart, lineEnd - lineStart);
+                if (lineStart == 0) head.status = parseStatusLine(line);
+                else addHeaderLine(head, line);
+                lineStart = lineEnd + 2;
+            }
+            pending.erase(0, end + 4);
+            bool interim = head.status >= 100 && head.status < 200;
+            bool followed = request.followRedirects && isRedirect(head.status) && head.header("Location");
+            if (interim || followed || head.status == 0) continue;
+            response.status = head.status;
+            response.headers = std::move(head.headers);
+            inBody = true;
+            aborted = !deliver(response, sink, pending.data(), pending.size());
+            pending.clear();
+        }
+    }
+    int rc = pclose(pipe);
+    if (!bodyFile.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(bodyFile, ec);
+    }
+    if (!aborted && (rc != 0 || response.status == 0)) {
+        response.error = "curl failed (exit code " + std::to_string(rc) + ")";
+    }
+    return response;
+}
+
+} // namespace
+
+const std::string* Response::header(const std::string& name) const {
+    for (const auto& [n, v] : headers) {
+        if (iequals(n, name)) return &v;
+    }
+    return nullptr;
+}
+
+// One socket (plus TLS session) to an origin, with data read ahead of the
+// current parse position
+struct Client::Connection {
+    std::string origin;
+    std::string pending;
+#ifdef REPOMAN_HTTP_NATIVE
+    int fd = -1;
+#endif
+#ifdef REPOMAN_HTTP_TLS
+    SSL* ssl = nullptr;
+#endif
+
+    ~Connection() {
+#ifdef REPOMAN_HTTP_TLS
+        if (ssl) SSL_free(ssl);
+#endif
+#ifdef REPOMAN_HTTP_NATIVE
+        if (fd >= 0) ::close(fd);
+#endif
+    }
+
+#ifdef REPOMAN_HTTP_NATIVE
+    bool open(const Url& url, int timeoutSeconds, std::string& error) {
+        origin = url.origin();
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* list = nullptr;
+        int rc = getaddrinfo(url.host.c_str(), std::to_string(url.port).c_str(), &hints, &list);
+        if (rc != 0) {
+            error = "cannot resolve " + url.host + ": " + gai_strerror(rc);
+            return false;
+        }
+        for (addrinfo* ai = list; ai && fd < 0; ai = ai->ai_next) {
+            fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd < 0) continue;
+            if (!connectWithTimeout(ai, timeoutSeconds)) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        freeaddrinfo(list);
+        if (fd < 0) {
+            error = "cannot connect to " + url.hostHeader();
+            return false;
+        }
+        timeval tv{};
+        tv.tv_sec = timeoutSeconds;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (url.scheme != "https") return true;
+#ifdef REPOMAN_HTTP_TLS
+        SSL_CTX* ctx = tlsContext();
+        ssl = ctx ? SSL_new(ctx) : nullptr;
+        if (!ssl) {
+            error = "TLS setup failed";
+            return false;
+        }
+        SSL_set_fd(ssl, fd);
+        SSL_set_tlsext_host_name(ssl, url.host.c_str());
+        SSL_set1_host(ssl, url.host.c_str());
+        if (SSL_connect(ssl) != 1) {
+            char text[256];
+            ERR_error_string_n(ERR_get_error(), text, sizeof(text));
+            error = "TLS handshake with " + url.host + " failed: " + text;
+            return false;
+        }
+        return true;
+#else
+        error = "built without TLS";
+        return false;
+#endif
+    }
+
+    bool connectWithTimeout(const addrinfo* ai, int timeoutSeconds) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int rc = ::connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc != 0 && errno == EINPROGRESS) {
+            pollfd p{fd, POLLOUT, 0};
+            if (::poll(&p, 1, timeoutSeconds * 1000) == 1) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                rc = err == 0 ? 0 : -1;
+            }
+        }
+        fcntl(fd, F_SETFL, flags);
+        return rc == 0;
+    }
+
+    bool writeAll(const std::string& data) {
+        std::size_t done = 0;
+        while (done < data.size()) {
+            long n;
+#ifdef REPOMAN_HTTP_TLS
+            if (ssl) n = SSL_write(ssl, data.data() + done, static_cast<int>(std::min<std::size_t>(data.size() - done, 1 << 30)));
+            else
+#endif
+            n = ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            done += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // Appends what the socket has to pending; false at end of stream or error
+    bool readMore() {
+        char buffer[kReadBlock];
+        long n;
+#ifdef REPOMAN_HTTP_TLS
+        if (ssl) n = SSL_read(ssl, buffer, sizeof(buffer));
+        else
+#endif
+        n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        pending.append(buffer, static_cast<std::size_t>(n));
+        return true;
+    }
+#else
+    bool open(const Url&, int, std::string& error) { error = "no native HTTP backend"; return false; }
+    bool writeAll(const std::string&) { return false; }
+    bool readMore() { return false; }
+#endif
+
+    bool readLine(std::string& line) {
+        std::size_t scanned = 0;
+        while (true) {
+            auto end = pending.find("\r\n", scanned);
+            if (end != std::string::npos) {
+                line = pending.substr(0, end);
+                pending.erase(0, end + 2);
+                return true;
+            }
+            if (pending.size() > kMaxHeaderLine) return false;
+            scanned = pending.empty() ? 0 : pending.size() - 1;
+            if (!readMore()) return false;
+        }
+    }
+
+    // Passes exactly size bytes on
+    bool readExactly(uint64_t size, Response& response, const BodySink& sink) {
+        while (size > 0) {
+            if (pending.empty() && !readMore()) {
+                response.error = "connection closed mid-body";
+                return false;
+            }
+            std::size_t take = static_cast<std::size_t>(std::min<uint64_t>(size, pending.size()));
+            if (!deliver(response, sink, pending.data(), take)) return false;
+            pending.erase(0, take);
+            size -= take;
+        }
+        return true;
+    }
+
+    // Status line and headers; interim 1xx responses are skipped.
+    // received tells whether the server sent anything at all.
+    bool readHead(Response& response, bool& http11, bool& received) {
+        received = !pending.empty();
+        std::string line;
+        do {
+            response.headers.clear();
+            if (!readLine(line)) {
+                received = received || !pending.empty();
+                response.error = "no response";
+                return false;
+            }
+            received = true;
+            response.status = parseStatusLine(line, &http11);
+            if (response.status == 0) {
+                response.error = "malformed status line";
+                return false;
+            }
+            while (true) {
+                if (!readLine(line)) {
+                    response.error = "truncated headers";
+                    return false;
+                }
+                if (line.empty()) break;
+                addHeaderLine(response, line);
+            }
+        } while (response.status >= 100 && response.status < 200);
+        return true;
+    }
+
+    // Body per Transfer-Encoding / Content-Length; reusable is false when the
+    // body ran to the end of the connection
+    bool readBody(const std::string& method, Response& response, const BodySink& sink, bool& reusable) {
+        if (!hasBody(method, response.status)) return true;
+        const std::string* te = response.header("Transfer-Encoding");
+        if (te && lower(*te).find("chunked") != std::string::npos) {
+            std::string line;
+            while (true) {
+                if (!readLine(line)) {
+                    response.error = "truncated chunked body";
+                    return false;
+                }
+                uint64_t size = std::strtoull(line.c_str(), nullptr, 16);
+                if (size == 0) break;
+                if (!readExactly(size, response, sink) || !readLine(line)) {
+                    if (response.error.empty()) response.error = "truncated chunked body";
+                    return false;
+                }
+            }
+            // Trailers up to the blank line
+            do {
+                if (!readLine(line)) {
+                    response.error = "truncated chunked body";
+                    return false;
+                }
+            } while (!line.empty());
+            return true;
+        }
+        if (const std::string* cl = response.header("Content-Length")) {
+            return readExactly(std::strtoull(cl->c_str(), nullptr, 10), response, sink);
+        }
+        reusable = false;
+        while (true) {
+            if (!pending.empty()) {
+                if (!deliver(response, sink, pending.data(), pending.size())) return false;
+                pending.clear();
+            }
+            if (!readMore()) return true;
+        }
+    }
+};
+
+Client::Client(std::string baseUrl) : base(std::move(baseUrl)) {
+    defaults.emplace_back("User-Agent", std::string(appinfo::kAppName) + "/" + appinfo::kAppVersion);
+}
+
+Client::~Client() = default;
+
+void Client::setBaseUrl(std::string url) {
+    std::lock_guard<std::mutex> lock(mu);
+    while (!url.empty() && url.back() == '/') url.pop_back();
+    base = std::move(url);
+}
+
+std::string Client::baseUrl() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return base;
+}
+
+void Client::setDefaultHeader(const std::string& name, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mu);
+    for (auto& h : defaults) {
+        if (iequals(h.first, name)) {
+            h.second = value;
+            return;
+        }
+    }
+    defaults.emplace_back(name, value);
+}
+
+void Client::setTimeout(int seconds) {
+    std::lock_guard<std::mutex> lock(mu);
+    timeoutSeconds = seconds > 0 ? seconds : 60;
+}
+
+std::string Client::resolve(const std::string& url) const {
+    if (url.find("://") != std::string::npos) return url;
+    std::lock_guard<std::mutex> lock(mu);
+    return base + (!url.empty() && url[0] == '/' ? url : "/" + url);
+}
+
+Headers Client::mergedHeaders(const Headers& headers) const {
+    Headers out = headers;
+    std::lock_guard<std::mutex> lock(mu);
+    for (const auto& d : defaults) {
+        bool overridden = std::any_of(headers.begin(), headers.end(), [&](const auto& h) { return iequals(h.first, d.first); });
+        if (!overridden) out.push_back(d);
+    }
+    return out;
+}
+
+std::unique_ptr<Client::Connection> Client::checkout(const std::string& origin, bool& reused) {
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = idle.find(origin);
+    if (it == idle.end() || it->second.empty()) {
+        reused = false;
+        return nullptr;
+    }
+    auto connection = std::move(it->second.back());
+    it->second.pop_back();
+    reused = true;
+    return connection;
+}
+
+void Client::checkin(std::unique_ptr<Connection> connection) {
+    if (!connection->pending.empty()) return; // unexpected extra bytes: not reusable
+    std::lock_guard<std::mutex> lock(mu);
+    auto& list = idle[connection->origin];
+    if (list.size() < kMaxIdlePerOrigin) list.push_back(std::move(connection));
+}
+
+Response Client::exchange(const Request& request, const BodySink& sink) {
+    Response response;
+    Url url;
+    if (!parseUrl(request.url, url)) {
+        response.error = "unsupported URL: " + request.url;
+        return response;
+    }
+    int timeout;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        timeout = timeoutSeconds;
+    }
+    std::string wire = serialize(request, url);
+    // A pooled connection may have been closed by the server meanwhile; if
+    // it fails before anything came back, the request goes out once more on
+    // a fresh connection
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        response = Response{};
+        bool reused = false;
+        std::unique_ptr<Connection> connection = checkout(url.origin(), reused);
+        if (!connection) {
+            connection = std::make_unique<Connection>();
+            if (!connection->open(url, timeout, response.error)) return response;
+        }
+        bool http11 = true;
+        bool received = false;
+        if (!connection->writeAll(wire)) {
+            if (reused) continue;
+            response.error = "send failed";
+            return response;
+        }
+        if (!connection->readHead(response, http11, received)) {
+            if (reused && !received) continue;
+            return response;
+        }
+        bool reusable = http11;
+        if (const std::string* c = response.header("Connection")) {
+            if (lower(*c).find("close") != std::string::npos) reusable = false;
+        }
+        // Redirect bodies are never interesting
+        const BodySink& target = isRedirect(response.status) && request.followRedirects ? BodySink() : sink;
+        if (!connection->readBody(request.method, response, target, reusable)) return response;
+        if (reusable) checkin(std::move(connection));
+        return response;
+    }
+    return response;
+}
+
+void Client::setCacheDir(std::string dir) {
+    std::lock_guard<std::mutex> lock(mu);
+    cacheDir = std::move(dir);
+}
+
+Response Client::send(const Request& request, const BodySink& sink) {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        dir = cacheDir;
+    }
+    if (dir.empty() || !request.useCache || request.method != "GET" || sink) return transfer(request, sink);
+
+    std::string url = resolve(request.url);
+    Headers headers = mergedHeaders(request.headers);
+    std::string path = cachePath(dir, url, headers);
+    Response stored;
+    bool have = loadCached(path, stored);
+    Request conditional = request;
+    if (have) {
+        bool preset = std::any_of(headers.begin(), headers.end(), [](const auto& h) {
+            return iequals(h.first, "If-None-Match") || iequals(h.first, "If-Modified-Since");
+        });
+        const std::string* etag = stored.header("ETag");
+        const std::string* modified = stored.header("Last-Modified");
+        if (!preset && etag) conditional.headers.emplace_back("If-None-Match", *etag);
+        if (!preset && modified) conditional.headers.emplace_back("If-Modified-Since", *modified);
+    }
+    Response response = transfer(conditional, sink);
+    if (have && response.error.empty() && response.status == 304) {
+        stored.fromCache = true;
+        return stored;
+    }
+    if (have && !response.error.empty()) {
+        logger::debug("http: " + response.error + ", using cached " + url);
+        stored.fromCache = true;
+        stored.stale = true;
+        return stored;
+    }
+    if (response.error.empty() && response.status == 200 && (response.header("ETag") || response.header("Last-Modified"))) {
+        storeCached(path, response);
+    }
+    return response;
+}
+
+Response Client::transfer(const Request& request, const BodySink& sink) {
+    Request current = request;
+    current.url = resolve(request.url);
+    current.headers = mergedHeaders(request.headers);
+    Url url;
+    if (!parseUrl(current.url, url)) {
+        Response response;
+        response.error = "unsupported URL: " + current.url;
+        return response;
+    }
+    if (!nativeAvailable(url.scheme)) {
+        int timeout;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            timeout = timeoutSeconds;
+        }
+        return curlSend(current, sink, timeout);
+    }
+    for (int hop = 0;; ++hop) {
+        Response response = exchange(current, sink);
+        Request next;
+        if (!response.error.empty() || !redirectRequest(current, response, next)) return response;
+        if (hop == kMaxRedirects) {
+            response.error = "too many redirects";
+            return response;
+        }
+        current = std::move(next);
+        // The next hop may need the other backend (e.g. https without TLS)
+        if (parseUrl(current.url, url) && !nativeAvailable(url.scheme)) return transfer(current, sink);
+    }
+}
+
+Response Client::get(const std::string& url, const Headers& headers, const BodySink& sink) {
+    Request request;
+    request.url = url;
+    request.headers = headers;
+    return send(request, sink);
+}
+
+Response Client::download(const std::string& url, const Headers& headers, const std::string& path) {
+    std::ofstream out(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        Response response;
+        response.error = "cannot create " + path;
+        return response;
+    }
+    Response response = get(url, headers, [&out](const char* data, std::size_t size) {
+        out.write(data, static_cast<std::streamsize>(size));
+        return static_cast<bool>(out);
+    });
+    out.close();
+    if (!out && response.error.empty()) response.error = "write failed: " + path;
+    if (!response.ok()) {
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::u8path(path), ec);
+    }
+    return response;
+}
+
+bool Client::getPages(const std::string& url, const Headers& headers, unsigned jobs,
+                      const PageFn& onPage, std::string& error) {
+    Response first = get(url, headers);
+    if (!first.ok()) {
+        error = failure(first);
+        return false;
+    }
+    std::string last = linkTarget(first, "last");
+    std::string next = linkTarget(first, "next");
+    onPage(1, first);
+
+    std::size_t at = pageParam(last);
+    int lastPage = at == std::string::npos ? 0 : std::atoi(last.c_str() + at);
+    if (lastPage > 1) {
+        std::atomic<bool> failed{false};
+        std::mutex errorMutex;
+        utils::parallelFor(static_cast<std::size_t>(lastPage - 1), jobs ? jobs : kDefaultPageFetches, [&](std::size_t k) {
+            if (failed.load()) return;
+            int page = static_cast<int>(k) + 2;
+            Response response = get(withPage(last, at, page), headers);
+            if (!response.ok()) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!failed.exchange(true)) error = "page " + std::to_string(page) + ": " + failure(response);
+                return;
+            }
+            onPage(page, response);
+        });
+        return !failed.load();
+    }
+    for (int page = 2; !next.empty(); ++page) {
+        Response response = get(next, headers);
+        if (!response.ok()) {
+            error = "page " + std::to_string(page) + ": " + failure(response);
+            return false;
+        }
+        next = linkTarget(response, "next");
+        onPage(page, response);
+    }
+    return true;
+}
+
+std::vector<Response> Client::sendPipelined(const std::vector<Request>& requests) {
+    std::vector<Response> responses(requests.size());
+    std::vector<char> done(requests.size(), 0);
+    std::vector<Request> resolved(requests.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        resolved[i] = requests[i];
+        resolved[i].url = resolve(requests[i].url);
+        resolved[i].headers = mergedHeaders(requests[i].headers);
+    }
+
+    // Only bodiless requests to the first request's origin are pipelined
+    Url first;
+    std::vector<std::size_t> batchable;
+    if (!resolved.empty() && parseUrl(resolved[0].url, first) && nativeAvailable(first.scheme)) {
+        for (std::size_t i = 0; i < resolved.size(); ++i) {
+            Url u;
+            if ((resolved[i].method == "GET" || resolved[i].method == "HEAD") && resolved[i].body.empty() &&
+                parseUrl(resolved[i].url, u) && u.origin() == first.origin()) {
+                batchable.push_back(i);
+            }
+        }
+    }
+    int timeout;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        timeout = timeoutSeconds;
+    }
+
+    // Bounded batches, so neither side blocks writing while the other does
+    for (std::size_t start = 0; start < batchable.size(); start += kPipelineBatch) {
+        std::size_t end = std::min(batchable.size(), start + kPipelineBatch);
+        bool reused = false;
+        std::unique_ptr<Connection> connection = checkout(first.origin(), reused);
+        std::string error;
+        if (!connection) {
+            connection = std::make_unique<Connection>();
+            if (!connection->open(first, timeout, error)) break;
+        }
+        std::string wire;
+        for (std::size_t k = start; k < end; ++k) {
+            Url u;
+            parseUrl(resolved[batchable[k]].url, u);
+            wire += serialize(resolved[batchable[k]], u);
+        }
+        if (!connection->writeAll(wire)) continue;
+        bool reusable = true;
+        for (std::size_t k = start; k < end && reusable; ++k) {
+            std::size_t i = batchable[k];
+            Response response;
+            bool http11 = true;
+            bool received = false;
+            if (!connection->readHead(response, http11, received)) break;
+            reusable = http11;
+            if (const std::string* c = response.header("Connection")) {
+                if (lower(*c).find("close") != std::string::npos) reusable = false;
+            }
+            if (!connection->readBody(resolved[i].method, response, nullptr, reusable)) break;
+            responses[i] = std::move(response);
+            done[i] = 1;
+        }
+        if (reusable) checkin(std::move(connection));
+    }
+
+    // Everything else, and redirects of pipelined requests, one at a time
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        Request next;
+        if (!done[i]) responses[i] = send(requests[i]);
+        else if (redirectRequest(resolved[i], responses[i], next)) responses[i] = send(next);
+    }
+    return responses;
+}
+
+bool nativeAvailable(const std::string& scheme) {
+#ifdef REPOMAN_HTTP_NATIVE
+    if (scheme == "http") return true;
+#endif
+#ifdef REPOMAN_HTTP_TLS
+    if (scheme == "https") return tlsContext() != nullptr;
+#endif
+    (void)scheme;
+    return false;
+}
+
+std::string encodePath(const std::string& path) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(path.size());
+    for (unsigned char c : path) {
+        if (std::isalnum(c) || c == '/' || c == '-' || c == '_' || c == '.' || c == '~') {
+            out.push_back(static_cast<char>(c));
+        } else {
+            out.push_back('%');
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 15]);
+        }
+    }
+    return out;
+}
+
+namespace {
+std::mutex gitHubMutex;
+std::string gitHubApi = "https://api.github.com";
+std::string gitHubRaw = "https://raw.githubusercontent.com";
+}
+
+void setGitHubUrls(const std::string& apiUrl, const std::string& rawUrl) {
+    {
+        std::lock_guard<std::mutex> lock(gitHubMutex);
+        if (!apiUrl.empty()) gitHubApi = apiUrl;
+        if (!rawUrl.empty()) gitHubRaw = rawUrl;
+        while (!gitHubApi.empty() && gitHubApi.back() == '/') gitHubApi.pop_back();
+        while (!gitHubRaw.empty() && gitHubRaw.back() == '/') gitHubRaw.pop_back();
+    }
+    gitHub().setBaseUrl(gitHubApiUrl());
+}
+
+std::string gitHubApiUrl() {
+    std::lock_guard<std::mutex> lock(gitHubMutex);
+    return gitHubApi;
+}
+
+std::string gitHubRawUrl() {
+    std::lock_guard<std::mutex> lock(gitHubMutex);
+    return gitHubRaw;
+}
+
+Client& gitHub() {
+    static Client client(gitHubApiUrl());
+    return client;
+}
+
+Headers gitHubHeaders(const std::string& token, const std::string& accept) {
+    Headers headers;
+    if (!token.empty()) headers.emplace_back("Authorization", "token " + token);
+    if (!accept.empty()) headers.emplace_back("Accept", accept);
+    return headers;
+}
+
+} // namespace http
+} // namespace utils
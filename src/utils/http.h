@@ -0,0 +1,138 @@
+#ifndef UTILS_HTTP_H
+#define UTILS_HTTP_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <cstddef>
+#include <functional>
+
+namespace utils {
+namespace http {
+
+using Headers = std::vector<std::pair<std::string, std::string>>;
+
+struct Request {
+    std::string method = "GET";
+    std::string url;              // absolute, or relative to the client's base URL
+    Headers headers;
+    std::string body;
+    bool followRedirects = true;  // Authorization is dropped when the host changes
+    bool useCache = true;         // a GET may be revalidated against the response cache
+};
+
+struct Response {
+    int status = 0;               // 0 if no response arrived, see error
+    Headers headers;
+    std::string body;             // empty when a BodySink took the data
+    std::string error;            // transport failure; empty on any HTTP status
+    bool fromCache = false;       // body served from the response cache (304 or stale)
+    bool stale = false;           // the request failed; this is the last stored copy
+
+    bool ok() const { return error.empty() && status >= 200 && status < 300; }
+    // First header with this name (case-insensitive); nullptr if absent
+    const std::string* header(const std::string& name) const;
+};
+
+// Receives the body of the final response as it arrives; return false to
+// abort the transfer (the response then carries an error)
+using BodySink = std::function<bool(const char* data, std::size_t size)>;
+
+// Receives one page of a paginated listing (1-based page number)
+using PageFn = std::function<void(int page, const Response& response)>;
+
+// HTTP/1.1 client that keeps connections alive and reuses them for later
+// requests to the same scheme, host and port. Safe to share between
+// threads: each request checks a connection out of the pool. Where the
+// native backend is unavailable (see nativeAvailable) every request runs
+// the curl tool instead, with the same results minus connection reuse.
+class Client {
+public:
+    explicit Client(std::string baseUrl = "");
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    void setBaseUrl(std::string url);
+    std::string baseUrl() const;
+    // Header sent with every request unless the request sets it too
+    void setDefaultHeader(const std::string& name, const std::string& value);
+    // Per socket read/write; a stalled transfer fails after this long
+    void setTimeout(int seconds);
+    // Response cache for GETs without a BodySink (empty = off). A 200 that
+    // carries an ETag or Last-Modified is stored under dir, keyed by URL,
+    // Accept and Authorization (hashed, the token is never written out).
+    // Later GETs for the same key send If-None-Match / If-Modified-Since
+    // and a 304 is answered from disk; if the request fails outright the
+    // stored copy is returned marked stale.
+    void setCacheDir(std::string dir);
+
+    Response send(const Request& request, const BodySink& sink = nullptr);
+    Response get(const std::string& url, const Headers& headers = {}, const BodySink& sink = nullptr);
+    // GET straight into a file; the file is removed unless the status is 2xx
+    Response download(const std::string& url, const Headers& headers, const std::string& path);
+
+    // GETs every page of a list that paginates through the Link header (as
+    // the GitHub API does). The first page is fetched alone; if it links a
+    // rel="last" page, pages 2..last are then fetched `jobs` at a time
+    // (0 = 8) and each is handed to onPage as it arrives, so pages may come
+    // out of order and from several threads at once. Without rel="last"
+    // the rel="next" links are followed one by one. Returns false and sets
+    // error if a page fails; pages already delivered stay delivered.
+    bool getPages(const std::string& url, const Headers& headers, unsigned jobs,
+                  const PageFn& onPage, std::string& error);
+
+    // Writes the requests back to back on one connection and then reads the
+    // responses in order (HTTP/1.1 pipelining), saving a round trip per
+    // request. Requests for other origins, redirects and anything left when
+    // the server closes the connection early are sent one by one.
+    std::vector<Response> sendPipelined(const std::vector<Request>& requests);
+
+    // Idle connections kept per origin
+    static constexpr std::size_t kMaxIdlePerOrigin = 8;
+
+private:
+    struct Connection;
+
+    mutable std::mutex mu;
+    std::string base;
+    Headers defaults;
+    int timeoutSeconds = 60;
+    std::string cacheDir;
+    std::map<std::string, std::vector<std::unique_ptr<Connection>>> idle;
+
+    std::unique_ptr<Connection> checkout(const std::string& origin, bool& reused);
+    void checkin(std::unique_ptr<Connection> connection);
+    std::string resolve(const std::string& url) const;
+    Headers mergedHeaders(const Headers& headers) const;
+    // One request/response exchange, no redirects
+    Response exchange(const Request& request, const BodySink& sink);
+    // send() without the response cache
+    Response transfer(const Request& request, const BodySink& sink);
+};
+
+// True if requests to this scheme ("http"/"https") are handled in-process
+bool nativeAvailable(const std::string& scheme);
+
+// Percent-encodes a path, keeping '/' and unreserved characters
+std::string encodePath(const std::string& path);
+
+// GitHub endpoints, process-wide (settings.github_api_url and
+// settings.github_raw_url in config.json), so a local stand-in server can
+// replace api.github.com and raw.githubusercontent.com
+void setGitHubUrls(const std::string& apiUrl, const std::string& rawUrl);
+std::string gitHubApiUrl();
+std::string gitHubRawUrl();
+// Shared client whose base URL is gitHubApiUrl()
+Client& gitHub();
+// Authorization and Accept headers for a GitHub call
+Headers gitHubHeaders(const std::string& token, const std::string& accept = "application/vnd.github+json");
+
+} // namespace http
+} // namespace utils
+
+#endif // UTILS_HTTP_H
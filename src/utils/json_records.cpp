@@ -0,0 +1,80 @@
+#include "json_records.h"
+
+#include <nlohmann/json.hpp>
+
+namespace utils {
+
+namespace {
+
+using json = nlohmann::json;
+
+// Depth 1 is the outer array, depth 2 a record; anything deeper is skipped
+class RecordSax : public nlohmann::json_sax<json> {
+public:
+    explicit RecordSax(RecordVisitor& visitor) : visitor(visitor) {}
+
+    bool null() override { return scalar(); }
+    bool boolean(bool value) override {
+        if (inRecord()) visitor.boolField(field, value);
+        return scalar();
+    }
+    bool number_integer(number_integer_t value) override {
+        if (inRecord()) visitor.integerField(field, value);
+        return scalar();
+    }
+    bool number_unsigned(number_unsigned_t value) override {
+        if (inRecord()) visitor.integerField(field, static_cast<int64_t>(value));
+        return scalar();
+    }
+    bool number_float(number_float_t, const string_t&) override { return scalar(); }
+    bool string(string_t& value) override {
+        if (inRecord()) visitor.stringField(field, value);
+        return scalar();
+    }
+    bool binary(binary_t&) override { return scalar(); }
+
+    bool start_object(std::size_t) override {
+        if (depth == 0) return false;  // top level must be an array
+        if (depth == 1) visitor.beginRecord();
+        ++depth;
+        return true;
+    }
+    bool key(string_t& name) override {
+        if (depth == 2) field = std::move(name);
+        return true;
+    }
+    bool end_object() override {
+        if (--depth == 1) visitor.endRecord();
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        if (depth == 1) return false;  // elements must be objects, not arrays
+        ++depth;
+        return true;
+    }
+    bool end_array() override {
+        --depth;
+        return true;
+    }
+    bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+        return false;
+    }
+
+private:
+    RecordVisitor& visitor;
+    int depth = 0;
+    std::string field;
+
+    bool inRecord() const { return depth == 2; }
+    // Records are objects; a bare value in the outer array is malformed
+    bool scalar() const { return depth >= 2; }
+};
+
+} // namespace
+
+bool parseRecordArray(const std::string& text, RecordVisitor& visitor) {
+    RecordSax sax(visitor);
+    return json::sax_parse(text, &sax);
+}
+
+} // namespace utils
@@ -0,0 +1,30 @@
+#ifndef UTILS_JSON_RECORDS_H
+#define UTILS_JSON_RECORDS_H
+
+#include <string>
+#include <cstdint>
+
+namespace utils {
+
+// Receives the records of a JSON array of objects (a GitHub list endpoint,
+// say) one field at a time. Only top-level fields of each record arrive;
+// nested objects and arrays are skipped whole, so owner.name never shows
+// up as name. Values may be moved from.
+class RecordVisitor {
+public:
+    virtual ~RecordVisitor() = default;
+    virtual void beginRecord() {}
+    virtual void stringField(const std::string& key, std::string& value) { (void)key; (void)value; }
+    virtual void boolField(const std::string& key, bool value) { (void)key; (void)value; }
+    virtual void integerField(const std::string& key, int64_t value) { (void)key; (void)value; }
+    virtual void endRecord() {}
+};
+
+// Walks text in one pass with nlohmann's SAX parser, without building a
+// DOM. Returns false if it is not valid JSON or not an array of objects;
+// records completed before the error have been delivered.
+bool parseRecordArray(const std::string& text, RecordVisitor& visitor);
+
+} // namespace utils
+
+#endif // UTILS_JSON_RECORDS_H
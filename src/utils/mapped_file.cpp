@@ -0,0 +1,244 @@
+#include "mapped_file.h"
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#endif
+
+namespace utils {
+
+#ifndef _WIN32
+namespace {
+
+// Reading a page of a mapping that lies past the end of a file that has since
+// been truncated raises SIGBUS. Every live mapping holds a slot here; the
+// handler maps zero pages over the lost part of a mapping it finds and flags
+// the slot, so the read completes and MappedFile::truncated() reports it.
+struct GuardSlot {
+    std::atomic<bool> used{false};
+    std::atomic<uintptr_t> begin{0};
+    std::atomic<uintptr_t> end{0};
+    std::atomic<bool> hit{false};
+};
+
+constexpr int kGuardSlots = 256;
+GuardSlot guardSlots[kGuardSlots];
+uintptr_t pageMask = 0;
+struct sigaction previousBusAction;
+std::once_flag guardInstalled;
+
+void onBusError(int sig, siginfo_t* info, void* context) {
+    uintptr_t addr = reinterpret_cast<uintptr_t>(info->si_addr);
+    for (GuardSlot& slot : guardSlots) {
+        uintptr_t begin = slot.begin.load(std::memory_order_acquire);
+        uintptr_t end = slot.end.load(std::memory_order_acquire);
+        if (begin == 0 || addr < begin || addr >= end) continue;
+        uintptr_t page = addr & pageMask;
+        void* zeros = ::mmap(reinterpret_cast<void*>(page), end - page, PROT_READ,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        if (zeros == MAP_FAILED) break;
+        slot.hit.store(true, std::memory_order_release);
+        return; // the faulting read runs again and sees zeros
+    }
+    // Not one of ours: behave as if this handler were not installed
+    if ((previousBusAction.sa_flags & SA_SIGINFO) && previousBusAction.sa_sigaction) {
+        previousBusAction.sa_sigaction(sig, info, context);
+    } else if (previousBusAction.sa_handler != SIG_DFL && previousBusAction.sa_handler != SIG_IGN) {
+        previousBusAction.sa_handler(sig);
+    } else {
+        ::signal(SIGBUS, SIG_DFL); // the fault repeats and terminates as usual
+    }
+}
+
+void installGuard() {
+    pageMask = ~static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE) - 1);
+    struct sigaction action{};
+    action.sa_sigaction = onBusError;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGBUS, &action, &previousBusAction);
+}
+
+// Slot index for the mapping, -1 if all are taken
+int registerMapping(const unsigned char* ptr, std::size_t length) {
+    std::call_once(guardInstalled, installGuard);
+    for (int i = 0; i < kGuardSlots; ++i) {
+        bool expected = false;
+        if (!guardSlots[i].used.compare_exchange_strong(expected, true)) continue;
+        guardSlots[i].hit.store(false);
+        guardSlots[i].end.store(reinterpret_cast<uintptr_t>(ptr) + length, std::memory_order_release);
+        guardSlots[i].begin.store(reinterpret_cast<uintptr_t>(ptr), std::memory_order_release);
+        return i;
+    }
+    return -1;
+}
+
+void unregisterMapping(int slot) {
+    guardSlots[slot].begin.store(0, std::memory_order_release);
+    guardSlots[slot].end.store(0, std::memory_order_release);
+    guardSlots[slot].used.store(false, std::memory_order_release);
+}
+
+} // namespace
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    moveFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        moveFrom(other);
+    }
+    return *this;
+}
+
+void MappedFile::moveFrom(MappedFile& other) noexcept {
+    ptr = other.ptr;
+    length = other.length;
+    opened = other.opened;
+    mapped = other.mapped;
+#ifdef _WIN32
+    fileHandle = other.fileHandle;
+    mapHandle = other.mapHandle;
+    other.fileHandle = nullptr;
+    other.mapHandle = nullptr;
+#else
+    guardSlot = other.guardSlot;
+    other.guardSlot = -1;
+#endif
+    // Moving a vector keeps its heap block, so ptr stays valid
+    buffer = std::move(other.buffer);
+    other.ptr = nullptr;
+    other.length = 0;
+    other.opened = false;
+    other.mapped = false;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fh != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER sz;
+        if (GetFileSizeEx(fh, &sz)) {
+            length = static_cast<std::size_t>(sz.QuadPart);
+            if (length == 0) {
+                CloseHandle(fh);
+                opened = true;
+                return true;
+            }
+            HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mh) {
+                void* view = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+                if (view) {
+                    fileHandle = fh;
+                    mapHandle = mh;
+                    ptr = static_cast<const unsigned char*>(view);
+                    mapped = true;
+                    opened = true;
+                    return true;
+                }
+                CloseHandle(mh);
+            }
+        }
+        CloseHandle(fh);
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            length = static_cast<std::size_t>(st.st_size);
+            if (length == 0) {
+                ::close(fd);
+                opened = true;
+                return true;
+            }
+            void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd); // the mapping keeps its own reference
+            if (view != MAP_FAILED) {
+                guardSlot = registerMapping(static_cast<const unsigned char*>(view), length);
+                if (guardSlot >= 0) {
+                    ptr = static_cast<const unsigned char*>(view);
+                    mapped = true;
+                    opened = true;
+                    return true;
+                }
+                // Unguarded, a truncation would kill the process; read instead
+                munmap(view, length);
+            }
+        } else {
+            ::close(fd);
+        }
+    }
+#endif
+    // Fallback: plain read into memory
+    length = 0;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    in.seekg(0, std::ios::end);
+    std::streamoff end = in.tellg();
+    if (end < 0) return false;
+    in.seekg(0, std::ios::beg);
+    buffer.resize(static_cast<std::size_t>(end));
+    if (!buffer.empty() && !in.read(reinterpret_cast<char*>(buffer.data()), end)) {
+        buffer.clear();
+        return false;
+    }
+    ptr = buffer.empty() ? nullptr : buffer.data();
+    length = buffer.size();
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    // Before munmap, so the handler never claims a range reused elsewhere
+    if (guardSlot >= 0) unregisterMapping(guardSlot);
+    guardSlot = -1;
+#endif
+    if (mapped && ptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(ptr);
+        if (mapHandle) CloseHandle(static_cast<HANDLE>(mapHandle));
+        if (fileHandle) CloseHandle(static_cast<HANDLE>(fileHandle));
+        mapHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(ptr), length);
+#endif
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+    ptr = nullptr;
+    length = 0;
+    opened = false;
+    mapped = false;
+}
+
+bool MappedFile::truncated() const {
+#ifdef _WIN32
+    return false;
+#else
+    return guardSlot >= 0 && guardSlots[guardSlot].hit.load(std::memory_order_acquire);
+#endif
+}
+
+} // namespace utils
@@ -0,0 +1,57 @@
+#ifndef UTILS_MAPPED_FILE_H
+#define UTILS_MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace utils {
+
+// Read-only view of a whole file.
+// - On Linux: mmap(2) of the file
+// - On Windows: CreateFileMapping/MapViewOfFile
+// If mapping fails, the file is read into an owned buffer instead so callers
+// always get a contiguous byte range.
+// On POSIX a file that shrinks while mapped does not crash the process: the
+// pages past its new end read as zeros and truncated() turns true, so check
+// it once done with data() and treat the read as failed. On Windows the file
+// is opened without write sharing and cannot change while mapped.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false if the file cannot be opened or read.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const unsigned char* data() const { return ptr; }
+    std::size_t size() const { return length; }
+    // True if the file shrank under the mapping since open()
+    bool truncated() const;
+
+private:
+    const unsigned char* ptr = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+    bool mapped = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mapHandle = nullptr;
+#else
+    int guardSlot = -1; // registration with the SIGBUS handler
+#endif
+    std::vector<unsigned char> buffer; // used when mapping is unavailable
+
+    void moveFrom(MappedFile& other) noexcept;
+};
+
+} // namespace utils
+
+#endif // UTILS_MAPPED_FILE_H
@@ -0,0 +1,38 @@
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+unsigned defaultJobs() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+void parallelFor(std::size_t count, unsigned jobs, const std::function<void(std::size_t)>& fn) {
+    if (count == 0) return;
+    if (jobs == 0) jobs = defaultJobs();
+    std::size_t workers = std::min<std::size_t>(jobs, count);
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) fn(i);
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    try {
+        for (std::size_t t = 1; t < workers; ++t) pool.emplace_back(worker);
+    } catch (...) {
+        // Could not spawn more threads; run with what we have
+    }
+    worker();
+    for (auto& th : pool) th.join();
+}
+
+} // namespace utils
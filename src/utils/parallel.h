@@ -0,0 +1,17 @@
+#ifndef UTILS_PARALLEL_H
+#define UTILS_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+namespace utils {
+    // Number of workers used when callers pass jobs = 0 (one per hardware thread)
+    unsigned defaultJobs();
+
+    // Runs fn(i) for every i in [0, count) on at most `jobs` threads
+    // (0 = defaultJobs()). Indices are claimed in increasing order; the call
+    // returns once all of them have finished. fn must not throw.
+    void parallelFor(std::size_t count, unsigned jobs, const std::function<void(std::size_t)>& fn);
+}
+
+#endif // UTILS_PARALLEL_H
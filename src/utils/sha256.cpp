@@ -0,0 +1,516 @@
+#include "sha256.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <picosha2.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define REPOMAN_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace utils {
+namespace sha256 {
+
+namespace {
+
+const uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+alignas(16) const uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+void storeBigEndian(uint8_t* out, uint32_t v) {
+    out[0] = static_cast<uint8_t>(v >> 24);
+    out[1] = static_cast<uint8_t>(v >> 16);
+    out[2] = static_cast<uint8_t>(v >> 8);
+    out[3] = static_cast<uint8_t>(v);
+}
+
+// Builds the final one or two padded blocks for a message of `total` bytes
+// whose last `rest` (< 64) bytes are `tail`. Returns the number of blocks.
+std::size_t padTail(uint8_t* blocks, const uint8_t* tail, std::size_t rest, uint64_t total) {
+    std::size_t count = rest < 56 ? 1 : 2;
+    std::memset(blocks, 0, count * 64);
+    if (rest) std::memcpy(blocks, tail, rest);
+    blocks[rest] = 0x80;
+    uint64_t bits = total * 8;
+    for (int i = 0; i < 8; ++i) blocks[count * 64 - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    return count;
+}
+
+void compressScalar(uint32_t* state, const uint8_t* blocks, std::size_t count) {
+    picosha2::word_t digest[8];
+    for (int i = 0; i < 8; ++i) digest[i] = state[i];
+    for (std::size_t b = 0; b < count; ++b) {
+        picosha2::detail::hash256_block(digest, blocks + b * 64, blocks + (b + 1) * 64);
+    }
+    for (int i = 0; i < 8; ++i) state[i] = static_cast<uint32_t>(digest[i]);
+}
+
+#ifdef REPOMAN_SHA256_X86
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool sha = false;
+    bool avx2 = false;
+};
+
+CpuFeatures detectCpu() {
+    CpuFeatures f;
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return f;
+    f.sse2 = (edx >> 26) & 1;
+    bool ssse3 = (ecx >> 9) & 1;
+    bool sse41 = (ecx >> 19) & 1;
+    bool osxsave = (ecx >> 27) & 1;
+    bool avx = (ecx >> 28) & 1;
+    bool ymmEnabled = false;
+    if (osxsave && avx) {
+        // The OS must save YMM registers on context switch (XCR0 bits 1 and 2)
+        uint32_t xcr0lo = 0, xcr0hi = 0;
+        __asm__ volatile("xgetbv" : "=a"(xcr0lo), "=d"(xcr0hi) : "c"(0));
+        ymmEnabled = (xcr0lo & 0x6) == 0x6;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return f;
+    f.sha = ssse3 && sse41 && ((ebx >> 29) & 1);
+    f.avx2 = ymmEnabled && ((ebx >> 5) & 1);
+    return f;
+}
+
+const CpuFeatures& cpu() {
+    static const CpuFeatures features = detectCpu();
+    return features;
+}
+
+__attribute__((target("sha,sse4.1,ssse3")))
+void compressShaNi(uint32_t* state, const uint8_t* blocks, std::size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions want the state as ABEF/CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (std::size_t b = 0; b < count; ++b, blocks += 64) {
+        const __m128i abefSave = state0;
+        const __m128i cdghSave = state1;
+        __m128i w[4];
+
+        // 16 groups of 4 rounds; w[] holds the next four schedule vectors
+#pragma GCC unroll 16
+        for (int g = 0; g < 16; ++g) {
+            if (g < 4) {
+                w[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + g * 16)), byteSwap);
+            }
+            __m128i msg = _mm_add_epi32(w[g & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(kRoundConstants + g * 4)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if (g >= 3 && g <= 14) {
+                __m128i& next = w[(g + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(w[g & 3], w[(g - 1) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, w[g & 3]);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if (g >= 1 && g <= 12) {
+                w[(g - 1) & 3] = _mm_sha256msg1_epu32(w[(g - 1) & 3], w[g & 3]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+#define AVX2_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+
+// One block for each of 8 streams. state[i] holds word i of every stream
+// (lane j = stream j); blocks[j] points at 64 bytes for stream j.
+__attribute__((target("avx2")))
+void compressAvx2x8(uint32_t (*state)[8], const uint8_t* const* blocks) {
+    const __m256i byteSwap = _mm256_set_epi8(
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+        12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    // Transpose the 8x16 word block matrix so w[t] holds word t of every stream
+    __m256i w[16];
+    for (int half = 0; half < 2; ++half) {
+        __m256i r[8];
+        for (int j = 0; j < 8; ++j) {
+            r[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[j] + half * 32));
+        }
+        __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]), t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+        __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]), t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+        __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]), t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+        __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]), t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+        __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+        __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+        __m256i u4 = _mm256_unpacklo_epi64(t4, t6), u5 = _mm256_unpackhi_epi64(t4, t6);
+        __m256i u6 = _mm256_unpacklo_epi64(t5, t7), u7 = _mm256_unpackhi_epi64(t5, t7);
+        __m256i* o = w + half * 8;
+        o[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+        o[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+        o[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+        o[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+        o[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+        o[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+        o[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+        o[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+        for (int k = 0; k < 8; ++k) o[k] = _mm256_shuffle_epi8(o[k], byteSwap);
+    }
+
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i) v[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+    __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 64; ++t) {
+        __m256i wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w15, 7), AVX2_ROTR(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(w2, 17), AVX2_ROTR(w2, 19)), _mm256_srli_epi32(w2, 10));
+            wt = _mm256_add_epi32(_mm256_add_epi32(w[t & 15], s0), _mm256_add_epi32(w[(t - 7) & 15], s1));
+            w[t & 15] = wt;
+        }
+        __m256i S1 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(e, 6), AVX2_ROTR(e, 11)), AVX2_ROTR(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, S1),
+                                      _mm256_add_epi32(_mm256_add_epi32(ch, wt), _mm256_set1_epi32(static_cast<int>(kRoundConstants[t]))));
+        __m256i S0 = _mm256_xor_si256(_mm256_xor_si256(AVX2_ROTR(a, 2), AVX2_ROTR(a, 13)), AVX2_ROTR(a, 22));
+        __m256i maj = _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_xor_si256(a, b)));
+        __m256i t2 = _mm256_add_epi32(S0, maj);
+        h = g; g = f; f = e;
+        e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a;
+        a = _mm256_add_epi32(t1, t2);
+    }
+
+    __m256i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), _mm256_add_epi32(v[i], out[i]));
+    }
+}
+
+#undef AVX2_ROTR
+
+#define SSE2_ROTR(x, n) _mm_or_si128(_mm_srli_epi32((x), (n)), _mm_slli_epi32((x), 32 - (n)))
+
+__attribute__((target("sse2")))
+inline __m128i byteSwapSse2(__m128i x) {
+    // No pshufb in SSE2: swap bytes within 16-bit halves, then swap the halves
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, 0xB1);
+    return _mm_shufflehi_epi16(x, 0xB1);
+}
+
+// Same as compressAvx2x8 for 4 streams; only lanes 0-3 of state[i] are used
+__attribute__((target("sse2")))
+void compressSse2x4(uint32_t (*state)[8], const uint8_t* const* blocks) {
+    __m128i w[16];
+    for (int q = 0; q < 4; ++q) {
+        __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[0] + q * 16));
+        __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[1] + q * 16));
+        __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[2] + q * 16));
+        __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[3] + q * 16));
+        __m128i t0 = _mm_unpacklo_epi32(r0, r1), t1 = _mm_unpackhi_epi32(r0, r1);
+        __m128i t2 = _mm_unpacklo_epi32(r2, r3), t3 = _mm_unpackhi_epi32(r2, r3);
+        w[q * 4 + 0] = byteSwapSse2(_mm_unpacklo_epi64(t0, t2));
+        w[q * 4 + 1] = byteSwapSse2(_mm_unpackhi_epi64(t0, t2));
+        w[q * 4 + 2] = byteSwapSse2(_mm_unpacklo_epi64(t1, t3));
+        w[q * 4 + 3] = byteSwapSse2(_mm_unpackhi_epi64(t1, t3));
+    }
+
+    __m128i v[8];
+    for (int i = 0; i < 8; ++i) v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state[i]));
+    __m128i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 64; ++t) {
+        __m128i wt;
+        if (t < 16) {
+            wt = w[t];
+        } else {
+            __m128i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+            __m128i s0 = _mm_xor_si128(_mm_xor_si128(SSE2_ROTR(w15, 7), SSE2_ROTR(w15, 18)), _mm_srli_epi32(w15, 3));
+            __m128i s1 = _mm_xor_si128(_mm_xor_si128(SSE2_ROTR(w2, 17), SSE2_ROTR(w2, 19)), _mm_srli_epi32(w2, 10));
+            wt = _mm_add_epi32(_mm_add_epi32(w[t & 15], s0), _mm_add_epi32(w[(t - 7) & 15], s1));
+            w[t & 15] = wt;
+        }
+        __m128i S1 = _mm_xor_si128(_mm_xor_si128(SSE2_ROTR(e, 6), SSE2_ROTR(e, 11)), SSE2_ROTR(e, 25));
+        __m128i ch = _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g));
+        __m128i t1 = _mm_add_epi32(_mm_add_epi32(h, S1),
+                                   _mm_add_epi32(_mm_add_epi32(ch, wt), _mm_set1_epi32(static_cast<int>(kRoundConstants[t]))));
+        __m128i S0 = _mm_xor_si128(_mm_xor_si128(SSE2_ROTR(a, 2), SSE2_ROTR(a, 13)), SSE2_ROTR(a, 22));
+        __m128i maj = _mm_xor_si128(_mm_and_si128(a, b), _mm_and_si128(c, _mm_xor_si128(a, b)));
+        __m128i t2 = _mm_add_epi32(S0, maj);
+        h = g; g = f; f = e;
+        e = _mm_add_epi32(d, t1);
+        d = c; c = b; b = a;
+        a = _mm_add_epi32(t1, t2);
+    }
+
+    __m128i out[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; ++i) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(state[i]), _mm_add_epi32(v[i], out[i]));
+    }
+}
+
+#undef SSE2_ROTR
+
+using LaneKernel = void (*)(uint32_t (*state)[8], const uint8_t* const* blocks);
+
+// Runs `count` messages through a lane kernel of width `lanes`, refilling
+// each lane with the next message as soon as its current one is done
+void scheduleLanes(LaneKernel kernel, std::size_t lanes, const uint8_t* const* data,
+                   const std::size_t* sizes, std::size_t count, Digest* out) {
+    struct Lane {
+        std::size_t message = 0;
+        std::size_t step = 0;
+        std::size_t fullBlocks = 0;
+        std::size_t totalBlocks = 0;
+        bool active = false;
+        uint8_t tail[128];
+    };
+    Lane lane[8];
+    alignas(32) uint32_t state[8][8];
+    alignas(32) static const uint8_t idleBlock[64] = {};
+    std::size_t next = 0;
+
+    auto start = [&](std::size_t j) {
+        Lane& l = lane[j];
+        l.active = next < count;
+        if (!l.active) return;
+        l.message = next++;
+        std::size_t size = sizes[l.message];
+        l.step = 0;
+        l.fullBlocks = size / 64;
+        l.totalBlocks = l.fullBlocks + padTail(l.tail, data[l.message] + l.fullBlocks * 64, size % 64, size);
+        for (int i = 0; i < 8; ++i) state[i][j] = kInitialState[i];
+    };
+    for (std::size_t j = 0; j < lanes; ++j) start(j);
+
+    const uint8_t* blocks[8];
+    std::size_t active = std::min(lanes, count);
+    while (active) {
+        for (std::size_t j = 0; j < lanes; ++j) {
+            const Lane& l = lane[j];
+            if (!l.active) blocks[j] = idleBlock;
+            else if (l.step < l.fullBlocks) blocks[j] = data[l.message] + l.step * 64;
+            else blocks[j] = l.tail + (l.step - l.fullBlocks) * 64;
+        }
+        kernel(state, blocks);
+        for (std::size_t j = 0; j < lanes; ++j) {
+            Lane& l = lane[j];
+            if (!l.active || ++l.step != l.totalBlocks) continue;
+            uint32_t words[8];
+            for (int i = 0; i < 8; ++i) words[i] = state[i][j];
+            for (int i = 0; i < 8; ++i) storeBigEndian(out[l.message].data() + i * 4, words[i]);
+            start(j);
+            if (!l.active) --active;
+        }
+    }
+}
+
+#endif // REPOMAN_SHA256_X86
+
+bool supported(Backend backend) {
+    switch (backend) {
+    case Backend::Scalar: return true;
+#ifdef REPOMAN_SHA256_X86
+    case Backend::ShaNi: return cpu().sha;
+    case Backend::Sse2: return cpu().sse2;
+    case Backend::Avx2: return cpu().avx2;
+#endif
+    default: return false;
+    }
+}
+
+Digest stateToDigest(const uint32_t* state) {
+    Digest d;
+    for (int i = 0; i < 8; ++i) storeBigEndian(d.data() + i * 4, state[i]);
+    return d;
+}
+
+} // namespace
+
+const char* backendName(Backend backend) {
+    switch (backend) {
+    case Backend::Scalar: return "scalar";
+    case Backend::ShaNi: return "sha-ni";
+    case Backend::Sse2: return "sse2-x4";
+    case Backend::Avx2: return "avx2-x8";
+    }
+    return "unknown";
+}
+
+std::vector<Backend> availableBackends() {
+    std::vector<Backend> out;
+    for (Backend b : {Backend::Scalar, Backend::ShaNi, Backend::Sse2, Backend::Avx2}) {
+        if (supported(b)) out.push_back(b);
+    }
+    return out;
+}
+
+Backend activeBackend() {
+    static const Backend active = supported(Backend::ShaNi) ? Backend::ShaNi : Backend::Scalar;
+    return active;
+}
+
+Backend multiBufferBackend() {
+    static const Backend backend = supported(Backend::ShaNi) ? Backend::ShaNi
+                                 : supported(Backend::Avx2)  ? Backend::Avx2
+                                 : supported(Backend::Sse2)  ? Backend::Sse2
+                                                             : Backend::Scalar;
+    return backend;
+}
+
+Hasher::Hasher() : Hasher(activeBackend()) {}
+
+Hasher::Hasher(Backend backend) : compress(compressScalar) {
+#ifdef REPOMAN_SHA256_X86
+    if (backend == Backend::Avx2 || backend == Backend::Sse2) backend = activeBackend();
+    if (backend == Backend::ShaNi && supported(Backend::ShaNi)) compress = compressShaNi;
+#else
+    (void)backend;
+#endif
+    std::memcpy(state, kInitialState, sizeof(state));
+}
+
+void Hasher::update(const void* data, std::size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    total += size;
+    if (buffered) {
+        std::size_t take = std::min(size, sizeof(buffer) - buffered);
+        std::memcpy(buffer + buffered, p, take);
+        buffered += take;
+        p += take;
+        size -= take;
+        if (buffered < sizeof(buffer)) return;
+        compress(state, buffer, 1);
+        buffered = 0;
+    }
+    if (size >= 64) {
+        std::size_t blocks = size / 64;
+        compress(state, p, blocks);
+        p += blocks * 64;
+        size -= blocks * 64;
+    }
+    if (size) {
+        std::memcpy(buffer, p, size);
+        buffered = size;
+    }
+}
+
+Digest Hasher::finish() {
+    uint8_t tail[128];
+    std::size_t blocks = padTail(tail, buffer, buffered, total);
+    compress(state, tail, blocks);
+    buffered = 0;
+    return stateToDigest(state);
+}
+
+void digestMany(const uint8_t* const* data, const std::size_t* sizes, std::size_t count, Digest* out) {
+    digestMany(multiBufferBackend(), data, sizes, count, out);
+}
+
+void digestMany(Backend backend, const uint8_t* const* data, const std::size_t* sizes, std::size_t count, Digest* out) {
+#ifdef REPOMAN_SHA256_X86
+    if (count > 1 && backend == Backend::Avx2 && supported(Backend::Avx2)) {
+        scheduleLanes(compressAvx2x8, 8, data, sizes, count, out);
+        return;
+    }
+    if (count > 1 && backend == Backend::Sse2 && supported(Backend::Sse2)) {
+        scheduleLanes(compressSse2x4, 4, data, sizes, count, out);
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < count; ++i) {
+        Hasher h(backend);
+        h.update(data[i], sizes[i]);
+        out[i] = h.finish();
+    }
+}
+
+std::string toHex(const Digest& digest) {
+    static const char* hex = "0123456789abcdef";
+    std::string s(digest.size() * 2, '0');
+    for (std::size_t i = 0; i < digest.size(); ++i) {
+        s[i * 2] = hex[digest[i] >> 4];
+        s[i * 2 + 1] = hex[digest[i] & 0xF];
+    }
+    return s;
+}
+
+std::vector<BenchResult> benchmark(std::size_t bytes) {
+    // xorshift fill; content does not matter, only that it is not all zeros
+    std::vector<uint8_t> data(bytes);
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (auto& byte : data) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        byte = static_cast<uint8_t>(x);
+    }
+
+    // Lane backends hash 8 equal slices of the same data
+    const std::size_t slice = bytes / 8;
+    const uint8_t* slices[8];
+    std::size_t sliceSizes[8];
+    for (std::size_t j = 0; j < 8; ++j) {
+        slices[j] = data.data() + j * slice;
+        sliceSizes[j] = slice;
+    }
+
+    Digest reference{};
+    Digest referenceSlices[8];
+    std::vector<BenchResult> results;
+    for (Backend backend : availableBackends()) {
+        BenchResult r{backend};
+        auto start = std::chrono::steady_clock::now();
+        Digest whole{};
+        Digest lanes[8];
+        bool multiBuffer = backend == Backend::Sse2 || backend == Backend::Avx2;
+        if (multiBuffer) {
+            digestMany(backend, slices, sliceSizes, 8, lanes);
+        } else {
+            Hasher h(backend);
+            h.update(data.data(), data.size());
+            whole = h.finish();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        r.megabytesPerSecond = seconds > 0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+
+        if (backend == Backend::Scalar) {
+            reference = whole;
+            for (std::size_t j = 0; j < 8; ++j) {
+                Hasher h(Backend::Scalar);
+                h.update(slices[j], sliceSizes[j]);
+                referenceSlices[j] = h.finish();
+            }
+        } else if (multiBuffer) {
+            r.matchesScalar = std::equal(lanes, lanes + 8, referenceSlices);
+        } else {
+            r.matchesScalar = whole == reference;
+        }
+        results.push_back(r);
+    }
+    return results;
+}
+
+} // namespace sha256
+} // namespace utils
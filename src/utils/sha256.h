@@ -0,0 +1,72 @@
+#ifndef UTILS_SHA256_H
+#define UTILS_SHA256_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+namespace sha256 {
+
+using Digest = std::array<uint8_t, 32>;
+
+// SHA-256 implementations. All produce identical digests; they differ only in
+// speed and in the CPU features they need.
+// - Scalar: picosha2 block function, works everywhere
+// - ShaNi:  x86 SHA extensions, one stream
+// - Sse2:   four independent streams in the lanes of 128-bit registers
+// - Avx2:   eight independent streams in the lanes of 256-bit registers
+enum class Backend { Scalar, ShaNi, Sse2, Avx2 };
+
+const char* backendName(Backend backend);
+// Backends this CPU can run, Scalar first
+std::vector<Backend> availableBackends();
+// Fastest single-stream backend, picked once from CPUID
+Backend activeBackend();
+// Backend digestMany() uses by default. A single SHA-NI stream outruns the
+// SIMD lane kernels, so those are only picked on CPUs without it.
+Backend multiBufferBackend();
+
+// Incremental hash of one stream
+class Hasher {
+public:
+    Hasher();                         // uses activeBackend()
+    explicit Hasher(Backend backend); // lane backends map to the best single-stream backend
+
+    void update(const void* data, std::size_t size);
+    Digest finish();
+
+private:
+    using CompressFn = void (*)(uint32_t* state, const uint8_t* blocks, std::size_t count);
+
+    CompressFn compress;
+    uint32_t state[8];
+    uint8_t buffer[64];
+    std::size_t buffered = 0;
+    uint64_t total = 0;
+};
+
+// Hashes `count` independent in-memory messages; out must hold `count`
+// digests. With a lane backend every lane runs its own message and is
+// refilled with the next one as soon as it finishes, so messages of mixed
+// sizes keep all lanes busy. Single-stream backends hash them in turn.
+void digestMany(const uint8_t* const* data, const std::size_t* sizes, std::size_t count, Digest* out);
+void digestMany(Backend backend, const uint8_t* const* data, const std::size_t* sizes, std::size_t count, Digest* out);
+
+std::string toHex(const Digest& digest);
+
+struct BenchResult {
+    Backend backend;
+    double megabytesPerSecond = 0.0;
+    bool matchesScalar = true; // digest identical to the Scalar backend
+};
+
+// Hashes `bytes` of pseudo-random data with every available backend
+std::vector<BenchResult> benchmark(std::size_t bytes);
+
+} // namespace sha256
+} // namespace utils
+
+#endif // UTILS_SHA256_H
@@ -1,18 +1,497 @@
 #include "zip.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "path.h"
 #include "../system/logger.h"
 
 #include <filesystem>
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
 
-// We will use a fallback approach for now:
+#ifdef REPOMAN_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+// Archives are extracted in-process when built with zlib (REPOMAN_HAVE_ZLIB).
+// Otherwise, and for entries zlib cannot handle, we fall back to:
 // - On Windows: PowerShell Expand-Archive
-// - On Unix: unzip
-// Later, this can be replaced by libzip when bundling is added to the build.
+// - On Unix: python zipfile, then unzip
 
 namespace ziputil {
 
+namespace {
+
+constexpr uint32_t kEndSignature = 0x06054b50;
+constexpr uint32_t kEnd64LocatorSignature = 0x07064b50;
+constexpr uint32_t kEnd64Signature = 0x06064b50;
+constexpr uint32_t kCentralSignature = 0x02014b50;
+constexpr std::size_t kEndSize = 22;
+constexpr std::size_t kEnd64LocatorSize = 20;
+constexpr std::size_t kEnd64Size = 56;
+constexpr std::size_t kCentralSize = 46;
+constexpr uint16_t kZip64ExtraId = 0x0001;
+
+// Little-endian field readers; callers check bounds
+uint16_t le16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+uint32_t le32(const unsigned char* p) { return static_cast<uint32_t>(le16(p)) | (static_cast<uint32_t>(le16(p + 2)) << 16); }
+uint64_t le64(const unsigned char* p) { return static_cast<uint64_t>(le32(p)) | (static_cast<uint64_t>(le32(p + 4)) << 32); }
+
+// Replaces saturated 32-bit fields with their values from the ZIP64 extra field
+void applyZip64Extra(const unsigned char* extra, std::size_t length, Entry& e,
+                     bool needUncompressed, bool needCompressed, bool needOffset) {
+    std::size_t pos = 0;
+    while (pos + 4 <= length) {
+        uint16_t id = le16(extra + pos);
+        uint16_t size = le16(extra + pos + 2);
+        const unsigned char* field = extra + pos + 4;
+        if (pos + 4 + size > length) return;
+        if (id == kZip64ExtraId) {
+            std::size_t at = 0;
+            if (needUncompressed && at + 8 <= size) { e.uncompressedSize = le64(field + at); at += 8; }
+            if (needCompressed && at + 8 <= size) { e.compressedSize = le64(field + at); at += 8; }
+            if (needOffset && at + 8 <= size) { e.localHeaderOffset = le64(field + at); }
+            return;
+        }
+        pos += 4 + size;
+    }
+}
+
+#ifdef REPOMAN_HAVE_ZLIB
+
+constexpr uint32_t kLocalSignature = 0x04034b50;
+constexpr std::size_t kLocalSize = 30;
+constexpr std::size_t kOutputBlock = 1 << 20;
+constexpr uint64_t kMaxZlibChunk = 1u << 30; // zlib lengths are 32-bit
+
+enum class NativeResult { Ok, Unsupported, Failed };
+
+uLong updateCrc(uLong crc, const unsigned char* data, std::size_t size) {
+    while (size > 0) {
+        uInt piece = static_cast<uInt>(std::min<uint64_t>(size, kMaxZlibChunk));
+        crc = crc32(crc, data, piece);
+        data += piece;
+        size -= piece;
+    }
+    return crc;
+}
+
+// Writes the data of one entry to destPath, inflating deflated entries, and
+// checks the result against the recorded size and CRC32
+bool writeEntry(const unsigned char* archive, std::size_t archiveSize, const Entry& e,
+                const std::string& destPath, uint64_t& written, std::string& error) {
+    written = 0;
+    const uint64_t offset = e.localHeaderOffset;
+    if (offset > archiveSize || archiveSize - offset < kLocalSize || le32(archive + offset) != kLocalSignature) {
+        error = "bad local header: " + e.name;
+        return false;
+    }
+    // Name and extra lengths in the local header may differ from the central record
+    const uint64_t dataOffset = offset + kLocalSize + le16(archive + offset + 26) + le16(archive + offset + 28);
+    if (dataOffset > archiveSize || archiveSize - dataOffset < e.compressedSize) {
+        error = "entry data out of range: " + e.name;
+        return false;
+    }
+    const unsigned char* in = archive + dataOffset;
+
+    std::ofstream out(destPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        error = "cannot create " + destPath;
+        return false;
+    }
+    uLong crc = crc32(0L, Z_NULL, 0);
+    auto emit = [&](const unsigned char* data, std::size_t size) {
+        crc = updateCrc(crc, data, size);
+        written += size;
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+    };
+
+    bool complete = true;
+    if (e.method == 0) {
+        for (uint64_t pos = 0; pos < e.compressedSize; pos += kOutputBlock) {
+            emit(in + pos, static_cast<std::size_t>(std::min<uint64_t>(kOutputBlock, e.compressedSize - pos)));
+        }
+    } else {
+        z_stream zs{};
+        if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+            error = "inflateInit failed";
+            return false;
+        }
+        std::vector<unsigned char> buffer(kOutputBlock);
+        uint64_t remaining = e.compressedSize;
+        const unsigned char* next = in;
+        int rc = Z_OK;
+        do {
+            if (zs.avail_in == 0 && remaining > 0) {
+                uInt take = static_cast<uInt>(std::min<uint64_t>(remaining, kMaxZlibChunk));
+                zs.next_in = const_cast<Bytef*>(next);
+                zs.avail_in = take;
+                next += take;
+                remaining -= take;
+            }
+            zs.next_out = buffer.data();
+            zs.avail_out = static_cast<uInt>(buffer.size());
+            rc = inflate(&zs, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END) break;
+            emit(buffer.data(), buffer.size() - zs.avail_out);
+            // Never write more than the directory promised
+            if (written > e.uncompressedSize) break;
+        } while (rc != Z_STREAM_END);
+        inflateEnd(&zs);
+        complete = rc == Z_STREAM_END;
+    }
+    out.close();
+
+    if (!complete || written != e.uncompressedSize) {
+        error = "corrupt data: " + e.name;
+    } else if (crc != e.crc32) {
+        error = "CRC mismatch: " + e.name;
+    } else if (!out) {
+        error = "write failed: " + destPath;
+    } else {
+        return true;
+    }
+    std::error_code ec;
+    std::filesystem::remove(destPath, ec);
+    return false;
+}
+
+NativeResult extractNative(const std::string& zipPath, const std::string& destDir, unsigned jobs,
+                           const ProgressFn& progress, std::string& errorMessage) {
+    utils::MappedFile file;
+    if (!file.open(zipPath)) {
+        errorMessage = "cannot open " + zipPath;
+        return NativeResult::Failed;
+    }
+    std::vector<Entry> entries;
+    if (!readCentralDirectory(file.data(), file.size(), entries, errorMessage)) return NativeResult::Failed;
+
+    // Later records with the same name win, as with other unzip tools
+    std::map<std::string, std::size_t> files;
+    std::set<std::string> dirs;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const Entry& e = entries[i];
+        if ((e.flags & 0x1) || (e.method != 0 && e.method != 8)) {
+            errorMessage = "unsupported entry (encrypted or method " + std::to_string(e.method) + "): " + e.name;
+            return NativeResult::Unsupported;
+        }
+        std::string rel = e.isDirectory() ? e.name.substr(0, e.name.size() - 1) : e.name;
+        if (rel.empty()) continue;
+        if (!utils::isSafeRelativePath(rel)) {
+            errorMessage = "unsafe path in archive: " + e.name;
+            return NativeResult::Failed;
+        }
+        if (e.isDirectory()) {
+            dirs.insert(rel);
+        } else {
+            files[rel] = i;
+            auto slash = rel.rfind('/');
+            if (slash != std::string::npos) dirs.insert(rel.substr(0, slash));
+        }
+    }
+    for (const auto& d : dirs) {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(destDir) / std::filesystem::u8path(d), ec);
+        if (ec) {
+            errorMessage = "cannot create directory " + d + ": " + ec.message();
+            return NativeResult::Failed;
+        }
+    }
+
+    std::vector<std::pair<std::string, std::size_t>> work(files.begin(), files.end());
+    // Biggest entries first so one large file does not finish last on its own
+    std::stable_sort(work.begin(), work.end(), [&entries](const auto& a, const auto& b) {
+        return entries[a.second].uncompressedSize > entries[b.second].uncompressedSize;
+    });
+    std::mutex mu;
+    std::atomic<bool> failed{false};
+    std::size_t done = 0;
+    uint64_t bytes = 0;
+    utils::parallelFor(work.size(), jobs, [&](std::size_t k) {
+        if (failed.load()) return;
+        const Entry& e = entries[work[k].second];
+        std::string dest = (std::filesystem::path(destDir) / std::filesystem::u8path(work[k].first)).u8string();
+        std::string error;
+        uint64_t written = 0;
+        bool ok = writeEntry(file.data(), file.size(), e, dest, written, error);
+        if (ok && file.truncated()) {
+            // Part of what was written may be zeros standing in for lost pages
+            ok = false;
+            error = zipPath + " shrank while being extracted";
+            std::error_code ec;
+            std::filesystem::remove(std::filesystem::u8path(dest), ec);
+        }
+        std::lock_guard<std::mutex> lock(mu);
+        if (!ok) {
+            if (!failed.exchange(true)) errorMessage = error;
+            return;
+        }
+        ++done;
+        bytes += written;
+        if (progress) progress(done, work.size(), bytes);
+    });
+    return failed.load() ? NativeResult::Failed : NativeResult::Ok;
+}
+
+constexpr uint32_t kDescriptorSignature = 0x08074b50;
+constexpr std::size_t kInputBlock = 1 << 18;
+
+// Read-ahead window over a SourceFn
+class InputBuffer {
+public:
+    explicit InputBuffer(const SourceFn& source) : source(source), buffer(kInputBlock) {}
+
+    // Makes at least n bytes available; false if the stream ends first
+    bool want(std::size_t n) {
+        if (len - pos >= n) return true;
+        std::copy(buffer.begin() + pos, buffer.begin() + len, buffer.begin());
+        len -= pos;
+        pos = 0;
+        if (buffer.size() < n) buffer.resize(n);
+        while (len < n && !eof) read();
+        return len >= n;
+    }
+    // Bytes available now, reading more only when none are left
+    std::size_t fill() {
+        if (pos == len) {
+            pos = len = 0;
+            if (!eof) read();
+        }
+        return len - pos;
+    }
+    const unsigned char* peek() const { return buffer.data() + pos; }
+    void skip(std::size_t n) {
+        pos += n;
+        consumed += n;
+    }
+    void drain() {
+        while (fill() > 0) skip(len - pos);
+    }
+    uint64_t offset() const { return consumed; }
+
+private:
+    const SourceFn& source;
+    std::vector<unsigned char> buffer;
+    std::size_t pos = 0;
+    std::size_t len = 0;
+    uint64_t consumed = 0;
+    bool eof = false;
+
+    void read() {
+        std::size_t got = source(buffer.data() + len, buffer.size() - len);
+        if (got == 0) eof = true;
+        len += got;
+    }
+};
+
+// Streams one entry's data to the sink; on return the input sits after the
+// data (and descriptor), and e holds the sizes and CRC that were checked
+bool streamEntry(InputBuffer& in, Entry& e, bool zip64, StreamSink& sink, std::string& errorMessage) {
+    const bool descriptor = (e.flags & 0x8) != 0;
+    uLong crc = crc32(0L, Z_NULL, 0);
+    uint64_t compressed = 0;
+    uint64_t written = 0;
+    auto emit = [&](const unsigned char* data, std::size_t size) {
+        crc = updateCrc(crc, data, size);
+        written += size;
+        return size == 0 || sink.entryData(data, size);
+    };
+
+    if (e.method == 0) {
+        while (compressed < e.compressedSize) {
+            std::size_t avail = in.fill();
+            if (avail == 0) {
+                errorMessage = "archive truncated in " + e.name;
+                return false;
+            }
+            std::size_t take = static_cast<std::size_t>(std::min<uint64_t>(avail, e.compressedSize - compressed));
+            if (!emit(in.peek(), take)) {
+                errorMessage = "stopped at " + e.name;
+                return false;
+            }
+            in.skip(take);
+            compressed += take;
+        }
+    } else {
+        z_stream zs{};
+        if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+            errorMessage = "inflateInit failed";
+            return false;
+        }
+        std::vector<unsigned char> out(kOutputBlock);
+        int rc = Z_OK;
+        bool ok = true;
+        while (rc != Z_STREAM_END) {
+            std::size_t avail = in.fill();
+            if (avail == 0) {
+                errorMessage = "archive truncated in " + e.name;
+                ok = false;
+                break;
+            }
+            uInt given = static_cast<uInt>(std::min<uint64_t>(avail, kMaxZlibChunk));
+            zs.next_in = const_cast<Bytef*>(in.peek());
+            zs.avail_in = given;
+            zs.next_out = out.data();
+            zs.avail_out = static_cast<uInt>(out.size());
+            rc = inflate(&zs, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END) {
+                errorMessage = "corrupt data: " + e.name;
+                ok = false;
+                break;
+            }
+            in.skip(given - zs.avail_in);
+            compressed += given - zs.avail_in;
+            if (!emit(out.data(), out.size() - zs.avail_out)) {
+                errorMessage = "stopped at " + e.name;
+                ok = false;
+                break;
+            }
+        }
+        inflateEnd(&zs);
+        if (!ok) return false;
+    }
+
+    if (descriptor) {
+        // Optional signature, then CRC and sizes (64-bit for ZIP64 entries)
+        if (in.want(4) && le32(in.peek()) == kDescriptorSignature) in.skip(4);
+        std::size_t size = zip64 ? 20 : 12;
+        if (!in.want(size)) {
+            errorMessage = "archive truncated in " + e.name;
+            return false;
+        }
+        const unsigned char* d = in.peek();
+        e.crc32 = le32(d);
+        e.compressedSize = zip64 ? le64(d + 4) : le32(d + 4);
+        e.uncompressedSize = zip64 ? le64(d + 12) : le32(d + 8);
+        in.skip(size);
+    }
+    if (compressed != e.compressedSize || written != e.uncompressedSize) {
+        errorMessage = "size mismatch: " + e.name;
+        return false;
+    }
+    if (crc != e.crc32) {
+        errorMessage = "CRC mismatch: " + e.name;
+        return false;
+    }
+    return true;
+}
+
+#endif // REPOMAN_HAVE_ZLIB
+
+} // namespace
+
+bool nativeExtractionAvailable() {
+#ifdef REPOMAN_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool readCentralDirectory(const unsigned char* data, std::size_t size,
+                          std::vector<Entry>& entries, std::string& errorMessage) {
+    entries.clear();
+    if (size < kEndSize) {
+        errorMessage = "not a zip archive (too small)";
+        return false;
+    }
+    // The end record sits before a comment of at most 64 KiB; scan backwards
+    std::size_t endPos = std::string::npos;
+    std::size_t lowest = size > kEndSize + 0xFFFF ? size - kEndSize - 0xFFFF : 0;
+    for (std::size_t pos = size - kEndSize + 1; pos-- > lowest;) {
+        if (le32(data + pos) == kEndSignature && pos + kEndSize + le16(data + pos + 20) <= size) {
+            endPos = pos;
+            break;
+        }
+    }
+    if (endPos == std::string::npos) {
+        errorMessage = "end of central directory not found";
+        return false;
+    }
+
+    const unsigned char* end = data + endPos;
+    uint64_t count = le16(end + 10);
+    uint64_t dirSize = le32(end + 12);
+    uint64_t dirOffset = le32(end + 16);
+    if (count == 0xFFFF || dirSize == 0xFFFFFFFF || dirOffset == 0xFFFFFFFF) {
+        // ZIP64: the locator right before the end record points at the real values
+        if (endPos < kEnd64LocatorSize || le32(data + endPos - kEnd64LocatorSize) != kEnd64LocatorSignature) {
+            errorMessage = "zip64 end locator missing";
+            return false;
+        }
+        uint64_t end64 = le64(data + endPos - kEnd64LocatorSize + 8);
+        if (end64 > size || size - end64 < kEnd64Size || le32(data + end64) != kEnd64Signature) {
+            errorMessage = "zip64 end record missing";
+            return false;
+        }
+        count = le64(data + end64 + 32);
+        dirSize = le64(data + end64 + 40);
+        dirOffset = le64(data + end64 + 48);
+    }
+    if (dirOffset > size || dirSize > size - dirOffset) {
+        errorMessage = "central directory out of range";
+        return false;
+    }
+
+    // count comes from the file; bound the reservation by what can fit
+    entries.reserve(static_cast<std::size_t>(std::min<uint64_t>(count, dirSize / kCentralSize)));
+    const unsigned char* p = data + dirOffset;
+    const unsigned char* dirEnd = p + dirSize;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (static_cast<std::size_t>(dirEnd - p) < kCentralSize || le32(p) != kCentralSignature) {
+            errorMessage = "corrupt central directory record " + std::to_string(i);
+            return false;
+        }
+        uint16_t nameLen = le16(p + 28);
+        uint16_t extraLen = le16(p + 30);
+        uint16_t commentLen = le16(p + 32);
+        std::size_t recordSize = kCentralSize + nameLen + extraLen + commentLen;
+        if (static_cast<std::size_t>(dirEnd - p) < recordSize) {
+            errorMessage = "central directory record " + std::to_string(i) + " runs past the end";
+            return false;
+        }
+        Entry e;
+        e.flags = le16(p + 8);
+        e.method = le16(p + 10);
+        e.crc32 = le32(p + 16);
+        e.compressedSize = le32(p + 20);
+        e.uncompressedSize = le32(p + 24);
+        e.localHeaderOffset = le32(p + 42);
+        e.name.assign(reinterpret_cast<const char*>(p + kCentralSize), nameLen);
+        std::replace(e.name.begin(), e.name.end(), '\\', '/');
+        bool needUncompressed = e.uncompressedSize == 0xFFFFFFFF;
+        bool needCompressed = e.compressedSize == 0xFFFFFFFF;
+        bool needOffset = e.localHeaderOffset == 0xFFFFFFFF;
+        if (needUncompressed || needCompressed || needOffset) {
+            applyZip64Extra(p + kCentralSize + nameLen, extraLen, e, needUncompressed, needCompressed, needOffset);
+        }
+        entries.push_back(std::move(e));
+        p += recordSize;
+    }
+    return true;
+}
+
+bool listArchive(const std::string& zipPath, std::vector<Entry>& entries,
+                 std::string& errorMessage) {
+    utils::MappedFile file;
+    if (!file.open(zipPath)) {
+        errorMessage = "cannot open " + zipPath;
+        return false;
+    }
+    bool ok = readCentralDirectory(file.data(), file.size(), entries, errorMessage);
+    if (file.truncated()) {
+        errorMessage = zipPath + " shrank while being read";
+        return false;
+    }
+    return ok;
+}
+
 static bool runCommand(const std::string& cmd, std::string& errorMessage) {
     int rc = std::system(cmd.c_str());
     if (rc != 0) {
@@ -24,7 +503,9 @@ static bool runCommand(const std::string& cmd, std::string& errorMessage) {
 
 bool extractArchive(const std::string& zipPath,
                     const std::string& destDir,
-                    std::string& errorMessage) {
+                    std::string& errorMessage,
+                    unsigned jobs,
+                    const ProgressFn& progress) {
     try {
         std::filesystem::create_directories(destDir);
     } catch (const std::exception& e) {
@@ -32,6 +513,20 @@ bool extractArchive(const std::string& zipPath,
         return false;
     }
 
+#ifdef REPOMAN_HAVE_ZLIB
+    switch (extractNative(zipPath, destDir, jobs, progress, errorMessage)) {
+        case NativeResult::Ok: return true;
+        case NativeResult::Failed: return false;
+        case NativeResult::Unsupported:
+            logger::debug("extractArchive: " + errorMessage + "; using external tools");
+            errorMessage.clear();
+            break;
+    }
+#else
+    (void)jobs;
+    (void)progress;
+#endif
+
 #ifdef _WIN32
     auto escapeSingleQuotes = [](const std::string& s) {
         std::string out; out.reserve(s.size());
@@ -60,6 +555,84 @@ bool extractArchive(const std::string& zipPath,
 #endif
 }
 
+bool streamArchive(const SourceFn& source, StreamSink& sink, std::string& errorMessage) {
+#ifdef REPOMAN_HAVE_ZLIB
+    InputBuffer in(source);
+    while (true) {
+        if (!in.want(4)) {
+            errorMessage = in.offset() == 0 && in.fill() == 0 ? "empty archive stream" : "archive truncated";
+            return false;
+        }
+        uint32_t signature = le32(in.peek());
+        if (signature == kCentralSignature || signature == kEndSignature || signature == kEnd64Signature) {
+            in.drain();
+            return true;
+        }
+        if (signature != kLocalSignature || !in.want(kLocalSize)) {
+            errorMessage = "bad local header at offset " + std::to_string(in.offset());
+            return false;
+        }
+        const unsigned char* h = in.peek();
+        const uint16_t nameLen = le16(h + 26);
+        const uint16_t extraLen = le16(h + 28);
+        Entry e;
+        e.localHeaderOffset = in.offset();
+        e.flags = le16(h + 6);
+        e.method = le16(h + 8);
+        e.crc32 = le32(h + 14);
+        e.compressedSize = le32(h + 18);
+        e.uncompressedSize = le32(h + 22);
+        if (!in.want(kLocalSize + nameLen + extraLen)) {
+            errorMessage = "archive truncated in a local header";
+            return false;
+        }
+        h = in.peek();
+        e.name.assign(reinterpret_cast<const char*>(h + kLocalSize), nameLen);
+        std::replace(e.name.begin(), e.name.end(), '\\', '/');
+
+        // A ZIP64 extra field in a local header holds both sizes; its presence
+        // also makes the data descriptor use 64-bit sizes
+        const unsigned char* extra = h + kLocalSize + nameLen;
+        bool zip64 = false;
+        for (std::size_t pos = 0; pos + 4 <= extraLen;) {
+            uint16_t size = le16(extra + pos + 2);
+            if (pos + 4 + size > extraLen) break;
+            if (le16(extra + pos) == kZip64ExtraId) {
+                zip64 = true;
+                applyZip64Extra(extra + pos, 4u + size, e, e.uncompressedSize == 0xFFFFFFFF,
+                                e.compressedSize == 0xFFFFFFFF, false);
+                break;
+            }
+            pos += 4 + size;
+        }
+        in.skip(kLocalSize + nameLen + extraLen);
+
+        if ((e.flags & 0x1) || (e.method != 0 && e.method != 8)) {
+            errorMessage = "unsupported entry (encrypted or method " + std::to_string(e.method) + "): " + e.name;
+            return false;
+        }
+        if (e.method == 0 && (e.flags & 0x8)) {
+            errorMessage = "stored entry without a recorded size: " + e.name;
+            return false;
+        }
+        if (!sink.beginEntry(e)) {
+            errorMessage = "stopped at " + e.name;
+            return false;
+        }
+        if (!streamEntry(in, e, zip64, sink, errorMessage)) return false;
+        if (!sink.endEntry(e)) {
+            errorMessage = "stopped at " + e.name;
+            return false;
+        }
+    }
+#else
+    (void)source;
+    (void)sink;
+    errorMessage = "built without zlib";
+    return false;
+#endif
+}
+
 }
 
 
@@ -2,14 +2,80 @@
 #define UTIL_ZIP_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
 
 namespace ziputil {
 
+// One central directory record
+struct Entry {
+    std::string name;             // path inside the archive, '/' separated
+    uint64_t compressedSize = 0;
+    uint64_t uncompressedSize = 0;
+    uint64_t localHeaderOffset = 0;
+    uint32_t crc32 = 0;
+    uint16_t method = 0;          // 0 = stored, 8 = deflate
+    uint16_t flags = 0;           // general purpose bit flag
+
+    bool isDirectory() const { return !name.empty() && name.back() == '/'; }
+};
+
+// Parses the central directory of an in-memory archive (ZIP64 included)
+// without touching entry data. Returns false and sets errorMessage if the
+// end record is missing or a record runs past the end of the data.
+bool readCentralDirectory(const unsigned char* data, std::size_t size,
+                          std::vector<Entry>& entries, std::string& errorMessage);
+
+// Maps the archive and lists its entries
+bool listArchive(const std::string& zipPath, std::vector<Entry>& entries,
+                 std::string& errorMessage);
+
+// Reports extraction progress: entries finished so far out of total, and
+// bytes written. Called from worker threads, one call at a time.
+using ProgressFn = std::function<void(std::size_t done, std::size_t total, uint64_t bytes)>;
+
+// True when extractArchive runs in-process (built with zlib) instead of
+// handing the archive to python/unzip/PowerShell
+bool nativeExtractionAvailable();
+
 // Extract a .zip archive into destDir.
 // Returns true on success; on failure returns false and sets errorMessage.
+// Natively, entries (stored or deflated, ZIP64 included) are inflated on up
+// to `jobs` threads (0 = one per core) and checked against their CRC32.
+// Archives with other compression methods or encryption fall back to the
+// external tools, which report no progress.
 bool extractArchive(const std::string& zipPath,
                     const std::string& destDir,
-                    std::string& errorMessage);
+                    std::string& errorMessage,
+                    unsigned jobs = 0,
+                    const ProgressFn& progress = nullptr);
+
+// Pulls the next bytes of a stream into buffer; returns how many were
+// stored, 0 at the end of the stream
+using SourceFn = std::function<std::size_t(unsigned char* buffer, std::size_t capacity)>;
+
+// Receives the entries of a streamed archive in archive order
+class StreamSink {
+public:
+    virtual ~StreamSink() = default;
+    // Start of an entry. Sizes and CRC are 0 when the archive records them
+    // after the data (general purpose flag bit 3). Return false to stop.
+    virtual bool beginEntry(const Entry& e) = 0;
+    // Next piece of the entry's uncompressed data
+    virtual bool entryData(const unsigned char* data, std::size_t size) = 0;
+    // The entry is complete and its data matched the CRC32; e carries the
+    // final sizes. Not called for entries that failed.
+    virtual bool endEntry(const Entry& e) = 0;
+};
+
+// Reads an archive front to back through its local headers, so it can be
+// applied while it is still downloading. Stored and deflated entries are
+// supported, ZIP64 included; stored entries must record their size up
+// front. Stops at the central directory, draining the rest of the source.
+// Needs zlib: without it (see nativeExtractionAvailable) returns false.
+bool streamArchive(const SourceFn& source, StreamSink& sink, std::string& errorMessage);
 
 }
 